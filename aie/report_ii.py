@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+# Reports the initiation interval (II) the AIE compiler reached on the software-pipelined loops of every tile, to
+# see the effect of the unroll, accumulators and loop_range options of the generator (see
+# src/template_generator/kernel.cfg). It scans the logs and listings the compiler leaves for each tile in
+# Work/aie/<column>_<row>/ after 'make aie_compile' (hw target: the x86 simulator does not schedule the code).
+# The wording of these reports changes between releases, so any line with 'II = <n>' (or 'II: <n>') is taken, and
+# attributed to the last source location ('"file", line <n>') seen before it in the same file.
+# Usage: report_ii.py [work_dir] [--max <ii>]   (exits with 1 if a loop is above <ii>)
+
+import os, re, sys
+
+location_re = re.compile(r'"([^"]+)",\s*line\s+(\d+)')
+ii_re       = re.compile(r'\bII\s*[=:]\s*(\d+)')
+
+
+def scan(work_dir):
+    """Return the (tile, location, ii) of every pipelined loop reported under work_dir/aie."""
+    aie_dir = os.path.join(work_dir, 'aie')
+    found = set()
+    if not os.path.isdir(aie_dir):
+        return found
+    for tile in sorted(os.listdir(aie_dir)):
+        if not re.fullmatch(r'\d+_\d+', tile):
+            continue
+        for root, _, files in os.walk(os.path.join(aie_dir, tile)):
+            for name in sorted(files):
+                if not name.endswith(('.log', '.lst')):
+                    continue
+                location = '?'
+                with open(os.path.join(root, name), errors='replace') as f:
+                    for line in f:
+                        m = location_re.search(line)
+                        if m:
+                            location = f'{os.path.basename(m.group(1))}:{m.group(2)}'
+                        m = ii_re.search(line)
+                        if m:
+                            found.add((tile, location, int(m.group(1))))
+    return found
+
+
+if __name__ == '__main__':
+    args = sys.argv[1:]
+    max_ii = None
+    if '--max' in args:
+        i = args.index('--max')
+        try:
+            max_ii = int(args[i + 1])
+        except (IndexError, ValueError):
+            print("ERROR: --max needs an integer", file=sys.stderr)
+            sys.exit(1)
+        del args[i:i + 2]
+    work_dir = args[0] if args else 'Work'
+
+    loops = scan(work_dir)
+    if not loops:
+        print(f"ERROR: no loop II found in {work_dir}/aie, run 'make aie_compile' first", file=sys.stderr)
+        sys.exit(1)
+    tile_key = lambda t: tuple(int(x) for x in t.split('_'))
+    for tile, location, ii in sorted(loops, key=lambda l: (tile_key(l[0]), l[1], l[2])):
+        print(f"tile {tile:<8} {location:<32} II = {ii}")
+    if max_ii is not None:
+        above = [l for l in loops if l[2] > max_ii]
+        if above:
+            print(f"FAILED: {len(above)} loop(s) above II = {max_ii}")
+            sys.exit(1)
+        print(f"All pipelined loops reached II <= {max_ii}")
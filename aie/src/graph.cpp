@@ -28,9 +28,24 @@ using namespace adf;
 
 my_graph aie_graph;
 
+// number of elements of the job in the simulation input files, written by fpga/testbench/testbench_setupaie.cpp
+#define SIM_JOB_ELEMENTS 32
+
+// asynchronous RTPs (see SYSTEM_RTP_PARAMS) block the first invocation until they get a value
+#define UPDATE_RTP_DEFAULT(name, type, value) \
+	for (int l = 0; l < NUM_LANES; l++) aie_graph.update(aie_graph.name[l], (type) value);
+
 int main(int argc, char ** argv)
 {
 	aie_graph.init();
+#if SYSTEM_RTP_ITERATIONS
+	// without the header the kernels get the size of the job from their synchronous iterations RTP
+	for (int l = 0; l < NUM_LANES; l++)
+		aie_graph.update(aie_graph.iterations[l], lane_iterations(SIM_JOB_ELEMENTS, l));
+#endif
+	SYSTEM_RTP_PARAMS(UPDATE_RTP_DEFAULT)
+	// one iteration: a job framed by its header, or with a persistent graph (SYSTEM_PERSISTENT_GRAPH) all the
+	// jobs of the input files up to the shutdown header written by fpga/testbench/testbench_setupaie.cpp
 	aie_graph.run(1);
 	aie_graph.end();
 	return 0;
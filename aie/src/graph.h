@@ -22,9 +22,13 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+// Auto-generated by template_generator/gen_template.py from kernel.cfg
+
 #pragma once
 #include "my_kernel_1.h"
+#include "my_kernel_1_graph.h"
 #include <adf.h>
+#include <string>
 
 using namespace adf;
 
@@ -32,47 +36,52 @@ class my_graph : public graph {
 
 private:
   // ------kernel declaration------
-  kernel my_kernel_1;
-  // kernel my_kernel_2;
+  // one kernel for each lane, all running the same function on different
+  // slices of the data (see NUM_LANES in common/system_config.h)
+  kernel my_kernel_1[NUM_LANES];
 
 public:
   // ------Input and Output PLIO declaration------
 
-  input_plio in_1;
-  // input_plio in_2;
-  output_plio out_1;
-  // output_plio out_2;
+  input_plio in[NUM_LANES];
+  output_plio out[NUM_LANES];
 
   my_graph() {
-    // ------kernel creation------
-    my_kernel_1 = kernel::create(
-        my_top_function); // the input is the kernel function name
-
-    // ------Input and Output PLIO creation------
-    // I argument: a name, that will be used to refer to the port in the block
-    // design II argument: the type of the PLIO that will be read/written. Test
-    // both plio_32_bits and plio_128_bits to verify the difference III
-    // argument: the path to the file that will be read/written for simulation
-
-    in_1 = input_plio::create("in_plio_1", plio_32_bits,
-                              "data/in_plio_source_1.txt");
-    out_1 = output_plio::create("out_plio_1", plio_32_bits,
-                                "data/out_plio_sink_1.txt");
-
-    // ------kernel connection------
-    // it is possible to have stream or window. This is just an example. Try
-    // both to see the difference
-    connect<stream>(in_1.out[0], my_kernel_1.in[0]);
-    connect<stream>(my_kernel_1.out[0], out_1.in[0]);
-    // set kernel source and headers
-    source(my_kernel_1) = "src/my_kernel_1.cpp";
-    headers(my_kernel_1) = {"src/my_kernel_1.h",
-                            "../common/common.h"}; // you can specify more than
-                                                   // one header to include
-
-    // set ratio
-    runtime<ratio>(my_kernel_1) =
-        0.9; // 90% of the time the kernel will be executed. This means that 1
-             // AIE will be able to execute just 1 Kernel
+    for (int i = 0; i < NUM_LANES; i++) {
+      // ------kernel creation------
+      my_kernel_1[i] = kernel::create(
+          my_top_function); // the input is the kernel function name
+
+      // ------Input and Output PLIO creation------
+      // I argument: a name, that will be used to refer to the port in the block
+      // design II argument: the type of the PLIO that will be read/written. Test
+      // both plio_32_bits and plio_128_bits to verify the difference III
+      // argument: the path to the file that will be read/written for simulation
+      // The widths match the streams of setup_aie (128 bits) and
+      // sink_from_aie (128 bits), both set in the [system] section of kernel.cfg.
+      // Lane i uses in_plio_<i+1> and out_plio_<i+1>, the names used by
+      // the stream_connect lines of linking/xclbin_overlay.cfg
+
+      in[i] = input_plio::create("in_plio_" + std::to_string(i + 1), plio_128_bits,
+                                 "data/in_plio_source_" + std::to_string(i + 1) + ".txt");
+      out[i] = output_plio::create("out_plio_" + std::to_string(i + 1), plio_128_bits,
+                                   "data/out_plio_sink_" + std::to_string(i + 1) + ".txt");
+
+      // ------kernel connection------
+      // generated together with the kernel by the template generator, so the
+      // connection (stream or buffer, with its size) always matches the kernel
+      // signature. Change "mode" in template_generator/kernel.cfg to switch
+      connect_my_top_function(my_kernel_1[i], in[i].out[0], out[i].in[0]);
+      // set kernel source and headers
+      source(my_kernel_1[i]) = "src/my_kernel_1.cpp";
+      headers(my_kernel_1[i]) = {"src/my_kernel_1.h",
+                                 "../common/common.h"}; // you can specify more than
+                                                        // one header to include
+
+      // set ratio
+      runtime<ratio>(my_kernel_1[i]) =
+          0.9; // 90% of the time the kernel will be executed. This means that 1
+               // AIE will be able to execute just 1 Kernel, so every lane gets its own tile
+    }
   };
 };
@@ -0,0 +1,86 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// 2D convolution of an image streamed row by row, N pixels at a time
+#ifndef KERNELS_CONV2D_HPP
+#define KERNELS_CONV2D_HPP
+
+#include "aie_api/aie.hpp"
+#include "kernel_utils.hpp"
+
+namespace voted {
+
+// out(r, c) = sum over i < KH, j < KW of weights[i][j] * x(r - i, c - j), shifted right by shift bits, with zeros
+// outside the image. The window ends at the output pixel, so this is the "same" convolution moved by (KH - 1) / 2
+// rows and (KW - 1) / 2 columns. Each call takes the next N pixels of rows W pixels wide and keeps the last KH - 1
+// rows for the next calls: one object convolves one image, from its first pixel (a static object is
+// zero-initialized) until reset() starts a new one, e.g.
+//     static voted::conv2d<int16_t, 16, 256, 3, 3> blur;
+//     blur(vec_input2, result_output2, blur_weights, 4);
+template <typename T, unsigned N, unsigned W, unsigned KH, unsigned KW>
+class conv2d {
+    static_assert(W % N == 0, "the rows must be made of whole vectors");
+    static_assert(KH >= 1 && KW >= 1 && KW - 1 <= N, "the window must be at most N + 1 pixels wide");
+
+public:
+    void operator()(const aie::vector<T, N>& in, aie::vector<T, N>& out, const T (&weights)[KH][KW], int shift = 0)
+    {
+        // cur[i]: the pixels of row r - i at the columns of in, prev[i]: the N pixels before them
+        aie::vector<T, N> cur[KH], prev[KH];
+        cur[0] = in;
+        for (unsigned i = 1; i < KH; i++)
+            cur[i] = aie::load_v<N>(rows + (i - 1) * W + column * N);
+        for (unsigned i = 0; i < KH; i++)
+            prev[i] = column ? aie::load_v<N>(left + i * N) : aie::zeros<T, N>();
+
+        auto acc = aie::mul(in, weights[0][0]);
+        for (unsigned i = 0; i < KH; i++)
+            for (unsigned j = i ? 0 : 1; j < KW; j++)
+                acc = aie::mac(acc, j ? aie::shuffle_up_fill(cur[i], prev[i], j) : cur[i], weights[i][j]);
+        out = to_vector<T>(acc, shift);
+
+        // row r - i becomes row r + 1 - (i + 1) for the next row
+        for (unsigned i = 0; i < KH; i++)
+            aie::store_v(left + i * N, cur[i]);
+        for (unsigned i = 0; i + 1 < KH; i++)
+            aie::store_v(rows + i * W + column * N, cur[i]);
+        column = column + 1 < W / N ? column + 1 : 0;
+    }
+
+    void reset()
+    {
+        for (unsigned i = 0; i < sizeof(rows) / sizeof(T); i++)
+            rows[i] = T(0);
+        column = 0;
+    }
+
+private:
+    alignas(aie::vector_decl_align) T rows[KH > 1 ? (KH - 1) * W : N];
+    alignas(aie::vector_decl_align) T left[KH * N];
+    unsigned column;
+};
+
+} // namespace voted
+
+#endif // KERNELS_CONV2D_HPP
@@ -0,0 +1,78 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// FIR filter over a stream of samples, N at a time
+#ifndef KERNELS_FIR_HPP
+#define KERNELS_FIR_HPP
+
+#include "aie_api/aie.hpp"
+#include "kernel_utils.hpp"
+
+namespace voted {
+
+// y[n] = sum over k < TAPS of taps[k] * x[n - k], shifted right by shift bits. Each call filters the next N samples;
+// the last TAPS - 1 samples are kept for the next call, so one object filters one stream, starting from zeros (a
+// static object is zero-initialized) until reset() starts over, e.g.
+//     static voted::fir<int16_t, 16, 12> lowpass;
+//     lowpass(vec_input2, result_output2, lowpass_taps, 15);
+// The window of tap k is the input shifted up by k samples, filled from the previous ones (aie::shuffle_up_fill)
+template <typename T, unsigned N, unsigned TAPS>
+class fir {
+    static_assert(TAPS >= 1, "a FIR filter has at least one tap");
+    // vectors of past samples the taps reach
+    static constexpr unsigned HISTORY = (TAPS - 1 + N - 1) / N;
+
+public:
+    void operator()(const aie::vector<T, N>& in, aie::vector<T, N>& out, const T (&taps)[TAPS], int shift = 0)
+    {
+        // block[b]: the samples b vectors before the current ones
+        aie::vector<T, N> block[HISTORY + 1];
+        block[0] = in;
+        for (unsigned b = 1; b <= HISTORY; b++)
+            block[b] = aie::load_v<N>(history + (b - 1) * N);
+
+        auto acc = aie::mul(in, taps[0]);
+        for (unsigned k = 1; k < TAPS; k++) {
+            const unsigned q = k / N, r = k % N;
+            acc = aie::mac(acc, r ? aie::shuffle_up_fill(block[q], block[q + 1], r) : block[q], taps[k]);
+        }
+        out = to_vector<T>(acc, shift);
+
+        for (unsigned b = 0; b < HISTORY; b++)
+            aie::store_v(history + b * N, block[b]);
+    }
+
+    void reset()
+    {
+        for (unsigned i = 0; i < sizeof(history) / sizeof(T); i++)
+            history[i] = T(0);
+    }
+
+private:
+    alignas(aie::vector_decl_align) T history[HISTORY > 0 ? HISTORY * N : N];
+};
+
+} // namespace voted
+
+#endif // KERNELS_FIR_HPP
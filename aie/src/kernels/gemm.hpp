@@ -0,0 +1,54 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Tiled matrix multiplication on aie::mmul
+#ifndef KERNELS_GEMM_HPP
+#define KERNELS_GEMM_HPP
+
+#include "aie_api/aie.hpp"
+#include "kernel_utils.hpp"
+
+namespace voted {
+
+// One M x N tile of C = A * B, shifted right by shift bits, from a block of M rows of A and the whole B, of KT * K
+// rows. a holds the KT tiles of A (M x K each, row-major) one after the other, b the KT tiles of B (K x N each,
+// row-major, aligned to aie::vector_decl_align) in the same order, and c gets the tile of C, row-major.
+// M, K and N must be a shape aie::mmul supports for TA x TB (e.g. 4 x 4 x 4 for int16 x int16), and a must fit a
+// vector (M * K * KT elements, up to 1024 bits), e.g. with weights in the data memory of the tile:
+//     alignas(aie::vector_decl_align) static const int16_t weights[4 * 4 * 4 * 4] = { ... };
+//     voted::gemm<4, 4, 4, 4>(vec_input2, result_output2, weights, 6);
+// gemm_tiles() (golden.hpp) gives the layout of a and b from row-major matrices
+template <unsigned M, unsigned K, unsigned N, unsigned KT, typename TA, typename TB, typename TC>
+inline void gemm(const aie::vector<TA, M * K * KT>& a, aie::vector<TC, M * N>& c, const TB* b, int shift = 0)
+{
+    aie::mmul<M, K, N, TA, TB> m;
+    m.mul(a.template extract<M * K>(0), aie::load_v<K * N>(b));
+    for (unsigned t = 1; t < KT; t++)
+        m.mac(a.template extract<M * K>(t), aie::load_v<K * N>(b + t * K * N));
+    c = to_vector<TC>(m, shift);
+}
+
+} // namespace voted
+
+#endif // KERNELS_GEMM_HPP
@@ -0,0 +1,140 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Scalar C++ models of the kernels of the library, for testbenches and host code (no aie:: API here, so they also
+// build on the host, e.g. inside compute_model() of the native model). Integer results are shifted right rounding
+// toward minus infinity and saturated to the type of the output: the kernels compute the same with
+// aie::rounding_mode::floor and aie::saturation_mode::saturate set on the tile
+#ifndef KERNELS_GOLDEN_HPP
+#define KERNELS_GOLDEN_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace voted {
+namespace golden {
+
+// accumulator of products of T, as wide as the ones of the AI Engine for the values of the tests
+template <typename T>
+using acc_t = std::conditional_t<std::is_integral_v<T>, int64_t, float>;
+
+template <typename T>
+inline T from_acc(acc_t<T> acc, int shift)
+{
+    if constexpr (std::is_integral_v<T>)
+        return (T) std::clamp<int64_t>(acc >> shift, std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+    else
+        return (T) acc;
+}
+
+// map.hpp, element by element
+template <typename T>
+inline T scale(T v, T factor, int shift) { return from_acc<T>(acc_t<T>(v) * factor, shift); }
+
+template <typename T>
+inline T offset(T v, T value) { return (T) (v + value); }
+
+template <typename T>
+inline T relu(T v) { return std::max(v, T(0)); }
+
+template <typename T>
+inline T clamp(T v, T low, T high) { return std::min(std::max(v, low), high); }
+
+// reduce.hpp: every block of block * n elements (block vectors of n) gives one value followed by n - 1 zeros.
+// Sums wrap around in T like the lane-wise partial results of the kernel
+enum class reduce_op { add, max, min };
+
+template <typename T>
+inline void reduce(reduce_op op, const T* x, T* y, size_t blocks, size_t block, size_t n)
+{
+    for (size_t b = 0; b < blocks; b++) {
+        const T* v = x + b * block * n;
+        acc_t<T> r = v[0];
+        for (size_t i = 1; i < block * n; i++)
+            r = op == reduce_op::add ? r + v[i] : op == reduce_op::max ? std::max<acc_t<T>>(r, v[i]) : std::min<acc_t<T>>(r, v[i]);
+        y[b * n] = (T) r;
+        std::fill(y + b * n + 1, y + (b + 1) * n, T(0));
+    }
+}
+
+// fir.hpp: y[i] = sum over k of taps[k] * x[i - k] >> shift, with zeros before x[0]
+template <typename T, unsigned TAPS>
+inline void fir(const T* x, T* y, size_t n, const T (&taps)[TAPS], int shift)
+{
+    for (size_t i = 0; i < n; i++) {
+        acc_t<T> acc = 0;
+        for (size_t k = 0; k < TAPS && k <= i; k++)
+            acc += acc_t<T>(taps[k]) * x[i - k];
+        y[i] = from_acc<T>(acc, shift);
+    }
+}
+
+// conv2d.hpp: y(r, c) = sum over i, j of weights[i][j] * x(r - i, c - j) >> shift, with zeros outside the image of
+// rows x width pixels, row-major
+template <typename T, unsigned KH, unsigned KW>
+inline void conv2d(const T* x, T* y, size_t rows, size_t width, const T (&weights)[KH][KW], int shift)
+{
+    for (size_t r = 0; r < rows; r++)
+        for (size_t c = 0; c < width; c++) {
+            acc_t<T> acc = 0;
+            for (size_t i = 0; i < KH && i <= r; i++)
+                for (size_t j = 0; j < KW && j <= c; j++)
+                    acc += acc_t<T>(weights[i][j]) * x[(r - i) * width + c - j];
+            y[r * width + c] = from_acc<T>(acc, shift);
+        }
+}
+
+// gemm.hpp on row-major matrices: c (rows x cols) = a (rows x depth) * b (depth x cols) >> shift
+template <typename TA, typename TB, typename TC>
+inline void gemm(const TA* a, const TB* b, TC* c, size_t rows, size_t depth, size_t cols, int shift)
+{
+    for (size_t r = 0; r < rows; r++)
+        for (size_t q = 0; q < cols; q++) {
+            acc_t<TC> acc = 0;
+            for (size_t k = 0; k < depth; k++)
+                acc += acc_t<TC>(a[r * depth + k]) * b[k * cols + q];
+            c[r * cols + q] = from_acc<TC>(acc, shift);
+        }
+}
+
+// Layout of the operands of gemm.hpp: the tiles (tile_rows x tile_cols, row-major) of a row-major matrix, along
+// each row of tiles and then row of tiles by row of tiles. For C = A * B with B of N columns, the tiles of A (M x K)
+// are the inputs of the kernel, KT per vector, and the tiles of B (K x N) its weights; its outputs are the rows of C
+template <typename T>
+inline void gemm_tiles(const T* matrix, T* tiles, size_t rows, size_t cols, size_t tile_rows, size_t tile_cols)
+{
+    for (size_t tr = 0; tr < rows / tile_rows; tr++)
+        for (size_t tc = 0; tc < cols / tile_cols; tc++)
+            for (size_t i = 0; i < tile_rows; i++)
+                for (size_t j = 0; j < tile_cols; j++)
+                    *tiles++ = matrix[(tr * tile_rows + i) * cols + tc * tile_cols + j];
+}
+
+} // namespace golden
+} // namespace voted
+
+#endif // KERNELS_GOLDEN_HPP
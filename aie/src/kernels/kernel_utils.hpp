@@ -0,0 +1,48 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Helpers shared by the kernels of the library (see kernels.hpp)
+#ifndef KERNELS_KERNEL_UTILS_HPP
+#define KERNELS_KERNEL_UTILS_HPP
+
+#include <type_traits>
+#include "aie_api/aie.hpp"
+
+namespace voted {
+
+// Back from an accumulator (or an aie::mmul) to a vector of T: integers are shifted right by shift bits, with the
+// rounding and saturation modes set on the tile (aie::set_rounding, aie::set_saturation), floating point values
+// are taken as they are
+template <typename T, typename Acc>
+inline auto to_vector(const Acc& acc, int shift)
+{
+    if constexpr (std::is_integral_v<T>)
+        return acc.template to_vector<T>(shift);
+    else
+        return acc.template to_vector<T>();
+}
+
+} // namespace voted
+
+#endif // KERNELS_KERNEL_UTILS_HPP
@@ -0,0 +1,43 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Library of vectorized AI Engine kernels, written with the aie:: API to go inside compute_function() (see
+// template_generator): each one takes the vectors of compute_function as they are. Every kernel is templated on
+// the element type and the vector width, and golden.hpp has its scalar C++ model; make test_kernel in aie/ checks
+// one against the other on the simulators (see aie/test).
+//     map.hpp     elementwise operations (scale, offset, relu, clamp, or any lambda on vectors)
+//     reduce.hpp  sum, maximum or minimum of blocks of vectors, running sums in an accumulator
+//     fir.hpp     multi-tap FIR filter
+//     conv2d.hpp  2D convolution of an image streamed row by row
+//     gemm.hpp    tiled matrix multiplication on aie::mmul
+#ifndef KERNELS_KERNELS_HPP
+#define KERNELS_KERNELS_HPP
+
+#include "map.hpp"
+#include "reduce.hpp"
+#include "fir.hpp"
+#include "conv2d.hpp"
+#include "gemm.hpp"
+
+#endif // KERNELS_KERNELS_HPP
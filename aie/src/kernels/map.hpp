@@ -0,0 +1,79 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Elementwise map: out = f(in), or f, g, ... applied in turn. The operations take and return vectors, so any
+// lambda on aie::vector works too, e.g.
+//     voted::map(vec_input2, result_output2, voted::scale<int16_t>{3, 1}, voted::relu{});
+#ifndef KERNELS_MAP_HPP
+#define KERNELS_MAP_HPP
+
+#include "aie_api/aie.hpp"
+#include "kernel_utils.hpp"
+
+namespace voted {
+
+template <typename T, unsigned N, typename... F>
+inline void map(const aie::vector<T, N>& in, aie::vector<T, N>& out, F... f)
+{
+    out = in;
+    ((out = f(out)), ...);
+}
+
+// v * factor >> shift
+template <typename T>
+struct scale {
+    T factor;
+    int shift;
+
+    template <unsigned N>
+    aie::vector<T, N> operator()(const aie::vector<T, N>& v) const { return to_vector<T>(aie::mul(v, factor), shift); }
+};
+
+// v + value
+template <typename T>
+struct offset {
+    T value;
+
+    template <unsigned N>
+    aie::vector<T, N> operator()(const aie::vector<T, N>& v) const { return aie::add(v, value); }
+};
+
+// max(v, 0)
+struct relu {
+    template <typename T, unsigned N>
+    aie::vector<T, N> operator()(const aie::vector<T, N>& v) const { return aie::max(v, T(0)); }
+};
+
+// v limited to [low, high]
+template <typename T>
+struct clamp {
+    T low, high;
+
+    template <unsigned N>
+    aie::vector<T, N> operator()(const aie::vector<T, N>& v) const { return aie::min(aie::max(v, low), high); }
+};
+
+} // namespace voted
+
+#endif // KERNELS_MAP_HPP
@@ -0,0 +1,96 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Reductions: blocks of vectors to one value (sum, maximum or minimum), and running sums in an accumulator
+#ifndef KERNELS_REDUCE_HPP
+#define KERNELS_REDUCE_HPP
+
+#include "aie_api/aie.hpp"
+
+namespace voted {
+
+enum class reduce_op { add, max, min };
+
+// Reduction of every block of BLOCK vectors to one value. Each call combines a vector with the lane-wise partial
+// result of its block (kept in T, so sums wrap around like the elements do), and the call that completes the block
+// writes the result to out[0], zeros to the other lanes, and returns true. With BLOCK > 1 it needs a framed output
+// (framed = yes: compute_function returns what the call returns). A static object starts at the beginning of a
+// block, reset() goes back there, e.g.
+//     static voted::reduce<voted::reduce_op::add, int32_t, 8, 64> block_sum;
+//     return block_sum(vec_input2, result_output2);
+template <reduce_op OP, typename T, unsigned N, unsigned BLOCK = 1>
+class reduce {
+public:
+    bool operator()(const aie::vector<T, N>& in, aie::vector<T, N>& out)
+    {
+        aie::vector<T, N> part = count ? combine(aie::load_v<N>(partial), in) : in;
+        if (++count < BLOCK) {
+            aie::store_v(partial, part);
+            return false;
+        }
+        count = 0;
+        out = aie::zeros<T, N>();
+        out[0] = lanes(part);
+        return true;
+    }
+
+    void reset() { count = 0; }
+
+private:
+    static aie::vector<T, N> combine(const aie::vector<T, N>& a, const aie::vector<T, N>& b)
+    {
+        if constexpr (OP == reduce_op::add)
+            return aie::add(a, b);
+        else if constexpr (OP == reduce_op::max)
+            return aie::max(a, b);
+        else
+            return aie::min(a, b);
+    }
+
+    static T lanes(const aie::vector<T, N>& v)
+    {
+        if constexpr (OP == reduce_op::add)
+            return aie::reduce_add(v);
+        else if constexpr (OP == reduce_op::max)
+            return aie::reduce_max(v);
+        else
+            return aie::reduce_min(v);
+    }
+
+    alignas(aie::vector_decl_align) T partial[N];
+    unsigned count;
+};
+
+// Running lane-wise sum of the vectors in an accumulator, without wrapping around: with the accumulators option of
+// the generator, voted::accumulate(acc, vec_input2) in compute_function sums the vectors of a job over acc_0 ...
+// acc_<accumulators - 1>, and finish_function gets their total (e.g. acc.template to_vector<T>() as its output)
+template <typename Acc, typename T, unsigned N>
+inline void accumulate(Acc& acc, const aie::vector<T, N>& in)
+{
+    acc = aie::add(acc, in);
+}
+
+} // namespace voted
+
+#endif // KERNELS_REDUCE_HPP
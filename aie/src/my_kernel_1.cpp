@@ -21,7 +21,9 @@ void my_top_function(
     aie::vector<int32_t,4> header = readincr_v<4>(input2);
     int tot_iterations = header[0];
 
-    for (int i = 0; i < tot_iterations; i++) {
+    for (int i = 0; i < tot_iterations; i++)
+        chess_prepare_for_pipelining
+    {
         aie::vector<int32_t,4> vec_input2 = readincr_v<4>(input2);
         aie::vector<int32_t,4> result_output2;
 
@@ -0,0 +1,17 @@
+/* Auto-generated (stream mode) */
+#ifndef MY_KERNEL_1_GRAPH_H
+#define MY_KERNEL_1_GRAPH_H
+
+#include <adf.h>
+
+// connects a my_top_function kernel: sources feed its inputs and its outputs go to the destinations,
+// in the order of the kernel parameters
+inline void connect_my_top_function(adf::kernel& k,
+                                    adf::port<adf::output>& src_input2,
+                                    adf::port<adf::input>& dst_output2)
+{
+    adf::connect<adf::stream>(src_input2, k.in[0]);
+    adf::connect<adf::stream>(k.out[0], dst_output2);
+}
+
+#endif // MY_KERNEL_1_GRAPH_H
\ No newline at end of file
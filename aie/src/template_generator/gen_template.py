@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 # -*- coding: utf-8 -*-
 
-import configparser, os, sys
+import configparser, importlib.util, math, os, sys
 
 # -------------------------
 # 1) Read kernel.cfg
@@ -9,12 +9,12 @@ import configparser, os, sys
 cfg = configparser.ConfigParser()
 cfg.read('kernel.cfg')
 
-def get_opt(key, default=None):
+def get_opt(key, default=None, section='kernel'):
     """
-    Return the value of 'key' in [kernel], stripping comments,
+    Return the value of 'key' in [section], stripping comments,
     or default if missing/blank/'None'.
     """
-    raw = cfg.get('kernel', key, fallback=None)
+    raw = cfg.get(section, key, fallback=None)
     if raw is None:
         return default
     val = raw.split('#',1)[0].split(';',1)[0].strip()
@@ -27,11 +27,177 @@ file_name   = get_opt('file_name', 'my_kernel')
 kernel_name = get_opt('kernel_name', file_name)
 header_name = get_opt('header_name', f'{file_name}.h')
 mode        = get_opt('mode', 'stream').lower()
-if mode not in ('stream', 'window'):
-    print("ERROR: 'mode' must be 'stream' or 'window'", file=sys.stderr)
-    sys.exit(1)
 if mode == 'window':
+    # the window API is deprecated, buffers replace it
+    print("WARNING: 'window' mode is deprecated, generating 'buffer' mode", file=sys.stderr)
+    mode = 'buffer'
+if mode not in ('stream', 'buffer'):
+    print("ERROR: 'mode' must be 'stream' or 'buffer'", file=sys.stderr)
+    sys.exit(1)
+if mode == 'buffer':
     conn = get_opt('communication', 'sync')  # sync/async
+    if conn not in ('sync', 'async'):
+        print("ERROR: 'communication' must be 'sync' or 'async'", file=sys.stderr)
+        sys.exit(1)
+    # number of elements of each buffer (tile), the same for every port
+    try:
+        buffer_size = int(get_opt('buffer_size', '256'))
+    except ValueError:
+        print("ERROR: buffer_size must be an integer", file=sys.stderr)
+        sys.exit(1)
+
+# How a stream kernel learns the size of each job: from a header vector at the start of its input ('header'), or
+# from a synchronous runtime parameter (RTP) port 'iterations', set by the host before each job ('rtp')
+control = get_opt('control', 'header').lower()
+if control not in ('header', 'rtp'):
+    print("ERROR: 'control' must be 'header' or 'rtp'", file=sys.stderr)
+    sys.exit(1)
+if control == 'rtp' and mode != 'stream':
+    print("ERROR: 'control = rtp' is for stream mode, buffer kernels process one buffer per invocation", file=sys.stderr)
+    sys.exit(1)
+
+# Scalar job parameters, as a comma separated list of name:type=default. Each one becomes an asynchronous RTP
+# port: the kernel keeps the last value written by the host, that can change it between jobs
+rtp_params = []
+for item in (get_opt('rtp_params', '') or '').split(','):
+    item = item.strip()
+    if not item:
+        continue
+    try:
+        decl, default = (item.split('=', 1) + ['0'])[:2]
+        name, t = [x.strip() for x in decl.split(':', 1)]
+    except ValueError:
+        print(f"ERROR: rtp_params: '{item}' is not name:type=default", file=sys.stderr)
+        sys.exit(1)
+    if not name.isidentifier() or name == 'iterations':
+        print(f"ERROR: rtp_params: invalid name '{name}'", file=sys.stderr)
+        sys.exit(1)
+    rtp_params.append((name, t, default.strip()))
+
+# A lane may be a chain of kernels, one per tile: the first stage reads the input PLIO, the last one writes the
+# output PLIO, and each stage passes its vectors to the next one over an AIE-to-AIE stream ('stream') or as
+# accumulators over the cascade port ('cascade'), so the intermediate results never leave the AIE array. chain
+# gives the type of every link, or one type for all of them
+try:
+    stages = int(get_opt('stages', '1'))
+except ValueError:
+    print("ERROR: stages must be an integer", file=sys.stderr)
+    sys.exit(1)
+chain = [c.strip().lower() for c in get_opt('chain', 'stream').split(',')]
+if stages < 1:
+    print("ERROR: stages must be at least 1", file=sys.stderr)
+    sys.exit(1)
+if len(chain) == 1:
+    chain = chain * (stages - 1)
+if len(chain) != stages - 1 or any(c not in ('stream', 'cascade') for c in chain):
+    print("ERROR: 'chain' must be 'stream' or 'cascade', or list one of them for each of the stages - 1 links", file=sys.stderr)
+    sys.exit(1)
+if stages > 1 and mode != 'stream':
+    print("ERROR: a chain of stages needs a stream mode kernel", file=sys.stderr)
+    sys.exit(1)
+# depth, in 32-bit words, of the FIFO of every stream link of the chain
+chain_fifo_depth = 32
+
+# Shape of the kernel loop, for the software pipeliner of the AIE compiler. unroll copies of the loop body work on
+# consecutive vectors, each with its own variables, so that their instructions can share the VLIW bundles.
+# accumulators gives compute_function() a state carried from one vector to the next, split over independent
+# accumulators taken in turn (acc_j gets the vectors j, j + accumulators, ...), that is as many dependency chains
+# the pipeliner can overlap. At the end of the job they are added together and handed to finish_function(), which
+# can write one more vector on the outputs (stream mode only: a buffer has no room for it). loop_range bounds the vectors of a job, as min or min, max (stream mode: in buffer mode
+# the compiler knows the trip count), and becomes the chess_loop_range of the loop
+try:
+    unroll       = int(get_opt('unroll', '1'))
+    accumulators = int(get_opt('accumulators', '0'))
+    loop_range   = [int(x) for x in get_opt('loop_range', '').split(',') if x.strip()]
+except ValueError:
+    print("ERROR: unroll, accumulators and loop_range must be integers", file=sys.stderr)
+    sys.exit(1)
+if unroll < 1 or accumulators < 0 or (accumulators and unroll % accumulators):
+    print("ERROR: unroll must be at least 1 and a multiple of accumulators", file=sys.stderr)
+    sys.exit(1)
+if accumulators and mode != 'stream':
+    print("ERROR: accumulators needs a stream mode kernel, finish_function() writes after the vectors of the job", file=sys.stderr)
+    sys.exit(1)
+if len(loop_range) > 2 or any(x < 1 for x in loop_range) or loop_range != sorted(loop_range):
+    print("ERROR: 'loop_range' must be the min or the min, max vectors of a job", file=sys.stderr)
+    sys.exit(1)
+if mode == 'stream' and loop_range and loop_range[0] < unroll:
+    # the unrolled loop may then run zero times, below any range it could be given
+    print(f"WARNING: loop_range starts below unroll = {unroll}, no chess_loop_range is generated", file=sys.stderr)
+
+# System parameters: the [system] section is optional, without it only the kernel files are generated
+with_system = cfg.has_section('system')
+if with_system:
+    try:
+        lanes          = int(get_opt('lanes', '1', 'system'))
+        plio_in_width  = int(get_opt('plio_in_width', '128', 'system'))
+        plio_out_width = int(get_opt('plio_out_width', '128', 'system'))
+        compute_units  = int(get_opt('compute_units', '1', 'system'))
+    except ValueError:
+        print("ERROR: lanes, PLIO widths and compute units must be integers", file=sys.stderr)
+        sys.exit(1)
+    # one m_axi port of each mover for every bank listed: the buffers are striped over them. With several compute
+    # units the banks are listed unit by unit, each pair of movers has its own
+    input_banks  = [b.strip() for b in get_opt('input_bank', 'MC_NOC0', 'system').split(',')]
+    output_banks = [b.strip() for b in get_opt('output_bank', 'MC_NOC0', 'system').split(',')]
+    if compute_units < 1 or compute_units & (compute_units - 1) or len(input_banks) % compute_units:
+        print("ERROR: compute_units must be a power of two that divides the number of banks listed", file=sys.stderr)
+        sys.exit(1)
+    mem_ports    = len(input_banks) // compute_units
+    persistent  = get_opt('persistent', 'no', 'system').lower() in ('1', 'yes', 'true')
+    stats       = get_opt('stats', 'no', 'system').lower() in ('1', 'yes', 'true')
+    framed      = get_opt('framed', 'no', 'system').lower() in ('1', 'yes', 'true')
+    descriptors = get_opt('descriptors', 'no', 'system').lower() in ('1', 'yes', 'true')
+    free_running = get_opt('free_running', 'no', 'system').lower() in ('1', 'yes', 'true')
+    packet_switching = get_opt('packet_switching', 'no', 'system').lower() in ('1', 'yes', 'true')
+    if descriptors and (mode != 'stream' or control != 'header'):
+        print("ERROR: job descriptors need a stream mode kernel with control = header (every job gets its own header)", file=sys.stderr)
+        sys.exit(1)
+    if descriptors and framed:
+        print("ERROR: job descriptors and a framed output cannot be combined, the produced counts cover a whole run", file=sys.stderr)
+        sys.exit(1)
+    if free_running and not descriptors:
+        print("ERROR: free-running movers need descriptors = yes (the command ring holds job descriptors)", file=sys.stderr)
+        sys.exit(1)
+    if free_running and stats:
+        print("ERROR: free-running movers cannot keep stats, their run only ends with the stop command", file=sys.stderr)
+        sys.exit(1)
+    if framed and mode != 'stream':
+        print("ERROR: a framed output needs a stream mode kernel (the trailer of each job carries TLAST)", file=sys.stderr)
+        sys.exit(1)
+    if persistent and (mode != 'stream' or control != 'header'):
+        print("ERROR: a persistent graph needs a stream mode kernel with control = header (jobs are framed by their header)", file=sys.stderr)
+        sys.exit(1)
+    if packet_switching and mode != 'buffer':
+        print("ERROR: packet switching needs a buffer mode kernel (the tile DMA strips the packet header and fills the buffer)", file=sys.stderr)
+        sys.exit(1)
+    if packet_switching and stats:
+        print("ERROR: packet switching and stats cannot be combined, the movers only count the beats of the lanes", file=sys.stderr)
+        sys.exit(1)
+    if persistent and rtp_params:
+        # RTPs are read when an invocation starts, and a persistent kernel is invoked only once
+        print("WARNING: with a persistent graph the RTP parameters keep the value they have when the graph starts", file=sys.stderr)
+    if lanes < 1 or lanes & (lanes - 1):
+        print("ERROR: lanes must be a power of two", file=sys.stderr)
+        sys.exit(1)
+    if len(output_banks) != len(input_banks) or mem_ports not in (1, 2, 4) or not all(input_banks + output_banks):
+        print("ERROR: input_bank and output_bank must list the same number of banks, 1, 2 or 4 per compute unit", file=sys.stderr)
+        sys.exit(1)
+    # every port of every compute unit feeds its own group of lanes
+    if lanes % (compute_units * mem_ports):
+        print("ERROR: lanes must be a multiple of the number of memory banks", file=sys.stderr)
+        sys.exit(1)
+    if plio_in_width not in (32, 64, 128) or plio_out_width not in (32, 64, 128):
+        print("ERROR: PLIO widths must be 32, 64 or 128", file=sys.stderr)
+        sys.exit(1)
+    # the lanes of a port share one pair of PLIOs through a pktsplit and a pktmerge, of up to 32 destinations
+    if packet_switching and not 2 <= lanes // (compute_units * mem_ports) <= 32:
+        print("ERROR: packet switching needs 2 to 32 lanes for each memory port", file=sys.stderr)
+        sys.exit(1)
+    # the lanes are interleaved beat by beat, with different widths sink_from_aie would reorder the elements
+    if lanes > 1 and plio_in_width != plio_out_width:
+        print("ERROR: with more than one lane the input and output PLIOs must have the same width", file=sys.stderr)
+        sys.exit(1)
 
 # -------------------------
 # 3) Print parameters
@@ -41,13 +207,30 @@ print(f"  file_name   = {file_name}")
 print(f"  kernel_name = {kernel_name}")
 print(f"  header_name = {header_name}")
 print(f"  mode        = {mode}")
-print(f"  communication = {conn if mode=='window' else 'N/A'}")
+print(f"  communication = {conn if mode=='buffer' else 'N/A'}")
+print(f"  buffer_size = {buffer_size if mode=='buffer' else 'N/A'}")
+print(f"  control     = {control if mode=='stream' else 'N/A'}")
+print(f"  rtp_params  = {', '.join(f'{n}:{t}={d}' for n, t, d in rtp_params) or 'none'}")
+print(f"  stages      = {stages}" + (f", chain = {', '.join(chain)}" if stages > 1 else ''))
+print(f"  unroll      = {unroll}, accumulators = {accumulators}"
+      + (f", loop_range = {', '.join(map(str, loop_range))}" if mode == 'stream' and loop_range else ''))
 print("  streams:")
 for role in ('input1', 'input2', 'output1', 'output2'):
     t = get_opt(f'{role}_type')
     s = get_opt(f'{role}_size')
     if t and s:
         print(f"    {role}: type={t}, size={s}")
+if with_system:
+    print("  system:")
+    print(f"    lanes = {lanes}, plio_in_width = {plio_in_width}, plio_out_width = {plio_out_width}")
+    print(f"    input_bank = {', '.join(input_banks)}, output_bank = {', '.join(output_banks)}")
+    print(f"    compute_units = {compute_units}")
+    print(f"    persistent = {'yes' if persistent else 'no'}")
+    print(f"    stats = {'yes' if stats else 'no'}")
+    print(f"    framed = {'yes' if framed else 'no'}")
+    print(f"    descriptors = {'yes' if descriptors else 'no'}")
+    print(f"    free_running = {'yes' if free_running else 'no'}")
+    print(f"    packet_switching = {'yes' if packet_switching else 'no'}")
 print("======================================\n")
 
 # -------------------------
@@ -58,7 +241,17 @@ type_bw = {
     'int16_t': 16, 'uint16_t': 16,
     'int32_t': 32, 'uint32_t': 32,
     'int64_t': 64, 'uint64_t': 64,
-    'float': 32,   'double': 64
+    'float': 32,   'double': 64,
+    'bfloat16': 16
+}
+
+# Type of the same elements on the PL and host side (data_t): bfloat16 has no C++ type there, it travels as raw
+# 16-bit words
+pl_type = {
+    'int8_t': 'int8_t',   'uint8_t': 'uint8_t',
+    'int16_t': 'int16_t', 'uint16_t': 'uint16_t',
+    'int32_t': 'int32_t', 'uint32_t': 'uint32_t',
+    'float': 'float',     'bfloat16': 'uint16_t'
 }
 
 # -------------------------
@@ -83,33 +276,137 @@ for role in ('input1', 'input2', 'output1', 'output2'):
         sys.exit(1)
     streams.append((role, t, vs))
 
+for name, t, _ in rtp_params:
+    if t not in type_bw:
+        print(f"ERROR: unknown type '{t}' for the RTP parameter {name}", file=sys.stderr)
+        sys.exit(1)
+
 inputs  = [s for s in streams if s[0].startswith('input')]
 outputs = [s for s in streams if s[0].startswith('output')]
 
-# -------------------------
-# 6) Build function signature
-# -------------------------
-# window type mapping
-window_type_map = {
-    'int8_t': 'int8', 'int16_t': 'int16', 'int32_t': 'int32', 'int64_t': 'int64',
-    'uint8_t': 'uint8', 'uint16_t': 'uint16', 'uint32_t': 'uint32', 'uint64_t': 'uint64',
-    'float': 'float', 'double': 'float'
+# Accumulator of each element type on a cascade port of the AI Engine (acc48 for 8 and 16-bit data, acc80 for 32-bit
+# integers, accfloat for floating point): a cascade link carries aie::accum vectors of these
+acc_tag = {
+    'int8_t': 'acc48',   'uint8_t': 'acc48',
+    'int16_t': 'acc48',  'uint16_t': 'acc48',
+    'int32_t': 'acc80',  'uint32_t': 'acc80',
+    'float': 'accfloat', 'bfloat16': 'accfloat'
 }
 
-params = []
-for r, t, _ in inputs:
-    if mode == 'stream':
-        params.append(f"input_stream<{t}>* restrict {r}")
+if stages > 1:
+    # the stages hand one vector to each other, of the input type
+    if len(inputs) != 1 or len(outputs) != 1:
+        print("ERROR: a chain of stages needs a kernel with exactly one input and one output", file=sys.stderr)
+        sys.exit(1)
+    if 'cascade' in chain and inputs[0][1] not in acc_tag:
+        print(f"ERROR: no cascade accumulator for the type {inputs[0][1]}", file=sys.stderr)
+        sys.exit(1)
+
+# the accumulators of compute_function() hold vectors of the first input (of the first output without inputs)
+acc_t, acc_vs = (inputs or outputs)[0][1:] if streams else (None, 0)
+if accumulators and acc_t not in acc_tag:
+    print(f"ERROR: no accumulator for the type {acc_t}", file=sys.stderr)
+    sys.exit(1)
+
+if mode == 'buffer':
+    # all the ports walk their buffer with the same number of vectors
+    buffer_vs = streams[0][2] if streams else 1
+    for r, t, vs in streams:
+        if vs != buffer_vs:
+            print("ERROR: in buffer mode all the ports must have the same vector size", file=sys.stderr)
+            sys.exit(1)
+    if buffer_size % buffer_vs != 0:
+        print(f"ERROR: buffer_size must be a multiple of the vector size ({buffer_vs})", file=sys.stderr)
+        sys.exit(1)
+    if buffer_size // buffer_vs % unroll:
+        print(f"ERROR: the vectors of a buffer ({buffer_size // buffer_vs}) must be a multiple of unroll", file=sys.stderr)
+        sys.exit(1)
+    # ping-pong: every port takes two buffers of the tile data memory (32 KB, shared with the stack and heap)
+    local_bytes = sum(2 * buffer_size * type_bw[t] // 8 for _, t, _ in streams)
+    if local_bytes > 32768:
+        print(f"WARNING: ping-pong buffers take {local_bytes} bytes, more than the 32 KB of a tile", file=sys.stderr)
+
+if with_system:
+    # the PL movers feed one input and drain one output of each lane, counting elements of data_t
+    if len(inputs) != 1 or len(outputs) != 1:
+        print("ERROR: the [system] section needs a kernel with exactly one input and one output", file=sys.stderr)
+        sys.exit(1)
+    (_, in_t, in_vs), (_, out_t, out_vs) = inputs[0], outputs[0]
+    if in_t not in pl_type or type_bw[in_t] != type_bw[out_t]:
+        print("ERROR: the PL movers need 8, 16 or 32-bit input and output types of the same width", file=sys.stderr)
+        sys.exit(1)
+    data_bits = type_bw[in_t]
+    vector_bits     = in_vs * type_bw[in_t]
+    out_vector_bits = out_vs * type_bw[out_t]
+    # every kernel iteration must read and write whole PLIO beats, the lane header fills one input vector
+    if vector_bits % plio_in_width or out_vector_bits % plio_out_width:
+        print("ERROR: the input and output vectors must be multiples of the PLIO widths", file=sys.stderr)
+        sys.exit(1)
+    beats_per_vector = vector_bits // plio_in_width
+    # every packet carries one buffer, written back by sink_from_aie as whole 512-bit words
+    if packet_switching and buffer_size * data_bits % 512:
+        print("ERROR: with packet switching a buffer must be a multiple of 512 bits", file=sys.stderr)
+        sys.exit(1)
+    # smallest number of elements that gives every lane whole vectors (stream mode) or whole buffers (buffer mode)
+    # and fills whole output beats, in each of the mem_ports slices of the buffer
+    port_lanes = lanes // (compute_units * mem_ports)
+    if mode == 'buffer':
+        align_in = port_lanes * buffer_size
+    elif beats_per_vector > 1:
+        align_in = port_lanes * vector_bits // data_bits
     else:
-        wtype = window_type_map[t]
-        params.append(f"input_window_{wtype}* {r}")
-for r, t, _ in outputs:
-    if mode == 'stream':
-        params.append(f"output_stream<{t}>* restrict {r}")
+        align_in = plio_in_width // data_bits
+    align_out = plio_out_width // data_bits
+    size_align = mem_ports * (align_in * align_out // math.gcd(align_in, align_out))
+
+# -------------------------
+# 6) Build function signatures
+# -------------------------
+# Ports of every stage of the chain, as (name, type, vector size, kind), kind being 'stream' (a PLIO or an
+# AIE-to-AIE stream) or 'cascade'. The first stage has the inputs of the kernel, the last one its outputs, and
+# between them a stage reads chain_in and writes chain_out, vectors of the input type
+stage_ports = []
+for s in range(stages):
+    if s == 0:
+        ins = [(r, t, vs, 'stream') for r, t, vs in inputs]
     else:
-        wtype = window_type_map[t]
-        params.append(f"output_window_{wtype}* {r}")
-param_str = ',\n                   '.join(params)
+        ins = [('chain_in', inputs[0][1], inputs[0][2], chain[s - 1])]
+    if s == stages - 1:
+        outs = [(r, t, vs, 'stream') for r, t, vs in outputs]
+    else:
+        outs = [('chain_out', inputs[0][1], inputs[0][2], chain[s])]
+    stage_ports.append((ins, outs))
+
+def stage_kernel_name(s):
+    return kernel_name if stages == 1 else f'{kernel_name}_stage{s + 1}'
+
+def stage_compute_name(s):
+    return 'compute_function' if stages == 1 else f'compute_function_stage{s + 1}'
+
+def stage_finish_name(s):
+    return 'finish_function' if stages == 1 else f'finish_function_stage{s + 1}'
+
+# buffers have no size in the signature: it is set by dimensions() in the graph (see the generated _graph.h)
+def port_param(direction, r, t, kind):
+    if kind == 'cascade':
+        return f"{direction}_cascade<{acc_tag[t]}>* restrict {r}"
+    if mode == 'stream':
+        return f"{direction}_stream<{t}>* restrict {r}"
+    if conn == 'sync':
+        return f"{direction}_buffer<{t}>& restrict {r}"
+    return f"{direction}_async_buffer<{t}>& restrict {r}"
+
+# RTP ports are plain scalars, after the data ports: input ports k.in[len(inputs)], k.in[len(inputs) + 1], ...
+# With a chain they go to the first stage
+rtp_ports = ([('iterations', 'int32_t', None)] if control == 'rtp' else []) + rtp_params
+
+def stage_param_str(s):
+    ins, outs = stage_ports[s]
+    params = [port_param('input', r, t, k) for r, t, _, k in ins]
+    params += [port_param('output', r, t, k) for r, t, _, k in outs]
+    if s == 0:
+        params += [f"{t} {name}" for name, t, _ in rtp_ports]
+    return ',\n                   '.join(params)
 
 # -------------------------
 # 7) Include guard & filenames
@@ -119,128 +416,317 @@ guard     = base.upper().replace('.', '_') + '_H'
 cpp_name  = f"{file_name}.cpp"
 
 # -------------------------
-# 8) Compute-function stub
+# 8) Compute-function stubs
 # -------------------------
-compute_args = []
-for r, t, vs in inputs:
-    compute_args.append(f"aie::vector<{t},{vs}>& vec_{r}")
-for r, t, vs in outputs:
-    compute_args.append(f"aie::vector<{t},{vs}>& result_{r}")
-compute_sig = f"void compute_function({', '.join(compute_args)})"
-compute_def = f"""{compute_sig}
+# a cascade port carries accumulators: the stage on either side of it computes on aie::accum instead of vectors
+def port_var(r, kind, prefix):
+    return f"acc_{r}" if kind == 'cascade' else f"{prefix}_{r}"
+
+def port_decl(r, t, vs, kind, prefix):
+    if kind == 'cascade':
+        return f"aie::accum<{acc_tag[t]},{vs}> {port_var(r, kind, prefix)}"
+    return f"aie::vector<{t},{vs}> {port_var(r, kind, prefix)}"
+
+framed_kernel = with_system and framed
+compute_sigs, compute_defs = [], []
+for s in range(stages):
+    ins, outs = stage_ports[s]
+    compute_args = [f"aie::accum<{acc_tag[t]},{vs}>& acc_{r}" if k == 'cascade'
+                    else f"aie::vector<{t},{vs}>& vec_{r}" for r, t, vs, k in ins]
+    compute_args += [f"aie::accum<{acc_tag[t]},{vs}>& acc_{r}" if k == 'cascade'
+                     else f"aie::vector<{t},{vs}>& result_{r}" for r, t, vs, k in outs]
+    if accumulators:
+        compute_args.append(f"aie::accum<{acc_tag[acc_t]},{acc_vs}>& acc")
+    if s == 0:
+        compute_args += [f"{t} {name}" for name, t, _ in rtp_params]
+    if framed_kernel and s == stages - 1:
+        # with a framed output the kernel decides what to send: compute_function() drops the vector by returning false
+        compute_sig = f"bool {stage_compute_name(s)}({', '.join(compute_args)})"
+        compute_def = f"""{compute_sig}
+{{
+    // to be filled with user logic
+    return true; // false: nothing is written for this vector
+}}
+"""
+    else:
+        compute_sig = f"void {stage_compute_name(s)}({', '.join(compute_args)})"
+        compute_def = f"""{compute_sig}
+{{
+    // to be filled with user logic
+}}
+"""
+    compute_sigs.append(compute_sig)
+    compute_defs.append(compute_def)
+    if accumulators:
+        # after the last vector of the job: acc is the sum of the accumulators
+        finish_args = [f"aie::accum<{acc_tag[acc_t]},{acc_vs}>& acc"]
+        finish_args += [f"aie::accum<{acc_tag[t]},{vs}>& acc_{r}" if k == 'cascade'
+                        else f"aie::vector<{t},{vs}>& result_{r}" for r, t, vs, k in outs]
+        if s == 0:
+            finish_args += [f"{t} {name}" for name, t, _ in rtp_params]
+        finish_sig = f"bool {stage_finish_name(s)}({', '.join(finish_args)})"
+        compute_sigs.append(finish_sig)
+        compute_defs[-1] += f"""
+{finish_sig}
 {{
     // to be filled with user logic
+    return false; // true: the outputs get one more vector, after those of the job
 }}
 """
 
 # -------------------------
 # 9) Generate .cpp
 # -------------------------
-lines = [
-    f'/* Auto-generated ({mode} mode) */',
-    f'#include "{header_name}"',
-    '#include "common.h"',
-    '#include "aie_api/aie.hpp"',
-    '#include "aie_api/aie_adf.hpp"',
-    '#include "aie_api/utils.hpp"',
-    '',
-    '// user compute stub',
-    compute_def,
-    '',
-    f'void {kernel_name}(',
-    f'                   {param_str}',
-    ')',
-    '{'
-]
+# A stream access of the AI Engine moves 128 bits: wider vectors are read and written as several accesses, by the
+# readincr_wide and writeincr_wide helpers of the generated .cpp
+stream_access_bits = 128
 
-if mode == 'stream':
-    if inputs:
-        r0, t0, vs0 = inputs[0]
-        lines += [
-            '    // read header for iteration count',
-            f'    aie::vector<{t0},{vs0}> header = readincr_v<{vs0}>({r0});',
-            '    int tot_iterations = header[0];',
+def wide(t, vs, kind):
+    return mode == 'stream' and kind != 'cascade' and vs * type_bw[t] > stream_access_bits
+
+def read_expr(r, t, vs, kind):
+    if mode == 'buffer':
+        return f'*it_{r}++'
+    return f'readincr_wide<{vs}>({r})' if wide(t, vs, kind) else f'readincr_v<{vs}>({r})'
+
+def write_stmt(r, t, vs, kind, var):
+    if mode == 'buffer':
+        return f'*it_{r}++ = {var};'
+    return f'writeincr_wide({r}, {var});' if wide(t, vs, kind) else f'writeincr({r}, {var});'
+
+# One vector of stage s through its compute function: copy k of the body of the loop, with its own variables when
+# the loop is unrolled
+def vector_step(s, k):
+    ins, outs = stage_ports[s]
+    sfx = f'_{k}' if unroll > 1 else ''
+    step = []
+    for r, t, vs, kd in ins:
+        step.append(f'        {port_decl(r, t, vs, kd, "vec")}{sfx} = {read_expr(r, t, vs, kd)};')
+    for r, t, vs, kd in outs:
+        step.append(f'        {port_decl(r, t, vs, kd, "result")}{sfx};')
+    vecs = [port_var(r, kd, 'vec') + sfx for r, _, _, kd in ins]
+    ress = [port_var(r, kd, 'result') + sfx for r, _, _, kd in outs]
+    ress += [f'acc_{k % accumulators}'] if accumulators else []
+    ress += [name for name, _, _ in rtp_params] if s == 0 else []
+    call = f'{stage_compute_name(s)}({", ".join(vecs + ress)})'
+    if framed_kernel and s == stages - 1:
+        step += [
             '',
-            '    for (int i = 0; i < tot_iterations; i++) {'
+            f'        if ({call}) {{',
         ]
-    for r, t, vs in inputs:
-        lines.append(f'        aie::vector<{t},{vs}> vec_{r} = readincr_v<{vs}>({r});')
-    for r, t, vs in outputs:
-        lines.append(f'        aie::vector<{t},{vs}> result_{r};')
-    vecs = [f"vec_{r}" for r, _, _ in inputs]
-    ress = [f"result_{r}" for r, _, _ in outputs]
-    lines += [
+        for r, t, vs, kd in outs:
+            step.append(f'            {write_stmt(r, t, vs, kd, port_var(r, kd, "result") + sfx)}')
+        step.append('        }')
+    else:
+        step += [
+            '',
+            f'        {call};',
+            ''
+        ]
+        for r, t, vs, kd in outs:
+            step.append(f'        {write_stmt(r, t, vs, kd, port_var(r, kd, "result") + sfx)}')
+    return step
+
+# Loop of stage s over the vectors of a job (stream mode) or of a buffer (buffer mode). An unrolled stream loop
+# leaves the last tot_iterations % unroll vectors of the job to copies of its body after it
+def vector_loop(s):
+    loop = []
+    if accumulators:
+        tag = acc_tag[acc_t]
+        loop.append(f'    // accumulators of compute_function(), reset for every {"job" if mode == "stream" else "buffer"}')
+        for j in range(accumulators):
+            loop.append(f'    aie::accum<{tag},{acc_vs}> acc_{j} = aie::zeros<{tag},{acc_vs}>();')
+        loop.append('')
+    steps = []
+    for k in range(unroll):
+        steps += ([''] if k else []) + vector_step(s, k)
+    hints = ['        chess_prepare_for_pipelining']
+    if mode == 'buffer':
+        return loop + [f'    for (int i = 0; i < {buffer_size // buffer_vs // unroll}; i++)'] + hints + ['    {'] + steps + ['    }']
+    if loop_range and loop_range[0] >= unroll:
+        hi = f' {loop_range[1] // unroll}' if len(loop_range) > 1 else ''
+        hints.append(f'        chess_loop_range({loop_range[0] // unroll},{hi})')
+    if unroll == 1:
+        return loop + ['    for (int i = 0; i < tot_iterations; i++)'] + hints + ['    {'] + steps + ['    }']
+    loop += [
+        f'    // {unroll} vectors per iteration',
+        '    int i = 0;',
+        f'    for (; i + {unroll} <= tot_iterations; i += {unroll})',
+    ] + hints + ['    {'] + steps + ['    }']
+    for k in range(unroll - 1):
+        loop += [''] + ([] if k else [f'    // the last tot_iterations % {unroll} vectors of the job'])
+        loop += [f'    if (i{f" + {k}" if k else ""} < tot_iterations) {{'] + vector_step(s, k) + ['    }']
+    return loop
+
+# End of the job of stage s with accumulators: their sum goes to the finish function, which may write one more
+# vector on the outputs
+def finish_step(s):
+    ins, outs = stage_ports[s]
+    tag = acc_tag[acc_t]
+    step = [
         '',
-        f'        compute_function({", ".join(vecs + ress)});',
-        ''
+        f'    // the accumulators added together, for {stage_finish_name(s)}()',
+        f'    aie::accum<{tag},{acc_vs}> acc = acc_0;',
     ]
-    for r, _, _ in outputs:
-        lines.append(f'        writeincr({r}, result_{r});')
-    lines.append('    }')
-else:
-    # window mode
-    if conn == 'sync':
-        for i, (r, t, vs) in enumerate(inputs):
-            wtype = window_type_map[t]
-            if i == 0:
-                lines += [
-                    '    // read header for iteration count',
-                    f'    aie::vector<{t},{vs}> header = window_readincr_v{vs}({r});',
-                    '    int tot_iterations = header[0];',
+    for j in range(1, accumulators):
+        step.append(f'    acc = aie::add(acc, acc_{j});')
+    for r, t, vs, kd in outs:
+        step.append(f'    {port_decl(r, t, vs, kd, "result")};')
+    ress = [port_var(r, kd, 'result') for r, _, _, kd in outs]
+    ress += [name for name, _, _ in rtp_params] if s == 0 else []
+    step.append(f'    if ({stage_finish_name(s)}({", ".join(["acc"] + ress)})) {{')
+    for r, t, vs, kd in outs:
+        step.append(f'        {write_stmt(r, t, vs, kd, port_var(r, kd, "result"))}')
+    step.append('    }')
+    return step
+
+# Body of stage s of a stream kernel. A stage after the first gets the header from the previous one, and every
+# stage but the last forwards it, so that the whole chain knows the size of each job (and shuts down with it)
+def stream_body(s):
+    ins, outs = stage_ports[s]
+    first, last = s == 0, s == stages - 1
+    job = []
+    if first and control == 'rtp':
+        # the iterations RTP is synchronous: each invocation waits for a new value, i.e. for the next job
+        job += [
+            '    // iteration count from the iterations RTP, written by the host before each job',
+            '    int tot_iterations = iterations;',
+        ]
+        if not last:
+            r0, t0, vs0, _ = ins[0]
+            if t0 in ('int32_t', 'uint32_t'):
+                job += [
                     '',
-                    '    for (int i = 0; i < tot_iterations; i++) {'
+                    '    // the next stages of the chain get it as a header',
+                    f'    aie::vector<{t0},{vs0}> header = aie::zeros<{t0},{vs0}>();',
+                    '    header[0] = tot_iterations;',
                 ]
-            lines.append(f'        aie::vector<{t},{vs}> vec_{r} = window_readincr_v{vs}({r});')
-        for r, t, vs in outputs:
-            lines.append(f'        aie::vector<{t},{vs}> result_{r};')
-        vecs = [f"vec_{r}" for r, _, _ in inputs]
-        ress = [f"result_{r}" for r, _, _ in outputs]
-        lines += [
-            '',
-            f'        compute_function({", ".join(vecs + ress)});',
-            ''
-        ]
-        for r, t, vs in outputs:
-            lines.append(f'        window_writeincr({r}, result_{r});')
-        lines.append('    }')
-    else:
-        for i, (r, t, vs) in enumerate(inputs):
-            wtype = window_type_map[t]  # tipo corretto per la window
-            if i == 0:
-                lines += [
-                    '    // read header for iteration count',
-                    f'    window_acquire({r});',
-                    f'    aie::vector<{t},{vs}> header = window_readincr_v{vs}({r});',
-                    f'    window_release({r});',
-                    '    int tot_iterations = header[0];',
+            else:
+                words = vs0 * type_bw[t0] // 32
+                job += [
                     '',
-                    '    for (int i = 0; i < tot_iterations; i++) {'
+                    '    // the next stages of the chain get it as a header',
+                    f'    aie::vector<int32,{words}> count = aie::zeros<int32,{words}>();',
+                    '    count[0] = tot_iterations;',
+                    f'    aie::vector<{t0},{vs0}> header = count.template cast_to<{t0}>();',
                 ]
-            lines += [
-                f'        window_acquire({r});',
-                f'        aie::vector<{t},{vs}> vec_{r} = window_readincr_v{vs}({r});',
-                f'        window_release({r});'
-            ]
-
-        for r, t, vs in outputs:
-            lines += [
-                f'        aie::vector<{t},{vs}> result_{r};',
-                f'        window_acquire({r});',
-                f'        window_writeincr({r}, result_{r});',
-                f'        window_release({r});'
+    elif ins:
+        r0, t0, vs0, k0 = ins[0]
+        job += [
+            '    // read header for iteration count',
+            f'    aie::vector<{t0},{vs0}> header = readincr_v<{vs0}>({r0}).template to_vector<{t0}>();' if k0 == 'cascade'
+            else f'    aie::vector<{t0},{vs0}> header = {read_expr(r0, t0, vs0, k0)};',
+            # the count is a 32-bit integer in the first bits of the vector, whatever the element type
+            '    int tot_iterations = header[0];' if t0 in ('int32_t', 'uint32_t')
+            else '    int tot_iterations = header.template cast_to<int32>()[0];',
+        ]
+    if not last and not (first and control == 'rtp'):
+        job.append('    // the next stage of the chain gets the same header')
+    if not last:
+        ro, to, vso, ko = outs[0]
+        if ko == 'cascade':
+            job += [
+                f'    aie::accum<{acc_tag[to]},{vso}> acc_header;',
+                '    acc_header.from_vector(header);',
+                f'    writeincr({ro}, acc_header);',
             ]
-
-        vecs = [f"vec_{r}" for r, _, _ in inputs]
-        ress = [f"result_{r}" for r, _, _ in outputs]
-        lines += [
-            '',
-            f'        compute_function({", ".join(vecs + ress)});',
-            ''
+        else:
+            job.append(f'    {write_stmt(ro, to, vso, ko, "header")}')
+    if with_system and persistent:
+        job += [
+            '    if (tot_iterations == JOB_SHUTDOWN)',
+            '        break;',
         ]
+    job.append('')
+    job += vector_loop(s)
+    if accumulators:
+        job += finish_step(s)
+    if framed_kernel and last:
+        # one PLIO beat with TLAST closes the frame of the job, sink_from_aie does not write it
+        for r, t, _, _ in outs:
+            trailer = plio_out_width // type_bw[t]
+            job += ['', '    // trailer: closes the output of this job (SYSTEM_FRAMED_OUTPUT)']
+            job.append(f'    writeincr({r}, ({t}) 0, true);' if trailer == 1
+                       else f'    writeincr({r}, aie::zeros<{t},{trailer}>(), true);')
+    if with_system and persistent:
+        # one kernel invocation serves every job, each one framed by its header, so back-to-back jobs pay
+        # no graph iteration. The JOB_SHUTDOWN header (see common/constants.h) makes it return
+        return [
+            '    // persistent kernel: serves the jobs back to back until the shutdown header',
+            '    while (true) {'
+        ] + [('    ' + l) if l else l for l in job] + ['    }']
+    return job
 
-        lines.append('    }')
+# buffer mode: each kernel invocation processes one whole buffer (tile). The buffers are ping-pong by default, so
+# the DMA fills the next tile while the kernel works on the current one
+def buffer_body():
+    body = []
+    if conn == 'async':
+        # async buffers are acquired once per tile, not around every vector access
+        body.append('    // lock the whole tile: the DMA keeps filling the other half of the ping-pong pair')
+        for r, _, _ in inputs + outputs:
+            body.append(f'    {r}.acquire();')
+        body.append('')
+    for r, t, vs in inputs:
+        body.append(f'    auto it_{r} = aie::begin_vector<{vs}>({r});')
+    for r, t, vs in outputs:
+        body.append(f'    auto it_{r} = aie::begin_vector<{vs}>({r});')
+    body.append('')
+    body += vector_loop(0)
+    if conn == 'async':
+        body.append('')
+        for r, _, _ in inputs + outputs:
+            body.append(f'    {r}.release();')
+    return body
 
-lines.append('}')
+lines = [
+    f'/* Auto-generated ({mode} mode) */',
+    f'#include "{header_name}"',
+    '#include "common.h"',
+    '#include "aie_api/aie.hpp"',
+    '#include "aie_api/aie_adf.hpp"',
+    '#include "aie_api/utils.hpp"',
+]
+if any(wide(t, vs, k) for ins, outs in stage_ports for _, t, vs, k in ins + outs):
+    lines += [
+        '',
+        f'// vectors wider than a stream access ({stream_access_bits} bits) take several of them, lowest elements first',
+        'template <unsigned N, typename T>',
+        'inline aie::vector<T,N> readincr_wide(input_stream<T>* restrict s)',
+        '{',
+        f'    if constexpr (N * sizeof(T) * 8 <= {stream_access_bits}) {{',
+        '        return readincr_v<N>(s);',
+        '    } else {',
+        '        aie::vector<T,N / 2> low = readincr_wide<N / 2>(s);',
+        '        aie::vector<T,N / 2> high = readincr_wide<N / 2>(s);',
+        '        return aie::concat(low, high);',
+        '    }',
+        '}',
+        '',
+        'template <unsigned N, typename T>',
+        'inline void writeincr_wide(output_stream<T>* restrict s, const aie::vector<T,N>& v)',
+        '{',
+        f'    if constexpr (N * sizeof(T) * 8 <= {stream_access_bits}) {{',
+        '        writeincr(s, v);',
+        '    } else {',
+        '        writeincr_wide(s, v.template extract<N / 2>(0));',
+        '        writeincr_wide(s, v.template extract<N / 2>(1));',
+        '    }',
+        '}',
+    ]
+for s in range(stages):
+    lines += [
+        '',
+        '// user compute stub' if stages == 1 else f'// user compute stub of stage {s + 1} of {stages}',
+        compute_defs[s],
+        '',
+        f'void {stage_kernel_name(s)}(',
+        f'                   {stage_param_str(s)}',
+        ')',
+        '{'
+    ]
+    lines += stream_body(s) if mode == 'stream' else buffer_body()
+    lines.append('}')
 
 cpp_content = '\n'.join(lines)
 
@@ -257,13 +743,18 @@ hdr = [
     '#include "aie_api/utils.hpp"',
     '#include <adf.h>',   # aggiunto
     '',
-    '// user compute prototype',
-    compute_sig + ';',
+    '// user compute prototype' if stages == 1 else '// user compute prototypes, one for each stage of the chain',
+] + [sig + ';' for sig in compute_sigs] + [
     '',
-    f'// kernel prototype ({mode} mode)',
-    f'void {kernel_name}(',
-    f'                   {param_str}',
-    ');',
+    f'// kernel prototype ({mode} mode)' if stages == 1 else f'// kernel prototypes ({mode} mode), from the first stage to the last',
+]
+for s in range(stages):
+    hdr += [
+        f'void {stage_kernel_name(s)}(',
+        f'                   {stage_param_str(s)}',
+        ');',
+    ]
+hdr += [
     '',
     f'#endif // {guard}'
 ]
@@ -271,14 +762,376 @@ hdr = [
 hdr_content = '\n'.join(hdr)
 
 # -------------------------
-# 11) Write output
+# 11) Generate graph connections
+# -------------------------
+# A helper for graph.h that connects the kernel ports to their sources and destinations, with the
+# right connection type and, in buffer mode, the buffer dimensions. With a chain it takes the kernels of the
+# stages and also connects each one to the next
+graph_name  = f"{file_name}_graph.h"
+graph_guard = f"{file_name}_graph".upper().replace('.', '_') + '_H'
+
+first_k = 'k' if stages == 1 else 'k[0]'
+last_k  = 'k' if stages == 1 else f'k[{stages - 1}]'
+conn_args = ['adf::kernel& k' if stages == 1 else f'adf::kernel (&k)[{stages}]']
+conn_args += [f"adf::port<adf::output>& src_{r}" for r, _, _ in inputs]
+conn_args += [f"adf::port<adf::input>& dst_{r}" for r, _, _ in outputs]
+conn_args += [f"adf::input_port& rtp_{name}" for name, _, _ in rtp_ports]
+conn_body = []
+for i, (r, _, _) in enumerate(inputs):
+    if mode == 'stream':
+        conn_body.append(f'    adf::connect<adf::stream>(src_{r}, {first_k}.in[{i}]);')
+    else:
+        conn_body += [
+            f'    adf::connect(src_{r}, k.in[{i}]);',
+            f'    adf::dimensions(k.in[{i}]) = {{{buffer_size}}};'
+        ]
+for s, link in enumerate(chain):
+    if link == 'cascade':
+        # the compiler places the two ends of a cascade on neighbouring tiles by itself
+        conn_body += [
+            f'    // stage {s + 1} -> {s + 2}: accumulators over the cascade, on the neighbouring tile',
+            f'    adf::connect<adf::cascade>(k[{s}].out[0], k[{s + 1}].in[0]);',
+        ]
+    else:
+        conn_body += [
+            f'    // stage {s + 1} -> {s + 2}: AIE-to-AIE stream, to the next tile of the row, with a FIFO that absorbs',
+            '    // the jitter between the two stages',
+            f'    adf::connect<adf::stream> link_{s + 1}(k[{s}].out[0], k[{s + 1}].in[0]);',
+            f'    adf::fifo_depth(link_{s + 1}) = {chain_fifo_depth};',
+            f'    adf::location<adf::kernel>(k[{s + 1}]) = adf::location<adf::kernel>(k[{s}]) + adf::relative_offset({{.col_offset = 1, .row_offset = 0}});',
+        ]
+for i, (r, _, _) in enumerate(outputs):
+    if mode == 'stream':
+        conn_body.append(f'    adf::connect<adf::stream>({last_k}.out[{i}], dst_{r});')
+    else:
+        conn_body += [
+            f'    adf::connect(k.out[{i}], dst_{r});',
+            f'    adf::dimensions(k.out[{i}]) = {{{buffer_size}}};'
+        ]
+for i, (name, _, default) in enumerate(rtp_ports):
+    port = f'{first_k}.in[{len(inputs) + i}]'
+    if default is None:
+        # synchronous: the kernel waits for a new value at every invocation
+        conn_body.append(f'    adf::connect<adf::parameter>(rtp_{name}, {port});')
+    else:
+        # asynchronous: the kernel reads the last value written, it only waits for the first one
+        conn_body.append(f'    adf::connect<adf::parameter>(rtp_{name}, adf::async({port}));')
+
+conn_sep = ',\n' + ' ' * len(f'inline void connect_{kernel_name}(')
+graph_hdr = [
+    f'/* Auto-generated ({mode} mode) */',
+    f'#ifndef {graph_guard}',
+    f'#define {graph_guard}',
+    '',
+    '#include <adf.h>',
+    '',
+]
+if stages == 1:
+    graph_hdr += [
+        f'// connects a {kernel_name} kernel: sources feed its inputs and its outputs go to the destinations,',
+        '// in the order of the kernel parameters',
+    ]
+else:
+    graph_hdr += [
+        f'// connects a chain of {stages} {kernel_name} stages: sources feed the inputs of the first stage, the outputs',
+        '// of the last one go to the destinations, and every stage feeds the next one without leaving the array',
+    ]
+if rtp_ports:
+    graph_hdr.append('// the rtp_ ports are graph input ports, written by the host with xrt::graph::update')
+if mode == 'buffer':
+    graph_hdr.append(f'// buffers of {buffer_size} elements, ping-pong (double buffered) by default')
+graph_hdr += [
+    f'inline void connect_{kernel_name}({conn_sep.join(conn_args)})',
+    '{',
+] + conn_body + [
+    '}',
+    '',
+    f'#endif // {graph_guard}'
+]
+
+graph_content = '\n'.join(graph_hdr)
+
+# -------------------------
+# 12) Generate the system configuration
+# -------------------------
+# common/system_config.h is included by common/constants.h, so the PL movers, the graph and the host code
+# all see the same shape of the system
+if with_system:
+    repo_root   = os.path.join('..', '..', '..')
+    system_name = os.path.join(repo_root, 'common', 'system_config.h')
+    system_hdr = [
+        '/* Auto-generated by aie/src/template_generator/gen_template.py from the [system] section of kernel.cfg */',
+        '#ifndef SYSTEM_CONFIG_H',
+        '#define SYSTEM_CONFIG_H',
+        '',
+        '// Number of data-parallel lanes. Each lane is one AIE kernel with its own pair of PLIOs: setup_aie deals the',
+        '// PLIO beats round-robin to the lanes (beat b goes to lane b % CU_LANES), sink_from_aie collects them back',
+        '// in the same order. Must be a power of two',
+        f'#define NUM_LANES {lanes}',
+        '',
+        '// Number of setup_aie/sink_from_aie pairs (compute units setup_aie_<c>, sink_from_aie_<c>). Pair c moves its own',
+        '// runs on its own banks and lanes c * CU_LANES ... (c + 1) * CU_LANES - 1 (see common/common.h)',
+        f'#define SYSTEM_COMPUTE_UNITS {compute_units}',
+        '',
+        '// Number of m_axi ports of each mover, one per memory bank. The buffers are striped over them: port p moves',
+        '// the contiguous slice p of the buffer (size / SYSTEM_MEM_PORTS elements) and feeds its own group of',
+        '// CU_LANES / SYSTEM_MEM_PORTS lanes, dealing the beats of the slice round-robin to them',
+        f'#define SYSTEM_MEM_PORTS {mem_ports}',
+        '',
+        '// width in bits of the input PLIOs (setup_aie streams) and of the output PLIOs (sink_from_aie streams)',
+        f'#define SYSTEM_PLIO_IN_WIDTH {plio_in_width}',
+        f'#define SYSTEM_PLIO_OUT_WIDTH {plio_out_width}',
+        '',
+        f'// type of the elements moved by setup_aie and sink_from_aie and of the host buffers (data_t in constants.h),',
+        f'// the kernel sees them as {in_t}',
+        f'#define SYSTEM_DATA_T {pl_type[in_t]}',
+        f'#define SYSTEM_DATA_BITS {data_bits}',
+        '',
+        '// bits of the vector the kernel reads at each iteration, a multiple of SYSTEM_PLIO_IN_WIDTH',
+        f'#define SYSTEM_VECTOR_BITS {vector_bits}',
+        '// 1 when each lane starts with a header vector holding its number of iterations (stream mode kernels)',
+        f'#define SYSTEM_STREAM_HEADER {1 if mode == "stream" and control == "header" else 0}',
+        '// 1 when each lane gets its number of iterations from the synchronous RTP aie_graph.iterations[lane] instead',
+        '// (see lane_iterations() in common/common.h)',
+        f'#define SYSTEM_RTP_ITERATIONS {1 if control == "rtp" else 0}',
+        '// asynchronous RTP parameters of the kernel, X(name, type, default): the graph ports are aie_graph.name[lane]',
+        '#define SYSTEM_RTP_PARAMS(X)' + ''.join(f' X({n}, {t}, {d})' for n, t, d in rtp_params),
+        '// 1 when the graph is persistent: the host starts one graph iteration whose kernels serve every job, until',
+        '// the JOB_SHUTDOWN header (see sw/graph_control.hpp)',
+        f'#define SYSTEM_PERSISTENT_GRAPH {1 if persistent else 0}',
+        '// 1 when setup_aie and sink_from_aie keep performance counters and write them to a stats buffer at the end',
+        '// of each run (see the STATS_* fields in common/common.h)',
+        f'#define SYSTEM_MOVER_STATS {1 if stats else 0}',
+        '// 1 when the kernels decide how many elements they output: each lane ends every job with a trailer beat',
+        '// carrying TLAST and sink_from_aie reports the elements it wrote (see fpga/sink_from_aie.hpp)',
+        f'#define SYSTEM_FRAMED_OUTPUT {1 if framed else 0}',
+        '// 1 when every run of setup_aie and sink_from_aie moves a table of jobs, its size argument counting the jobs',
+        '// (see the JOB_* fields in common/common.h)',
+        f'#define SYSTEM_JOB_DESCRIPTORS {1 if descriptors else 0}',
+        '// 1 when setup_aie and sink_from_aie are started once and serve a command ring of job descriptors until its',
+        '// stop command, their size argument counting the slots of the ring (see the RING_* fields in common/common.h)',
+        f'#define SYSTEM_FREE_RUNNING {1 if free_running else 0}',
+        '// 1 when the lanes of each memory port share one input and one output PLIO: setup_aie sends every buffer of',
+        '// SYSTEM_PACKET_ELEMENTS elements as a packet to one lane, through a pktsplit of the graph, and sink_from_aie',
+        '// puts the packets of the pktmerge back in place by their packet id (see fpga/packet_header.hpp)',
+        f'#define SYSTEM_PACKET_SWITCHING {1 if packet_switching else 0}',
+        f'#define SYSTEM_PACKET_ELEMENTS {buffer_size if packet_switching else 0}',
+        '',
+        '// the number of elements of each run must be a multiple of this, so that every slice is the same size, every',
+        '// lane gets whole vectors (or whole buffers) and every output beat is full',
+        f'#define SYSTEM_SIZE_ALIGN {size_align}',
+        '',
+        '// memory banks of the slices of the input and output buffers, one per port of each compute unit, unit by unit',
+        '// (sp lines of linking/xclbin_overlay.cfg)',
+        f'#define SYSTEM_INPUT_BANKS "{",".join(input_banks)}"',
+        f'#define SYSTEM_OUTPUT_BANKS "{",".join(output_banks)}"',
+        '',
+        '#endif // SYSTEM_CONFIG_H',
+        ''
+    ]
+    system_content = '\n'.join(system_hdr)
+
+# -------------------------
+# 13) Generate graph.h
+# -------------------------
+# NUM_LANES copies of the kernel (or of the chain of stages), each one between its own pair of PLIOs, wired by the
+# connect helper of section 11
+license_header = """/*
+MIT License
+
+Copyright (c) 2023 Paolo Salvatore Galfano, Giuseppe Sorrentino
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+"""
+
+if with_system:
+    graph_h_name = os.path.join('..', 'graph.h')
+    rtp_decl = ''
+    if rtp_ports:
+        rtp_decl = '\n  // ------Runtime parameter (RTP) ports, one for each lane------\n'
+        rtp_decl += ''.join(f'  input_port {name}[NUM_LANES];\n' for name, _, _ in rtp_ports)
+    rtp_args = ''.join(f', {name}[i]' for name, _, _ in rtp_ports)
+    if stages == 1:
+        kernel_decl = f'''  // one kernel for each lane, all running the same function on different
+  // slices of the data (see NUM_LANES in common/system_config.h)
+  kernel {file_name}[NUM_LANES];'''
+        kernel_create = f'''      {file_name}[i] = kernel::create(
+          {kernel_name}); // the input is the kernel function name'''
+        kernel_setup = f'''      // set kernel source and headers
+      source({file_name}[i]) = "src/{cpp_name}";
+      headers({file_name}[i]) = {{"src/{header_name}",
+                                 "../common/common.h"}}; // you can specify more than
+                                                        // one header to include
+
+      // set ratio
+      runtime<ratio>({file_name}[i]) =
+          0.9; // 90% of the time the kernel will be executed. This means that 1
+               // AIE will be able to execute just 1 Kernel, so every lane gets its own tile'''
+    else:
+        kernel_decl = f'''  // one chain of {stages} kernels for each lane (stages in kernel.cfg), every chain
+  // running the same stages on different slices of the data (see NUM_LANES in
+  // common/system_config.h)
+  kernel {file_name}[NUM_LANES][{stages}];'''
+        kernel_create = '\n'.join(f'''      {file_name}[i][{s}] = kernel::create({stage_kernel_name(s)});''' for s in range(stages))
+        kernel_setup = f'''      // set kernel source and headers, and a ratio of 0.9 so that every stage
+      // gets its own tile: the chain then runs at the rate of its slowest stage
+      for (int s = 0; s < {stages}; s++) {{
+        source({file_name}[i][s]) = "src/{cpp_name}";
+        headers({file_name}[i][s]) = {{"src/{header_name}", "../common/common.h"}};
+        runtime<ratio>({file_name}[i][s]) = 0.9;
+      }}'''
+    if not packet_switching:
+        graph_body = f'''public:
+  // ------Input and Output PLIO declaration------
+
+  input_plio in[NUM_LANES];
+  output_plio out[NUM_LANES];
+{rtp_decl}
+  my_graph() {{
+    for (int i = 0; i < NUM_LANES; i++) {{
+      // ------kernel creation------
+{kernel_create}
+
+      // ------Input and Output PLIO creation------
+      // I argument: a name, that will be used to refer to the port in the block
+      // design II argument: the type of the PLIO that will be read/written. Test
+      // both plio_32_bits and plio_128_bits to verify the difference III
+      // argument: the path to the file that will be read/written for simulation
+      // The widths match the streams of setup_aie ({plio_in_width} bits) and
+      // sink_from_aie ({plio_out_width} bits), both set in the [system] section of kernel.cfg.
+      // Lane i uses in_plio_<i+1> and out_plio_<i+1>, the names used by
+      // the stream_connect lines of linking/xclbin_overlay.cfg
+
+      in[i] = input_plio::create("in_plio_" + std::to_string(i + 1), plio_{plio_in_width}_bits,
+                                 "data/in_plio_source_" + std::to_string(i + 1) + ".txt");
+      out[i] = output_plio::create("out_plio_" + std::to_string(i + 1), plio_{plio_out_width}_bits,
+                                   "data/out_plio_sink_" + std::to_string(i + 1) + ".txt");
+
+      // ------kernel connection------
+      // generated together with the kernel by the template generator, so the
+      // connection (stream or buffer, with its size) always matches the kernel
+      // signature. Change "mode" in template_generator/kernel.cfg to switch
+      connect_{kernel_name}({file_name}[i], in[i].out[0], out[i].in[0]{rtp_args});
+{kernel_setup}
+    }}
+'''
+    else:
+        # the lanes of every memory port share its pair of PLIOs: a pktsplit deals the packets sent by setup_aie to
+        # the kernels by their packet id, a pktmerge gathers their output packets for sink_from_aie
+        graph_body = f'''public:
+  // ------Input and Output PLIO declaration------
+  // one pair of PLIOs for each memory port (NUM_PLIOS in common/common.h),
+  // shared by its PORT_LANES lanes through packet switching
+
+  input_plio in[NUM_PLIOS];
+  output_plio out[NUM_PLIOS];
+  pktsplit<PORT_LANES> split[NUM_PLIOS];
+  pktmerge<PORT_LANES> merge[NUM_PLIOS];
+{rtp_decl}
+  my_graph() {{
+    for (int p = 0; p < NUM_PLIOS; p++) {{
+      // ------Input and Output PLIO creation------
+      // The widths match the streams of setup_aie ({plio_in_width} bits) and
+      // sink_from_aie ({plio_out_width} bits), both set in the [system] section of kernel.cfg.
+      // Port p uses in_plio_<p+1> and out_plio_<p+1>, the names used by
+      // the stream_connect lines of linking/xclbin_overlay.cfg
+
+      in[p] = input_plio::create("in_plio_" + std::to_string(p + 1), plio_{plio_in_width}_bits,
+                                 "data/in_plio_source_" + std::to_string(p + 1) + ".txt");
+      out[p] = output_plio::create("out_plio_" + std::to_string(p + 1), plio_{plio_out_width}_bits,
+                                   "data/out_plio_sink_" + std::to_string(p + 1) + ".txt");
+
+      // ------Packet switching------
+      // output k of the pktsplit takes the packets with id k, and the pktmerge
+      // stamps the packets of its input k with id k (listed by the compiler
+      // in Work/temp/packet_ids_c.h)
+      split[p] = pktsplit<PORT_LANES>::create();
+      merge[p] = pktmerge<PORT_LANES>::create();
+      connect<pktstream>(in[p].out[0], split[p].in[0]);
+      connect<pktstream>(merge[p].out[0], out[p].in[0]);
+    }}
+
+    for (int i = 0; i < NUM_LANES; i++) {{
+      // ------kernel creation------
+{kernel_create}
+
+      // ------kernel connection------
+      // lane i is destination i % PORT_LANES of the PLIOs of its memory port:
+      // the tile DMA fills its buffers from the packets with that id, and
+      // sends every output buffer as a packet with the same id
+      connect_{kernel_name}({file_name}[i], split[i / PORT_LANES].out[i % PORT_LANES],
+          merge[i / PORT_LANES].in[i % PORT_LANES]{rtp_args});
+{kernel_setup}
+    }}
+'''
+    graph_h_content = license_header + f'''
+// Auto-generated by template_generator/gen_template.py from kernel.cfg
+
+#pragma once
+#include "{header_name}"
+#include "{graph_name}"
+#include <adf.h>
+#include <string>
+
+using namespace adf;
+
+class my_graph : public graph {{
+
+private:
+  // ------kernel declaration------
+{kernel_decl}
+
+{graph_body}  }};
+}};
+'''
+
+# -------------------------
+# 14) Generate the linker configuration
+# -------------------------
+# linking/gen_connectivity.py owns the format of xclbin_overlay.cfg, it is loaded from its folder
+if with_system:
+    conn_path = os.path.join(repo_root, 'linking', 'gen_connectivity.py')
+    spec = importlib.util.spec_from_file_location('gen_connectivity', conn_path)
+    gen_connectivity = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(gen_connectivity)
+    cfg_name = os.path.join(repo_root, 'linking', 'xclbin_overlay.cfg')
+    cfg_content = gen_connectivity.build_cfg(lanes, plio_in_width, plio_out_width, input_banks, output_banks, stats, framed, descriptors,
+                                             compute_units, packet_switching)
+
+# -------------------------
+# 15) Write output
 # -------------------------
 out_cpp    = os.path.join('..', cpp_name)
 out_header = os.path.join('..', header_name)
+out_graph  = os.path.join('..', graph_name)
 
 os.makedirs(os.path.dirname(out_cpp) or '..', exist_ok=True)
 
 with open(out_cpp, 'w') as f: f.write(cpp_content)
 with open(out_header, 'w') as f: f.write(hdr_content)
+with open(out_graph, 'w') as f: f.write(graph_content)
+
+print(f"Generated ({mode} mode):\n - {out_cpp}\n - {out_header}\n - {out_graph}")
 
-print(f"Generated ({mode} mode):\n - {out_cpp}\n - {out_header}")
+if with_system:
+    with open(system_name, 'w') as f: f.write(system_content)
+    with open(graph_h_name, 'w') as f: f.write(graph_h_content)
+    with open(cfg_name, 'w') as f: f.write(cfg_content)
+    print(f"Generated the system for {lanes} lane(s):\n - {system_name}\n - {graph_h_name}\n - {cfg_name}")
@@ -0,0 +1,96 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Kernel of the library under test (see make test_kernel in aie/Makefile, which writes test_select.h with the
+// TEST_<KERNEL> define), with its types, sizes and constants: shared by the AIE kernel (test_kernels.cpp) and the
+// generator and checker of the simulation data (test_data.cpp). The kernel runs once on TEST_INPUTS vectors of
+// TEST_IN_ELEMENTS elements, and writes TEST_OUTPUTS vectors of TEST_OUT_ELEMENTS elements
+#ifndef TEST_CONFIG_H
+#define TEST_CONFIG_H
+
+#include <cstdint>
+#include "test_select.h"
+
+#if defined(TEST_MAP)
+// scale by 3/2, then relu
+typedef int16_t test_t;
+#define TEST_IN_ELEMENTS 16
+#define TEST_OUT_ELEMENTS 16
+#define TEST_INPUTS 256
+#define TEST_OUTPUTS 256
+#define TEST_FACTOR 3
+#define TEST_SHIFT 1
+#elif defined(TEST_REDUCE)
+// sum of every block of 4 vectors
+typedef int32_t test_t;
+#define TEST_IN_ELEMENTS 8
+#define TEST_OUT_ELEMENTS 8
+#define TEST_BLOCK 4
+#define TEST_INPUTS 256
+#define TEST_OUTPUTS (TEST_INPUTS / TEST_BLOCK)
+#elif defined(TEST_FIR)
+// 20 taps: the window reaches two vectors back
+typedef int16_t test_t;
+#define TEST_IN_ELEMENTS 16
+#define TEST_OUT_ELEMENTS 16
+#define TEST_TAPS 20
+#define TEST_TAP(k) ((int) ((k) * 5 % 11) - 5)
+#define TEST_INPUTS 256
+#define TEST_OUTPUTS 256
+#define TEST_SHIFT 2
+#elif defined(TEST_CONV2D)
+// 3 x 3 window on a 64 x 64 image
+typedef int16_t test_t;
+#define TEST_IN_ELEMENTS 16
+#define TEST_OUT_ELEMENTS 16
+#define TEST_WIDTH 64
+#define TEST_HEIGHT 64
+#define TEST_KH 3
+#define TEST_KW 3
+#define TEST_WEIGHT(i, j) ((int) (((i) * 3 + (j)) * 7 % 9) - 4)
+#define TEST_INPUTS (TEST_WIDTH * TEST_HEIGHT / TEST_IN_ELEMENTS)
+#define TEST_OUTPUTS TEST_INPUTS
+#define TEST_SHIFT 3
+#elif defined(TEST_GEMM)
+// C (128 x 4) = A (128 x 16) * B (16 x 4), in 4 x 4 x 4 tiles, 4 along the depth
+typedef int16_t test_t;
+#define TEST_M 4
+#define TEST_K 4
+#define TEST_N 4
+#define TEST_KT 4
+#define TEST_ROWS 128
+#define TEST_B(k, n) ((int) (((k) * TEST_N + (n)) * 5 % 17) - 8)
+#define TEST_IN_ELEMENTS (TEST_M * TEST_K * TEST_KT)
+#define TEST_OUT_ELEMENTS (TEST_M * TEST_N)
+#define TEST_INPUTS (TEST_ROWS / TEST_M)
+#define TEST_OUTPUTS TEST_INPUTS
+#define TEST_SHIFT 2
+#else
+#error "no kernel selected: make test_kernel kernel=<map|reduce|fir|conv2d|gemm>"
+#endif
+
+// input samples, small enough to leave no room for saturation in the accumulators
+#define TEST_INPUT(i) ((int) ((uint32_t) (i) * 2654435761u >> 26) - 32)
+
+#endif // TEST_CONFIG_H
@@ -0,0 +1,159 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "test_config.h"
+#include "kernels/golden.hpp"
+
+// Data of the test of a kernel of the library (see test_config.h and make test_kernel):
+//     test_data gen <DIR>                      writes the input of the kernel, <DIR>/test_in.txt, and the output
+//                                              of its golden model, <DIR>/test_golden.txt
+//     test_data check <DIR> <OUTPUT> [MHZ]     compares the output of a simulation with the golden one; with the
+//                                              timestamps of aiesimulator it also gives the cycles per output
+//                                              sample, at an AI Engine clock of MHZ (1250 by default)
+
+#define ELEMENTS_PER_LINE (128 / (8 * (int) sizeof(test_t)))
+
+static std::vector<test_t> test_input() {
+    std::vector<test_t> x(TEST_INPUTS * TEST_IN_ELEMENTS);
+    for (size_t i = 0; i < x.size(); i++)
+        x[i] = TEST_INPUT(i);
+    return x;
+}
+
+// output of the golden model on the input, and the input in the order the kernel reads it
+static std::vector<test_t> golden(std::vector<test_t>& x) {
+    using namespace voted::golden;
+    std::vector<test_t> y(TEST_OUTPUTS * TEST_OUT_ELEMENTS);
+#if defined(TEST_MAP)
+    for (size_t i = 0; i < x.size(); i++)
+        y[i] = relu(scale<test_t>(x[i], TEST_FACTOR, TEST_SHIFT));
+#elif defined(TEST_REDUCE)
+    reduce(reduce_op::add, x.data(), y.data(), TEST_OUTPUTS, TEST_BLOCK, TEST_IN_ELEMENTS);
+#elif defined(TEST_FIR)
+    test_t taps[TEST_TAPS];
+    for (int k = 0; k < TEST_TAPS; k++)
+        taps[k] = TEST_TAP(k);
+    fir(x.data(), y.data(), x.size(), taps, TEST_SHIFT);
+#elif defined(TEST_CONV2D)
+    test_t weights[TEST_KH][TEST_KW];
+    for (int i = 0; i < TEST_KH; i++)
+        for (int j = 0; j < TEST_KW; j++)
+            weights[i][j] = TEST_WEIGHT(i, j);
+    conv2d(x.data(), y.data(), TEST_HEIGHT, TEST_WIDTH, weights, TEST_SHIFT);
+#elif defined(TEST_GEMM)
+    // x is A, row-major: the kernel reads its tiles
+    std::vector<test_t> b(TEST_K * TEST_KT * TEST_N);
+    for (int k = 0; k < TEST_K * TEST_KT; k++)
+        for (int n = 0; n < TEST_N; n++)
+            b[k * TEST_N + n] = TEST_B(k, n);
+    gemm(x.data(), b.data(), y.data(), TEST_ROWS, TEST_K * TEST_KT, TEST_N, TEST_SHIFT);
+    std::vector<test_t> tiles(x.size());
+    gemm_tiles(x.data(), tiles.data(), TEST_ROWS, TEST_K * TEST_KT, TEST_M, TEST_K);
+    x = tiles;
+#endif
+    return y;
+}
+
+static void write_lines(const std::string& path, const std::vector<test_t>& v) {
+    std::ofstream file(path);
+    for (size_t i = 0; i < v.size(); i++)
+        file << (int) v[i] << ((i + 1) % ELEMENTS_PER_LINE ? " " : "\n");
+}
+
+static int check(const std::string& dir, const std::string& output, double mhz) {
+    std::ifstream golden_file(dir + "/test_golden.txt"), file(output);
+    if (!golden_file || !file) {
+        std::cout << "ERROR: could not open " << dir << "/test_golden.txt or " << output << std::endl;
+        return 1;
+    }
+    std::vector<long> expected, got;
+    for (long v; golden_file >> v;)
+        expected.push_back(v);
+    // lines of samples, and with aiesimulator 'T <time> <unit>' before them (and TLAST, not used here)
+    double first_ns = -1, last_ns = -1;
+    size_t first_sample = 0, last_sample = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string head;
+        if (!(fields >> head))
+            continue;
+        if (head == "T") {
+            double t;
+            std::string unit;
+            fields >> t >> unit;
+            const double ns = unit == "ps" ? t / 1000 : unit == "us" ? t * 1000 : t;
+            if (first_ns < 0) {
+                first_ns = ns;
+                first_sample = got.size();
+            }
+            last_ns = ns;
+            last_sample = got.size();
+            continue;
+        }
+        if (head == "TLAST")
+            continue;
+        got.push_back(std::strtol(head.c_str(), nullptr, 10));
+        for (long v; fields >> v;)
+            got.push_back(v);
+    }
+
+    size_t errors = 0;
+    for (size_t i = 0; i < expected.size() && i < got.size(); i++)
+        if (got[i] != expected[i] && errors++ < 10)
+            std::cout << "sample " << i << ": " << got[i] << ", expected " << expected[i] << std::endl;
+    if (got.size() != expected.size())
+        std::cout << got.size() << " samples, expected " << expected.size() << std::endl;
+    if (errors || got.size() != expected.size()) {
+        std::cout << "FAILED: " << errors << " wrong samples" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED: " << got.size() << " samples match the golden model" << std::endl;
+    if (last_sample > first_sample)
+        std::cout << "cycles per output sample: " << (last_ns - first_ns) * mhz / 1000 / (last_sample - first_sample)
+                  << " (" << mhz << " MHz)" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const std::string mode = argc > 2 ? argv[1] : "";
+    if (mode == "gen" && argc == 3) {
+        std::vector<test_t> x = test_input();
+        std::vector<test_t> y = golden(x);
+        write_lines(std::string(argv[2]) + "/test_in.txt", x);
+        write_lines(std::string(argv[2]) + "/test_golden.txt", y);
+        return 0;
+    }
+    if (mode == "check" && (argc == 4 || argc == 5))
+        return check(argv[2], argv[3], argc == 5 ? std::atof(argv[4]) : 1250);
+    std::cerr << "Usage: " << argv[0] << " gen <DIR>" << std::endl
+              << "       " << argv[0] << " check <DIR> <OUTPUT> [MHZ]" << std::endl;
+    return 1;
+}
@@ -0,0 +1,58 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <adf.h>
+#include "test_kernels.h"
+
+using namespace adf;
+
+// One kernel of the library between two 128-bit PLIOs, fed and checked by test_data (see make test_kernel)
+class test_graph : public graph {
+private:
+    kernel k;
+
+public:
+    input_plio in;
+    output_plio out;
+
+    test_graph() {
+        k = kernel::create(test_kernel);
+        in = input_plio::create("test_in", plio_128_bits, "data/test_in.txt");
+        out = output_plio::create("test_out", plio_128_bits, "data/test_out.txt");
+        connect<stream>(in.out[0], k.in[0]);
+        connect<stream>(k.out[0], out.in[0]);
+        source(k) = "test/test_kernels.cpp";
+        runtime<ratio>(k) = 0.9;
+    }
+};
+
+test_graph kernel_test;
+
+int main(int argc, char ** argv)
+{
+    kernel_test.init();
+    kernel_test.run(1);
+    kernel_test.end();
+    return 0;
+}
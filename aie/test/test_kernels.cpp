@@ -0,0 +1,140 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test_kernels.h"
+#include "aie_api/aie.hpp"
+#include "aie_api/aie_adf.hpp"
+#include "kernels/kernels.hpp"
+
+// a stream access moves 128 bits: wider vectors take several of them, lowest elements first
+template <unsigned N, typename T>
+static aie::vector<T,N> read_vector(input_stream<T>* restrict s)
+{
+    if constexpr (N * sizeof(T) * 8 <= 128) {
+        return readincr_v<N>(s);
+    } else {
+        aie::vector<T,N / 2> low = read_vector<N / 2>(s);
+        aie::vector<T,N / 2> high = read_vector<N / 2>(s);
+        return aie::concat(low, high);
+    }
+}
+
+template <unsigned N, typename T>
+static void write_vector(output_stream<T>* restrict s, const aie::vector<T,N>& v)
+{
+    if constexpr (N * sizeof(T) * 8 <= 128) {
+        writeincr(s, v);
+    } else {
+        write_vector(s, v.template extract<N / 2>(0));
+        write_vector(s, v.template extract<N / 2>(1));
+    }
+}
+
+typedef aie::vector<test_t,TEST_IN_ELEMENTS> in_vector;
+typedef aie::vector<test_t,TEST_OUT_ELEMENTS> out_vector;
+
+// the kernel under test, as a compute_function: false when it writes nothing for this input
+#if defined(TEST_MAP)
+static void init() {}
+
+static bool compute(const in_vector& in, out_vector& out)
+{
+    voted::map(in, out, voted::scale<test_t>{TEST_FACTOR, TEST_SHIFT}, voted::relu{});
+    return true;
+}
+#elif defined(TEST_REDUCE)
+static voted::reduce<voted::reduce_op::add, test_t, TEST_IN_ELEMENTS, TEST_BLOCK> block_sum;
+
+static void init() {}
+
+static bool compute(const in_vector& in, out_vector& out)
+{
+    return block_sum(in, out);
+}
+#elif defined(TEST_FIR)
+static voted::fir<test_t, TEST_IN_ELEMENTS, TEST_TAPS> filter;
+static test_t taps[TEST_TAPS];
+
+static void init()
+{
+    for (int k = 0; k < TEST_TAPS; k++)
+        taps[k] = TEST_TAP(k);
+}
+
+static bool compute(const in_vector& in, out_vector& out)
+{
+    filter(in, out, taps, TEST_SHIFT);
+    return true;
+}
+#elif defined(TEST_CONV2D)
+static voted::conv2d<test_t, TEST_IN_ELEMENTS, TEST_WIDTH, TEST_KH, TEST_KW> window;
+static test_t weights[TEST_KH][TEST_KW];
+
+static void init()
+{
+    for (int i = 0; i < TEST_KH; i++)
+        for (int j = 0; j < TEST_KW; j++)
+            weights[i][j] = TEST_WEIGHT(i, j);
+}
+
+static bool compute(const in_vector& in, out_vector& out)
+{
+    window(in, out, weights, TEST_SHIFT);
+    return true;
+}
+#elif defined(TEST_GEMM)
+// B has TEST_N columns, so its tiles are its rows in order
+alignas(aie::vector_decl_align) static test_t b[TEST_K * TEST_KT * TEST_N];
+
+static void init()
+{
+    for (int k = 0; k < TEST_K * TEST_KT; k++)
+        for (int n = 0; n < TEST_N; n++)
+            b[k * TEST_N + n] = TEST_B(k, n);
+}
+
+static bool compute(const in_vector& in, out_vector& out)
+{
+    voted::gemm<TEST_M, TEST_K, TEST_N, TEST_KT>(in, out, b, TEST_SHIFT);
+    return true;
+}
+#endif
+
+void test_kernel(input_stream<test_t>* restrict in, output_stream<test_t>* restrict out)
+{
+    // the rounding and saturation of the golden models (see kernels/golden.hpp)
+    aie::set_rounding(aie::rounding_mode::floor);
+    aie::set_saturation(aie::saturation_mode::saturate);
+    init();
+
+    for (int i = 0; i < TEST_INPUTS; i++)
+        chess_prepare_for_pipelining
+    {
+        in_vector v = read_vector<TEST_IN_ELEMENTS>(in);
+        out_vector r;
+
+        if (compute(v, r))
+            write_vector(out, r);
+    }
+}
@@ -25,3 +25,86 @@ SOFTWARE.
 #pragma once
 #include "constants.h"
 
+// Helpers to expand macros inside HLS pragmas, e.g. DO_PRAGMA(HLS stream variable=s depth=MY_DEPTH)
+#define PRAGMA_SUB(x) _Pragma(#x)
+#define DO_PRAGMA(x) PRAGMA_SUB(x)
+
+// One buffer argument for each of the SYSTEM_MEM_PORTS memory ports of a mover: MEM_PORT_PARAMS declares them
+// (name, name_1, name_2, ...), MEM_PORT_NAMES passes them on to a function and MEM_PORT_ARGS passes the elements
+// of an array of buffers, e.g. in a testbench
+#if SYSTEM_MEM_PORTS == 1
+#define MEM_PORT_PARAMS(type, name) type name
+#define MEM_PORT_NAMES(name) name
+#define MEM_PORT_ARGS(a) a[0]
+#elif SYSTEM_MEM_PORTS == 2
+#define MEM_PORT_PARAMS(type, name) type name, type name##_1
+#define MEM_PORT_NAMES(name) name, name##_1
+#define MEM_PORT_ARGS(a) a[0], a[1]
+#elif SYSTEM_MEM_PORTS == 4
+#define MEM_PORT_PARAMS(type, name) type name, type name##_1, type name##_2, type name##_3
+#define MEM_PORT_NAMES(name) name, name##_1, name##_2, name##_3
+#define MEM_PORT_ARGS(a) a[0], a[1], a[2], a[3]
+#else
+#error "SYSTEM_MEM_PORTS must be 1, 2 or 4"
+#endif
+// Lanes of each compute unit (pair of movers, see SYSTEM_COMPUTE_UNITS), i.e. streams of setup_aie and
+// sink_from_aie, and lanes of each of their memory ports. Lane l of the graph belongs to unit l / CU_LANES
+#define CU_LANES (NUM_LANES / SYSTEM_COMPUTE_UNITS)
+#define PORT_LANES (CU_LANES / SYSTEM_MEM_PORTS)
+// Streams of each compute unit, i.e. pairs of PLIOs: one per lane, or with SYSTEM_PACKET_SWITCHING one per memory
+// port, shared by the PORT_LANES lanes of the port (stream p of a unit then carries the packets of its port p)
+#if SYSTEM_PACKET_SWITCHING
+#define CU_PLIOS SYSTEM_MEM_PORTS
+#else
+#define CU_PLIOS CU_LANES
+#endif
+#define NUM_PLIOS (CU_PLIOS * SYSTEM_COMPUTE_UNITS)
+
+// Number of kernel iterations of a lane for a job of the given number of elements: the memory port of the lane
+// moves elements / SYSTEM_MEM_PORTS of them, setup_aie deals their beats round-robin to the PORT_LANES lanes of
+// the port and each iteration reads SYSTEM_VECTOR_BITS bits. It is the value of the lane header, or of the
+// iterations RTP of the lane with SYSTEM_RTP_ITERATIONS
+inline int lane_iterations(long elements, int lane) {
+    const long beats = elements / SYSTEM_MEM_PORTS * SYSTEM_DATA_BITS / SYSTEM_PLIO_IN_WIDTH;
+    const int l = lane % PORT_LANES;
+    return (beats / PORT_LANES + (l < beats % PORT_LANES ? 1 : 0)) / (SYSTEM_VECTOR_BITS / SYSTEM_PLIO_IN_WIDTH);
+}
+
+// Performance counters of the movers (SYSTEM_MOVER_STATS). At the end of each run setup_aie and sink_from_aie
+// write one record of STATS_FIELDS 64-bit counters per memory port to their stats buffer (record p, i.e. 64
+// bytes at offset 64 * p, for port p). The counters belong to the stage on the AIE side of the port
+// (distribute/collect), which runs one iteration per cycle, and count from its first round:
+#define STATS_CYCLES        0 // cycles from the first round to the last beat
+#define STATS_BEATS         1 // PLIO beats moved on the streams of the port
+#define STATS_STALL_STREAM  2 // cycles lost on the AIE side: setup_aie found a lane full, sink_from_aie a lane empty
+#define STATS_STALL_MEMORY  3 // cycles lost on the memory side: the reader had no word ready, or the writer FIFO was full
+#define STATS_FIRST_BEAT    4 // cycle of the first beat
+#define STATS_LAST_BEAT     5 // cycle of the last beat
+#define STATS_WORDS         6 // 512-bit words read or written by the port
+#define STATS_FIELDS        8 // the last field is reserved
+
+// Job descriptors (SYSTEM_JOB_DESCRIPTORS). A run of setup_aie and sink_from_aie then moves a table of jobs instead
+// of one contiguous job: their size argument is the number of descriptors, each one JOB_FIELDS 32-bit fields
+// (16 bytes at offset 16 * j for job j). Every job is striped over the memory ports like a whole run: port p moves
+// elements / SYSTEM_MEM_PORTS of them, starting at the given 512-bit word of its own buffer, and every lane gets
+// a header for each job
+#define JOB_INPUT   0 // first 512-bit word of the job in the input buffer of every memory port
+#define JOB_SIZE    1 // elements of the job, a multiple of SYSTEM_SIZE_ALIGN
+#define JOB_OUTPUT  2 // first 512-bit word of the job in the output buffer of every memory port
+#define JOB_FIELDS  4 // the last field is reserved
+
+// Command ring of the free-running movers (SYSTEM_FREE_RUNNING). Each mover is started once, with the number of
+// command slots of its ring as size and the ring buffer as job table, and serves the ring until the stop command.
+// The ring is made of entries of JOB_FIELDS 32-bit fields (16 bytes): the host writes the job descriptors in the
+// command slots and counts them in the first field of RING_HEAD, the mover counts the jobs it completed in the
+// first field of RING_TAIL and writes a completion record for each in the completion slots, that follow the
+// command slots. Job n is in slot n % slots of both. The host and the mover never write the same 64-byte line,
+// so that a sync from one side never overwrites the other: the slots are a multiple of RING_LINE
+#define RING_LINE      4 // entries of a 64-byte line
+#define RING_HEAD      0
+#define RING_TAIL      RING_LINE
+#define RING_COMMANDS  (2 * RING_LINE) // first command slot
+#define RING_ENTRIES(slots) (RING_COMMANDS + 2 * (slots))
+#define RING_DONE_JOB  0 // fields of a completion record: the number of the job...
+#define RING_DONE_SIZE 1 // ...and the elements moved
+#define RING_STOP      0xFFFFFFFFu // size of the stop command, after which the mover returns
@@ -26,7 +26,19 @@ SOFTWARE.
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
-typedef float data_t;
+#include <cstdint>
+
+// Shape of the system around the AIE kernel (NUM_LANES, PLIO widths, ...), generated together with the kernel,
+// aie/src/graph.h and linking/xclbin_overlay.cfg by aie/src/template_generator/gen_template.py
+#include "system_config.h"
+
+// Type of the elements moved by the PL kernels and of the host buffers: the input type of the generated kernel
+// (raw 16-bit words for bfloat16). The beats carry SYSTEM_PLIO_*_WIDTH / (8 * sizeof(data_t)) elements each
+typedef SYSTEM_DATA_T data_t;
 #define CONSTANT_1 32
 
+// Header value that ends a persistent kernel (SYSTEM_PERSISTENT_GRAPH): setup_aie sends it to every lane when
+// it is called with a negative size, after the jobs already queued
+#define JOB_SHUTDOWN (-1)
+
 #endif
@@ -0,0 +1,67 @@
+/* Auto-generated by aie/src/template_generator/gen_template.py from the [system] section of kernel.cfg */
+#ifndef SYSTEM_CONFIG_H
+#define SYSTEM_CONFIG_H
+
+// Number of data-parallel lanes. Each lane is one AIE kernel with its own pair of PLIOs: setup_aie deals the
+// PLIO beats round-robin to the lanes (beat b goes to lane b % CU_LANES), sink_from_aie collects them back
+// in the same order. Must be a power of two
+#define NUM_LANES 1
+
+// Number of setup_aie/sink_from_aie pairs (compute units setup_aie_<c>, sink_from_aie_<c>). Pair c moves its own
+// runs on its own banks and lanes c * CU_LANES ... (c + 1) * CU_LANES - 1 (see common/common.h)
+#define SYSTEM_COMPUTE_UNITS 1
+
+// Number of m_axi ports of each mover, one per memory bank. The buffers are striped over them: port p moves
+// the contiguous slice p of the buffer (size / SYSTEM_MEM_PORTS elements) and feeds its own group of
+// CU_LANES / SYSTEM_MEM_PORTS lanes, dealing the beats of the slice round-robin to them
+#define SYSTEM_MEM_PORTS 1
+
+// width in bits of the input PLIOs (setup_aie streams) and of the output PLIOs (sink_from_aie streams)
+#define SYSTEM_PLIO_IN_WIDTH 128
+#define SYSTEM_PLIO_OUT_WIDTH 128
+
+// type of the elements moved by setup_aie and sink_from_aie and of the host buffers (data_t in constants.h),
+// the kernel sees them as int32_t
+#define SYSTEM_DATA_T int32_t
+#define SYSTEM_DATA_BITS 32
+
+// bits of the vector the kernel reads at each iteration, a multiple of SYSTEM_PLIO_IN_WIDTH
+#define SYSTEM_VECTOR_BITS 128
+// 1 when each lane starts with a header vector holding its number of iterations (stream mode kernels)
+#define SYSTEM_STREAM_HEADER 1
+// 1 when each lane gets its number of iterations from the synchronous RTP aie_graph.iterations[lane] instead
+// (see lane_iterations() in common/common.h)
+#define SYSTEM_RTP_ITERATIONS 0
+// asynchronous RTP parameters of the kernel, X(name, type, default): the graph ports are aie_graph.name[lane]
+#define SYSTEM_RTP_PARAMS(X)
+// 1 when the graph is persistent: the host starts one graph iteration whose kernels serve every job, until
+// the JOB_SHUTDOWN header (see sw/graph_control.hpp)
+#define SYSTEM_PERSISTENT_GRAPH 0
+// 1 when setup_aie and sink_from_aie keep performance counters and write them to a stats buffer at the end
+// of each run (see the STATS_* fields in common/common.h)
+#define SYSTEM_MOVER_STATS 0
+// 1 when the kernels decide how many elements they output: each lane ends every job with a trailer beat
+// carrying TLAST and sink_from_aie reports the elements it wrote (see fpga/sink_from_aie.hpp)
+#define SYSTEM_FRAMED_OUTPUT 0
+// 1 when every run of setup_aie and sink_from_aie moves a table of jobs, its size argument counting the jobs
+// (see the JOB_* fields in common/common.h)
+#define SYSTEM_JOB_DESCRIPTORS 0
+// 1 when setup_aie and sink_from_aie are started once and serve a command ring of job descriptors until its
+// stop command, their size argument counting the slots of the ring (see the RING_* fields in common/common.h)
+#define SYSTEM_FREE_RUNNING 0
+// 1 when the lanes of each memory port share one input and one output PLIO: setup_aie sends every buffer of
+// SYSTEM_PACKET_ELEMENTS elements as a packet to one lane, through a pktsplit of the graph, and sink_from_aie
+// puts the packets of the pktmerge back in place by their packet id (see fpga/packet_header.hpp)
+#define SYSTEM_PACKET_SWITCHING 0
+#define SYSTEM_PACKET_ELEMENTS 0
+
+// the number of elements of each run must be a multiple of this, so that every slice is the same size, every
+// lane gets whole vectors (or whole buffers) and every output beat is full
+#define SYSTEM_SIZE_ALIGN 4
+
+// memory banks of the slices of the input and output buffers, one per port of each compute unit, unit by unit
+// (sp lines of linking/xclbin_overlay.cfg)
+#define SYSTEM_INPUT_BANKS "MC_NOC0"
+#define SYSTEM_OUTPUT_BANKS "MC_NOC0"
+
+#endif // SYSTEM_CONFIG_H
@@ -0,0 +1,56 @@
+#ifndef COMMAND_RING_HPP
+#define COMMAND_RING_HPP
+
+#include <ap_int.h>
+#include "../common/common.h"
+#include "job_descriptors.hpp"
+
+// Command ring of the free-running movers, used when SYSTEM_FREE_RUNNING is set in common/system_config.h (layout
+// in the RING_* fields of common/common.h). The host starts setup_aie and sink_from_aie once, with the number of
+// command slots as size and the ring as job table, and then posts jobs by writing their descriptor and bumping the
+// head, without starting a run: each mover polls the head, moves the job like a run of one job and completes it in
+// the ring, until the stop command. The ring is volatile, so that every poll reads the memory again.
+
+// Waits for job n, in the given command slot: polls the head until the host has posted it
+static ap_uint<JOB_DESC_WIDTH> wait_command(volatile ap_uint<JOB_DESC_WIDTH>* ring, ap_uint<32> n, int32_t slot) {
+	ap_uint<JOB_DESC_WIDTH> head;
+	ap_uint<32> posted;
+	do {
+		head = ring[RING_HEAD];
+		posted = head.range(31, 0);
+	} while (posted == n);
+	return ring[RING_COMMANDS + slot];
+}
+
+// Completes job n, of the given command slot, once its elements went through: writes its record, then the tail
+static void complete_command(volatile ap_uint<JOB_DESC_WIDTH>* ring, int32_t slots, ap_uint<32> n, int32_t slot, ap_uint<32> elements) {
+	ap_uint<JOB_DESC_WIDTH> record = 0;
+	record.range(32 * RING_DONE_JOB + 31, 32 * RING_DONE_JOB) = n;
+	record.range(32 * RING_DONE_SIZE + 31, 32 * RING_DONE_SIZE) = elements;
+	ring[RING_COMMANDS + slots + slot] = record;
+	ap_uint<JOB_DESC_WIDTH> tail = 0;
+	tail.range(31, 0) = n + 1;
+	ring[RING_TAIL] = tail;
+}
+
+// For the testbenches, the host side of the ring: posts job n, whose descriptor goes to the command slot of the
+// job and whose number to the head
+static void post_command(ap_uint<JOB_DESC_WIDTH>* ring, int32_t slots, uint32_t n, const ap_uint<JOB_DESC_WIDTH>& job) {
+	ring[RING_COMMANDS + n % slots] = job;
+	ring[RING_HEAD] = n + 1;
+}
+
+// For the testbenches, a run of one job of size elements, at the start of every slice: writes to jobs (at least
+// RING_ENTRIES(RING_LINE) entries) the table of that job, or with SYSTEM_FREE_RUNNING a ring holding the job and
+// the stop command. Returns the size argument of the movers
+static int32_t single_job(ap_uint<JOB_DESC_WIDTH>* jobs, int32_t size) {
+	if (SYSTEM_FREE_RUNNING) {
+		post_command(jobs, RING_LINE, 0, job_descriptor(0, size, 0));
+		post_command(jobs, RING_LINE, 1, job_descriptor(0, RING_STOP, 0));
+		return RING_LINE;
+	}
+	jobs[0] = job_descriptor(0, size, 0);
+	return SYSTEM_JOB_DESCRIPTORS ? 1 : size;
+}
+
+#endif // COMMAND_RING_HPP
@@ -0,0 +1,67 @@
+#ifndef JOB_DESCRIPTORS_HPP
+#define JOB_DESCRIPTORS_HPP
+
+#include <hls_stream.h>
+#include <ap_int.h>
+#include "../common/common.h"
+
+// Job descriptors of setup_aie and sink_from_aie, used when SYSTEM_JOB_DESCRIPTORS is set in
+// common/system_config.h. Each mover then takes one more m_axi argument, the job table, on its own bundle
+// (m_axi_jobs, see linking/xclbin_overlay.cfg), and its size argument is the number of jobs in the table (see the
+// JOB_* fields in common/common.h). One launch moves every job of the table, so many small requests share the
+// cost of starting the kernels. With SYSTEM_FREE_RUNNING the argument is the command ring instead, that the mover
+// polls (see command_ring.hpp)
+#define JOB_DESC_WIDTH (JOB_FIELDS * 32)
+#if SYSTEM_FREE_RUNNING
+#define JOB_DESCRIPTORS_PARAM(name) , volatile ap_uint<JOB_DESC_WIDTH>* name
+#define JOB_DESCRIPTORS_ARG(name) , name
+#elif SYSTEM_JOB_DESCRIPTORS
+#define JOB_DESCRIPTORS_PARAM(name) , ap_uint<JOB_DESC_WIDTH>* name
+#define JOB_DESCRIPTORS_ARG(name) , name
+#else
+#define JOB_DESCRIPTORS_PARAM(name)
+#define JOB_DESCRIPTORS_ARG(name)
+#endif
+
+// Descriptor of a job of size elements, whose slices start at the given 512-bit words of the buffers of every port
+static inline ap_uint<JOB_DESC_WIDTH> job_descriptor(uint32_t input_word, uint32_t size, uint32_t output_word) {
+	ap_uint<JOB_DESC_WIDTH> job = 0;
+	job.range(32 * JOB_INPUT + 31, 32 * JOB_INPUT) = input_word;
+	job.range(32 * JOB_SIZE + 31, 32 * JOB_SIZE) = size;
+	job.range(32 * JOB_OUTPUT + 31, 32 * JOB_OUTPUT) = output_word;
+	return job;
+}
+
+// The part of a job moved by one memory port: its first 512-bit word in the buffer of the port, and its beats
+struct job_slice {
+	ap_uint<32> first_word;
+	int32_t beats;
+};
+
+// The slice of a job that every port moves. FIELD is the offset the mover uses (JOB_INPUT or JOB_OUTPUT),
+// ELEMENTS_PER_BEAT the elements of its PLIO beats
+template <int FIELD, int ELEMENTS_PER_BEAT>
+static job_slice port_slice(const ap_uint<JOB_DESC_WIDTH>& job) {
+	job_slice slice;
+	slice.first_word = job.range(32 * FIELD + 31, 32 * FIELD);
+	slice.beats = (int32_t) job.range(32 * JOB_SIZE + 31, 32 * JOB_SIZE) / SYSTEM_MEM_PORTS / ELEMENTS_PER_BEAT;
+	return slice;
+}
+
+// First stage of a mover with SYSTEM_JOB_DESCRIPTORS: reads the table once and hands every job to each port, the
+// slice of the port to its memory stage and the beats to its stream stage
+template <int FIELD, int ELEMENTS_PER_BEAT>
+static void read_jobs(int32_t num_jobs, ap_uint<JOB_DESC_WIDTH>* jobs, hls::stream<job_slice> slices[SYSTEM_MEM_PORTS],
+		hls::stream<int32_t> beats[SYSTEM_MEM_PORTS]) {
+	for (int32_t j = 0; j < num_jobs; j++) {
+		#pragma HLS pipeline II=1
+		const job_slice slice = port_slice<FIELD, ELEMENTS_PER_BEAT>(jobs[j]);
+		for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+			#pragma HLS unroll
+			slices[p].write(slice);
+			beats[p].write(slice.beats);
+		}
+	}
+}
+
+#endif // JOB_DESCRIPTORS_HPP
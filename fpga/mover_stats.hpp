@@ -0,0 +1,52 @@
+#ifndef MOVER_STATS_HPP
+#define MOVER_STATS_HPP
+
+#include <hls_stream.h>
+#include <ap_int.h>
+#include "../common/common.h"
+
+// Performance counters of setup_aie and sink_from_aie, kept when SYSTEM_MOVER_STATS is set in
+// common/system_config.h. Each mover then takes one more m_axi argument, the stats buffer, on its own bundle
+// (m_axi_stats, see linking/xclbin_overlay.cfg), and writes there one record per memory port at the end of the run
+// (see the STATS_* fields in common/common.h)
+#define MOVER_STATS_WIDTH (STATS_FIELDS * 64)
+#if SYSTEM_MOVER_STATS
+#define MOVER_STATS_PARAM(name) , ap_uint<MOVER_STATS_WIDTH>* name
+#define MOVER_STATS_ARG(name) , name
+#else
+#define MOVER_STATS_PARAM(name)
+#define MOVER_STATS_ARG(name)
+#endif
+
+// Counters of the stage on the AIE side of a memory port, updated once per iteration of its pipelined loop
+struct mover_counters {
+	ap_uint<64> cycles = 0;
+	ap_uint<64> beats = 0;
+	ap_uint<64> stall_stream = 0;
+	ap_uint<64> stall_memory = 0;
+	ap_uint<64> first_beat = 0;
+	ap_uint<64> last_beat = 0;
+	ap_uint<64> words = 0;
+
+	ap_uint<MOVER_STATS_WIDTH> record() const {
+		ap_uint<MOVER_STATS_WIDTH> r = 0;
+		r.range(64 * STATS_CYCLES + 63, 64 * STATS_CYCLES) = cycles;
+		r.range(64 * STATS_BEATS + 63, 64 * STATS_BEATS) = beats;
+		r.range(64 * STATS_STALL_STREAM + 63, 64 * STATS_STALL_STREAM) = stall_stream;
+		r.range(64 * STATS_STALL_MEMORY + 63, 64 * STATS_STALL_MEMORY) = stall_memory;
+		r.range(64 * STATS_FIRST_BEAT + 63, 64 * STATS_FIRST_BEAT) = first_beat;
+		r.range(64 * STATS_LAST_BEAT + 63, 64 * STATS_LAST_BEAT) = last_beat;
+		r.range(64 * STATS_WORDS + 63, 64 * STATS_WORDS) = words;
+		return r;
+	}
+};
+
+// Last stage of a mover with SYSTEM_MOVER_STATS: waits for the record of every port and writes it to the stats buffer
+static void write_stats(hls::stream<ap_uint<MOVER_STATS_WIDTH>> records[SYSTEM_MEM_PORTS], ap_uint<MOVER_STATS_WIDTH>* stats) {
+	for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+		#pragma HLS pipeline II=1
+		stats[p] = records[p].read();
+	}
+}
+
+#endif // MOVER_STATS_HPP
@@ -0,0 +1,42 @@
+#ifndef PACKET_HEADER_HPP
+#define PACKET_HEADER_HPP
+
+#include <ap_int.h>
+#include "../common/common.h"
+
+// Packet switching between the movers and the AIE array, used when SYSTEM_PACKET_SWITCHING is set in
+// common/system_config.h. The PORT_LANES lanes of a memory port then share one input and one output PLIO: a packet
+// is a 32-bit header followed by one kernel buffer (SYSTEM_PACKET_ELEMENTS elements), its last beat carrying TLAST.
+// The header takes the low 32 bits of the first beat, so on 64 and 128-bit PLIOs the buffer is shifted by 32 bits
+// and its last word ends the packet on a beat of its own (TKEEP 0xF).
+// Fields of a header: the packet id in bits 4-0 (the output of the pktsplit, or the input of the pktmerge, i.e. the
+// lane within its port), the packet type in bits 14-12, the source row and column in bits 20-16 and 27-21 (all
+// ones when the packet comes from the PL) and the odd parity of the header in bit 31
+#define PACKET_ID_BITS 5
+#define PACKET_TYPE 0
+static_assert(!SYSTEM_PACKET_SWITCHING || PORT_LANES <= (1 << PACKET_ID_BITS), "a pktsplit or pktmerge has up to 32 ports");
+
+// 512-bit words of the buffer of a packet, and beats of a packet on a PLIO of the given width
+#define PACKET_WORDS (SYSTEM_PACKET_ELEMENTS * SYSTEM_DATA_BITS / 512)
+#define PACKET_BEATS(plio_width) (SYSTEM_PACKET_ELEMENTS * SYSTEM_DATA_BITS / (plio_width) + 1)
+static_assert(SYSTEM_PACKET_ELEMENTS * SYSTEM_DATA_BITS % 512 == 0, "every packet must carry whole 512-bit words");
+
+// header of the packets for the given lane of a port, as sent by setup_aie
+static inline ap_uint<32> packet_header(int id) {
+	#pragma HLS inline
+	ap_uint<32> header = 0;
+	header.range(4, 0) = id;
+	header.range(14, 12) = PACKET_TYPE;
+	header.range(20, 16) = 0x1F;
+	header.range(27, 21) = 0x7F;
+	header.range(31, 31) = header.range(30, 0).xor_reduce() ? 0 : 1;
+	return header;
+}
+
+// lane of a packet received by sink_from_aie
+static inline int packet_id(ap_uint<32> header) {
+	#pragma HLS inline
+	return header.range(PACKET_ID_BITS - 1, 0);
+}
+
+#endif // PACKET_HEADER_HPP
@@ -26,33 +26,356 @@ SOFTWARE.
 #include "setup_aie.hpp"
 
 
+// Stage 1: reads the input with 512-bit bursts and pushes the words into the FIFO
+static void read_input(int32_t num_words, ap_uint<SETUP_AIE_MEM_WIDTH>* input, hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>>& words) {
+	for (int32_t w = 0; w < num_words; w++) {
+		#pragma HLS pipeline II=1
+		words.write(input[w]);
+	}
+}
+
+#if !SYSTEM_PACKET_SWITCHING
+// Header of the lanes of a port: one header vector per lane, with the number of loops that lane will run. On
+// shutdown every lane only gets a JOB_SHUTDOWN header, that ends a persistent kernel.
+template <int PORT>
+static void write_headers(int32_t size_loop, bool shutdown, hls::stream<setup_aie_beat> s[CU_PLIOS]) {
+	// each lane starts with a header vector: its first 32 bits hold the number of kernel iterations of the
+	// lane, the other beats of the vector are zero
+	for (int h = 0; h < SETUP_AIE_HEADER_BEATS; h++) {
+		for (int l = 0; l < PORT_LANES; l++) {
+			#pragma HLS unroll
+			ap_int<SETUP_AIE_PLIO_WIDTH> tmp = 0;
+			if (h == 0 && shutdown)
+				tmp.range(31,0) = JOB_SHUTDOWN;
+			else if (h == 0)
+				tmp.range(31,0) = (size_loop / PORT_LANES + (l < size_loop % PORT_LANES ? 1 : 0)) / SETUP_AIE_BEATS_PER_VECTOR;
+			s[PORT * PORT_LANES + l].write(tmp);
+		}
+	}
+}
+
+// Round r of a port: fetches the next word(s) when the buffer is exhausted and writes one beat to every lane
+template <int PORT>
+static void deal_round(int32_t r, int32_t size_loop, int32_t num_words, int32_t& words_read, ap_uint<SETUP_AIE_MEM_WIDTH * SETUP_AIE_WORDS_PER_ROUND>& buffer,
+		hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>>& words, hls::stream<setup_aie_beat> s[CU_PLIOS]) {
+	#pragma HLS inline
+	if (r % SETUP_AIE_ROUNDS_PER_WORD == 0) {
+		for (int w = 0; w < SETUP_AIE_WORDS_PER_ROUND; w++) {
+			#pragma HLS unroll
+			if (words_read + w < num_words)
+				buffer.range(SETUP_AIE_MEM_WIDTH * (w + 1) - 1, SETUP_AIE_MEM_WIDTH * w) = words.read();
+		}
+		words_read += SETUP_AIE_WORDS_PER_ROUND;
+	}
+	for (int l = 0; l < PORT_LANES; l++) {
+		#pragma HLS unroll
+		if (r * PORT_LANES + l < size_loop) {
+			ap_int<SETUP_AIE_PLIO_WIDTH> tmp = buffer.range(SETUP_AIE_PLIO_WIDTH * (l + 1) - 1, SETUP_AIE_PLIO_WIDTH * l);
+			s[PORT * PORT_LANES + l].write(tmp);
+		}
+	}
+	if (SETUP_AIE_ROUNDS_PER_WORD > 1)
+		buffer >>= SETUP_AIE_PLIO_WIDTH * PORT_LANES;
+}
+
+// Stage 2: writes the lane headers, then deals the beats of the slice round-robin to the lanes of the port. Each
+// round writes one beat to every lane, so up to SETUP_AIE_BEATS_PER_WORD lanes are fed in the same cycle (the
+// 512-bit reader bounds the rate to one word per cycle with more lanes).
+// PORT is a template parameter so that every port writes its own lanes with constant indices.
+template <int PORT>
+static void distribute(int32_t size_loop, bool shutdown, hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>>& words, hls::stream<setup_aie_beat> s[CU_PLIOS]) {
+	write_headers<PORT>(size_loop, shutdown, s);
+
+	const int32_t num_words = (size_loop + SETUP_AIE_BEATS_PER_WORD - 1) / SETUP_AIE_BEATS_PER_WORD;
+	const int32_t rounds = (size_loop + PORT_LANES - 1) / PORT_LANES;
+	int32_t words_read = 0;
+	ap_uint<SETUP_AIE_MEM_WIDTH * SETUP_AIE_WORDS_PER_ROUND> buffer;
+	for (int32_t r = 0; r < rounds; r++) {
+		#pragma HLS pipeline II=1
+		deal_round<PORT>(r, size_loop, num_words, words_read, buffer, words, s);
+	}
+}
+#endif
+
+#if SYSTEM_MOVER_STATS
+// Stage 2 with performance counters: instead of blocking, every iteration (one per cycle) first checks that the
+// round can proceed, and counts the cycle as a memory stall when its word is not in the FIFO yet, or as a stream
+// stall when a lane is full (backpressure from the AIE). With more lanes than beats per word only the first word
+// of a round is checked. The counters add up over the jobs of a run.
+template <int PORT>
+static void distribute_counted(int32_t size_loop, bool shutdown, hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>>& words, hls::stream<setup_aie_beat> s[CU_PLIOS],
+		mover_counters& counters) {
+	write_headers<PORT>(size_loop, shutdown, s);
+
+	const int32_t num_words = (size_loop + SETUP_AIE_BEATS_PER_WORD - 1) / SETUP_AIE_BEATS_PER_WORD;
+	const int32_t rounds = (size_loop + PORT_LANES - 1) / PORT_LANES;
+	int32_t words_read = 0;
+	ap_uint<SETUP_AIE_MEM_WIDTH * SETUP_AIE_WORDS_PER_ROUND> buffer;
+	int32_t r = 0;
+	while (r < rounds) {
+		#pragma HLS pipeline II=1
+		counters.cycles++;
+		bool lane_full = false;
+		for (int l = 0; l < PORT_LANES; l++) {
+			#pragma HLS unroll
+			if (r * PORT_LANES + l < size_loop && s[PORT * PORT_LANES + l].full())
+				lane_full = true;
+		}
+		if (r % SETUP_AIE_ROUNDS_PER_WORD == 0 && words.empty()) {
+			counters.stall_memory++;
+		} else if (lane_full) {
+			counters.stall_stream++;
+		} else {
+			deal_round<PORT>(r, size_loop, num_words, words_read, buffer, words, s);
+			if (counters.beats == 0)
+				counters.first_beat = counters.cycles;
+			counters.last_beat = counters.cycles;
+			counters.beats += (size_loop - r * PORT_LANES < PORT_LANES) ? size_loop - r * PORT_LANES : PORT_LANES;
+			r++;
+		}
+	}
+	counters.words += num_words;
+}
+
+// the counters of a run of one job go to write_stats() at the end
+template <int PORT>
+static void distribute_stats(int32_t size_loop, bool shutdown, hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>>& words, hls::stream<setup_aie_beat> s[CU_PLIOS],
+		hls::stream<ap_uint<MOVER_STATS_WIDTH>>& stats) {
+	mover_counters counters;
+	distribute_counted<PORT>(size_loop, shutdown, words, s, counters);
+	stats.write(counters.record());
+}
+#endif
+
+#if SYSTEM_JOB_DESCRIPTORS
+// Stage 1 with job descriptors: reads the slice of the port of every job, wherever the table puts it
+static void read_job_input(int32_t num_jobs, hls::stream<job_slice>& slices, ap_uint<SETUP_AIE_MEM_WIDTH>* input, hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>>& words) {
+	for (int32_t j = 0; j < num_jobs; j++) {
+		const job_slice slice = slices.read();
+		const int32_t num_words = (slice.beats + SETUP_AIE_BEATS_PER_WORD - 1) / SETUP_AIE_BEATS_PER_WORD;
+		for (int32_t w = 0; w < num_words; w++) {
+			#pragma HLS pipeline II=1
+			words.write(input[slice.first_word + w]);
+		}
+	}
+}
+
+// Stage 2 with job descriptors: every job is distributed like a whole run, its own headers first, so the kernels
+// see the jobs one by one. On shutdown the lanes only get the JOB_SHUTDOWN header
+template <int PORT>
+static void distribute_jobs(int32_t num_jobs, bool shutdown, hls::stream<int32_t>& beats, hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>>& words,
+		hls::stream<setup_aie_beat> s[CU_PLIOS]) {
+	if (shutdown)
+		write_headers<PORT>(0, true, s);
+	for (int32_t j = 0; j < num_jobs; j++)
+		distribute<PORT>(beats.read(), false, words, s);
+}
+
+#if SYSTEM_MOVER_STATS
+// the same, with the counters of every job summed in one record per run
+template <int PORT>
+static void distribute_jobs_stats(int32_t num_jobs, bool shutdown, hls::stream<int32_t>& beats, hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>>& words,
+		hls::stream<setup_aie_beat> s[CU_PLIOS], hls::stream<ap_uint<MOVER_STATS_WIDTH>>& stats) {
+	mover_counters counters;
+	if (shutdown)
+		write_headers<PORT>(0, true, s);
+	for (int32_t j = 0; j < num_jobs; j++)
+		distribute_counted<PORT>(beats.read(), false, words, s, counters);
+	stats.write(counters.record());
+}
+#endif
+#endif
+
+#if SYSTEM_PACKET_SWITCHING
+// Stage 2 with packet switching: the PORT_LANES lanes of the port share its stream PORT, and the pktsplit of the
+// graph hands every packet to the lane of its id. Block n of the slice, one kernel buffer, goes to lane
+// n % PORT_LANES as a packet (see packet_header.hpp), so every lane gets its buffers in order and as many as the
+// others. The header takes the low 32 bits of the first beat: every beat then carries the last 32-bit word of the
+// previous one in its low bits, and the last word of the block ends the packet on a beat of its own. One loop over
+// the beats of all the packets, so that the port moves one beat per cycle across packets too.
+template <int PORT>
+static void distribute_packets(int32_t num_packets, hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>>& words, hls::stream<setup_aie_beat> s[CU_PLIOS]) {
+	const int data_beats = PACKET_BEATS(SETUP_AIE_PLIO_WIDTH) - 1;
+	const int32_t num_beats = num_packets * (data_beats + 1);
+	int32_t n = 0;
+	int b = 0;
+	ap_uint<32> carry = 0;
+	ap_uint<SETUP_AIE_MEM_WIDTH> word = 0;
+	for (int32_t i = 0; i < num_beats; i++) {
+		#pragma HLS pipeline II=1
+		if (b == 0)
+			carry = packet_header(n % PORT_LANES);
+		setup_aie_beat beat;
+		beat.data = 0;
+		beat.data.range(31, 0) = carry;
+		if (b < data_beats) {
+			if (b % SETUP_AIE_BEATS_PER_WORD == 0)
+				word = words.read();
+			const ap_uint<SETUP_AIE_PLIO_WIDTH> data = word.range(SETUP_AIE_PLIO_WIDTH * (b % SETUP_AIE_BEATS_PER_WORD + 1) - 1, SETUP_AIE_PLIO_WIDTH * (b % SETUP_AIE_BEATS_PER_WORD));
+			if (SETUP_AIE_PLIO_WIDTH > 32)
+				beat.data.range(SETUP_AIE_PLIO_WIDTH - 1, 32) = data.range(SETUP_AIE_PLIO_WIDTH - 33, 0);
+			carry = data.range(SETUP_AIE_PLIO_WIDTH - 1, SETUP_AIE_PLIO_WIDTH - 32);
+			beat.keep = -1;
+			beat.last = 0;
+			b++;
+		} else {
+			// only the last word of the block
+			beat.keep = 0xF;
+			beat.last = 1;
+			b = 0;
+			n++;
+		}
+		s[PORT].write(beat);
+	}
+}
+#endif
+
+#if SYSTEM_PACKET_SWITCHING
+// reader and packet distributor of memory port p: size_loop beats of the slice, in blocks of one kernel buffer
+#define SETUP_AIE_PORT(p, input) \
+	read_input(num_words, input, words[p]); \
+	distribute_packets<p>(size_loop / (PACKET_BEATS(SETUP_AIE_PLIO_WIDTH) - 1), words[p], s);
+#elif SYSTEM_JOB_DESCRIPTORS && SYSTEM_MOVER_STATS
+// reader and distributor of memory port p, job by job, with their counters
+#define SETUP_AIE_PORT(p, input) \
+	read_job_input(num_jobs, slices[p], input, words[p]); \
+	distribute_jobs_stats<p>(num_jobs, shutdown, beats[p], words[p], s, records[p]);
+#elif SYSTEM_JOB_DESCRIPTORS
+// reader and distributor of memory port p, job by job
+#define SETUP_AIE_PORT(p, input) \
+	read_job_input(num_jobs, slices[p], input, words[p]); \
+	distribute_jobs<p>(num_jobs, shutdown, beats[p], words[p], s);
+#elif SYSTEM_MOVER_STATS
+// reader and distributor of memory port p, with their counters
+#define SETUP_AIE_PORT(p, input) \
+	read_input(num_words, input, words[p]); \
+	distribute_stats<p>(size_loop, shutdown, words[p], s, records[p]);
+#else
+// reader and distributor of memory port p
+#define SETUP_AIE_PORT(p, input) \
+	read_input(num_words, input, words[p]); \
+	distribute<p>(size_loop, shutdown, words[p], s);
+#endif
+
+#if SYSTEM_FREE_RUNNING
+// reader and distributor of memory port p, on the slice of one job of the command ring
+#define SETUP_AIE_RING_PORT(p, input) \
+	read_input(num_words, input + slice.first_word, words[p]); \
+	distribute<p>(slice.beats, shutdown, words[p], s);
+
+// One job of the command ring, moved like a run of one job: a dataflow region of its own, that the free-running
+// top level calls for every command it gets
+static void move_job(job_slice slice, bool shutdown, MEM_PORT_PARAMS(ap_uint<SETUP_AIE_MEM_WIDTH>*, input), hls::stream<setup_aie_beat> s[CU_PLIOS]) {
+	#pragma HLS dataflow
+	const int32_t num_words = (slice.beats + SETUP_AIE_BEATS_PER_WORD - 1) / SETUP_AIE_BEATS_PER_WORD;
+
+	hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>> words[SYSTEM_MEM_PORTS];
+	DO_PRAGMA(HLS stream variable=words depth=SETUP_AIE_FIFO_DEPTH)
+
+	SETUP_AIE_RING_PORT(0, input)
+#if SYSTEM_MEM_PORTS > 1
+	SETUP_AIE_RING_PORT(1, input_1)
+#endif
+#if SYSTEM_MEM_PORTS > 2
+	SETUP_AIE_RING_PORT(2, input_2)
+	SETUP_AIE_RING_PORT(3, input_3)
+#endif
+}
+#endif
 
 extern "C" {
 
-void setup_aie(int32_t size, int32_t* input, hls::stream<ap_int<sizeof(int32_t) * 8 * 4>>& s) {
+void setup_aie(int32_t size, MEM_PORT_PARAMS(ap_uint<SETUP_AIE_MEM_WIDTH>*, input) MOVER_STATS_PARAM(stats) JOB_DESCRIPTORS_PARAM(jobs), hls::stream<setup_aie_beat> s[CU_PLIOS]) {
 
-	#pragma HLS interface m_axi port=input depth=100 offset=slave bundle=gmem0
-	#pragma HLS interface axis port=s
+	// one bundle for each memory port, so that every port gets its own AXI master (see the sp lines of
+	// linking/xclbin_overlay.cfg)
+	DO_PRAGMA(HLS interface m_axi port=input depth=SETUP_AIE_COSIM_DEPTH offset=slave bundle=gmem0 max_read_burst_length=SETUP_AIE_MAX_BURST_LENGTH num_read_outstanding=SETUP_AIE_NUM_READ_OUTSTANDING)
 	#pragma HLS interface s_axilite port=input bundle=control
+#if SYSTEM_MEM_PORTS > 1
+	DO_PRAGMA(HLS interface m_axi port=input_1 depth=SETUP_AIE_COSIM_DEPTH offset=slave bundle=gmem1 max_read_burst_length=SETUP_AIE_MAX_BURST_LENGTH num_read_outstanding=SETUP_AIE_NUM_READ_OUTSTANDING)
+	#pragma HLS interface s_axilite port=input_1 bundle=control
+#endif
+#if SYSTEM_MEM_PORTS > 2
+	DO_PRAGMA(HLS interface m_axi port=input_2 depth=SETUP_AIE_COSIM_DEPTH offset=slave bundle=gmem2 max_read_burst_length=SETUP_AIE_MAX_BURST_LENGTH num_read_outstanding=SETUP_AIE_NUM_READ_OUTSTANDING)
+	DO_PRAGMA(HLS interface m_axi port=input_3 depth=SETUP_AIE_COSIM_DEPTH offset=slave bundle=gmem3 max_read_burst_length=SETUP_AIE_MAX_BURST_LENGTH num_read_outstanding=SETUP_AIE_NUM_READ_OUTSTANDING)
+	#pragma HLS interface s_axilite port=input_2 bundle=control
+	#pragma HLS interface s_axilite port=input_3 bundle=control
+#endif
+#if SYSTEM_MOVER_STATS
+	// the counters of every port (see mover_stats.hpp), on their own bundle
+	DO_PRAGMA(HLS interface m_axi port=stats depth=SYSTEM_MEM_PORTS offset=slave bundle=stats)
+	#pragma HLS interface s_axilite port=stats bundle=control
+#endif
+#if SYSTEM_JOB_DESCRIPTORS
+	// the job table (see job_descriptors.hpp), on its own bundle
+	DO_PRAGMA(HLS interface m_axi port=jobs depth=SETUP_AIE_COSIM_JOBS offset=slave bundle=jobs)
+	#pragma HLS interface s_axilite port=jobs bundle=control
+#endif
+	#pragma HLS interface axis port=s
 	#pragma HLS interface s_axilite port=size bundle=control
 	#pragma HLS interface s_axilite port=return bundle=control
 
-	// size represents the number of elements. But the AI Engine uses the number of loops, and each
-	// loop uses 4 elements. So we need to convert the number of elements to the number of loops.
-	int32_t size_loop = size/4;
-	ap_int<sizeof(int32_t)*8*4> tmp;
-	tmp.range(31,0) = size_loop;
-	tmp.range(63,32) = 0;
-	tmp.range(95,64) = 0;
-	tmp.range(127,96) = 0;
-	s.write(tmp);
-
-	for (int j = 0; j < size_loop; j++) {
-		tmp.range(31,0) = input[j*4+0];
-		tmp.range(63,32) = input[j*4+1];
-		tmp.range(95,64) = input[j*4+2];
-		tmp.range(127,96) = input[j*4+3];
-		s.write(tmp);
+#if SYSTEM_FREE_RUNNING
+	// size is the number of command slots of the ring in jobs, that the mover serves until the stop command (see
+	// command_ring.hpp). A negative size still only sends the JOB_SHUTDOWN header, without touching the ring
+	if (size < 0) {
+		const job_slice none = {0, 0};
+		move_job(none, true, MEM_PORT_NAMES(input), s);
+		return;
 	}
+	int32_t slot = 0;
+	for (ap_uint<32> n = 0; size > 0; n++) {
+		const ap_uint<JOB_DESC_WIDTH> command = wait_command(jobs, n, slot);
+		const uint32_t elements = command.range(32 * JOB_SIZE + 31, 32 * JOB_SIZE);
+		const bool stop = elements == RING_STOP;
+		if (!stop)
+			move_job(port_slice<JOB_INPUT, SETUP_AIE_ELEMENTS_PER_BEAT>(command), false, MEM_PORT_NAMES(input), s);
+		complete_command(jobs, size, n, slot, stop ? 0 : elements);
+		if (stop)
+			break;
+		slot = slot == size - 1 ? 0 : slot + 1;
+	}
+#else
+	#pragma HLS dataflow
+
+	// size represents the number of elements of data_t. The streams move beats of SETUP_AIE_ELEMENTS_PER_BEAT
+	// elements (4 int32_t with 128-bit PLIOs), so we need to convert the number of elements to the number of beats.
+	// The reader fetches whole 512-bit words, so the input buffer must be padded to a multiple of 64 bytes.
+	// Every lane gets its own header, see distribute(). size must be a multiple of SYSTEM_SIZE_ALIGN, and each
+	// memory port reads size / SYSTEM_MEM_PORTS elements from its own buffer, padded the same way.
+	// A negative size reads nothing and shuts a persistent graph down (see SYSTEM_PERSISTENT_GRAPH).
+	// With SYSTEM_JOB_DESCRIPTORS size is the number of jobs of the table instead, each moved as described above.
+	// With SYSTEM_PACKET_SWITCHING the lanes of each port get the slice in packets instead, see distribute_packets().
+	bool shutdown = size < 0;
+	int32_t size_loop = shutdown ? 0 : size / SYSTEM_MEM_PORTS / SETUP_AIE_ELEMENTS_PER_BEAT;
+	int32_t num_words = (size_loop + SETUP_AIE_BEATS_PER_WORD - 1) / SETUP_AIE_BEATS_PER_WORD;
+
+	hls::stream<ap_uint<SETUP_AIE_MEM_WIDTH>> words[SYSTEM_MEM_PORTS];
+	DO_PRAGMA(HLS stream variable=words depth=SETUP_AIE_FIFO_DEPTH)
+
+#if SYSTEM_MOVER_STATS
+	hls::stream<ap_uint<MOVER_STATS_WIDTH>> records[SYSTEM_MEM_PORTS];
+#endif
+#if SYSTEM_JOB_DESCRIPTORS
+	int32_t num_jobs = shutdown ? 0 : size;
+	hls::stream<job_slice> slices[SYSTEM_MEM_PORTS];
+	hls::stream<int32_t> beats[SYSTEM_MEM_PORTS];
+	DO_PRAGMA(HLS stream variable=slices depth=SETUP_AIE_JOB_FIFO_DEPTH)
+	DO_PRAGMA(HLS stream variable=beats depth=SETUP_AIE_JOB_FIFO_DEPTH)
+	read_jobs<JOB_INPUT, SETUP_AIE_ELEMENTS_PER_BEAT>(num_jobs, jobs, slices, beats);
+#endif
+
+	SETUP_AIE_PORT(0, input)
+#if SYSTEM_MEM_PORTS > 1
+	SETUP_AIE_PORT(1, input_1)
+#endif
+#if SYSTEM_MEM_PORTS > 2
+	SETUP_AIE_PORT(2, input_2)
+	SETUP_AIE_PORT(3, input_3)
+#endif
+#if SYSTEM_MOVER_STATS
+	write_stats(records, stats);
+#endif
+#endif
 }
 }
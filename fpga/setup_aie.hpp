@@ -4,12 +4,67 @@
 
 
 #include "../common/common.h"
+#include "mover_stats.hpp"
+#include "job_descriptors.hpp"
+#include "command_ring.hpp"
+#include "packet_header.hpp"
 #include <cstdint>
 #include <hls_stream.h>
 #include <ap_int.h>
+#include <ap_axi_sdata.h>
+
+// Width of the memory-side port: one 512-bit word carries 16 int32_t (64 int8_t), i.e. 4 beats of a 128-bit AIE stream
+#define SETUP_AIE_MEM_WIDTH 512
+// the streams have the width of the input PLIOs, set in common/system_config.h
+#define SETUP_AIE_PLIO_WIDTH SYSTEM_PLIO_IN_WIDTH
+#define SETUP_AIE_BEATS_PER_WORD (SETUP_AIE_MEM_WIDTH / SETUP_AIE_PLIO_WIDTH)
+// elements of data_t (see common/constants.h) in each beat: 4 int32_t, 8 int16_t or 16 int8_t with 128-bit PLIOs
+#define SETUP_AIE_DATA_BITS (sizeof(data_t) * 8)
+#define SETUP_AIE_ELEMENTS_PER_BEAT (SETUP_AIE_PLIO_WIDTH / SETUP_AIE_DATA_BITS)
+// the lane header fills one kernel vector, i.e. SETUP_AIE_BEATS_PER_VECTOR beats, and counts kernel iterations
+#define SETUP_AIE_BEATS_PER_VECTOR (SYSTEM_VECTOR_BITS / SETUP_AIE_PLIO_WIDTH)
+#define SETUP_AIE_HEADER_BEATS (SYSTEM_STREAM_HEADER ? SETUP_AIE_BEATS_PER_VECTOR : 0)
+static_assert(SYSTEM_VECTOR_BITS % SETUP_AIE_PLIO_WIDTH == 0, "the kernel vector must be a multiple of the PLIO width");
+static_assert(SETUP_AIE_PLIO_WIDTH % SETUP_AIE_DATA_BITS == 0, "the beats must carry whole elements");
+
+// Beats of the streams: plain data, or with SYSTEM_PACKET_SWITCHING the beats of packets, which need TLAST and
+// TKEEP (see packet_header.hpp). Stream p of the compute unit then carries the packets of memory port p
+#if SYSTEM_PACKET_SWITCHING
+typedef ap_axiu<SETUP_AIE_PLIO_WIDTH, 0, 0, 0> setup_aie_beat;
+#else
+typedef ap_int<SETUP_AIE_PLIO_WIDTH> setup_aie_beat;
+#endif
+
+// The input is striped over SYSTEM_MEM_PORTS m_axi ports (input, input_1, ...), each in its own memory bank:
+// port p reads the slice p of the buffer and feeds lanes p * PORT_LANES ... (p + 1) * PORT_LANES - 1, so the
+// ports work in parallel. Dealing of the beats to the PORT_LANES lanes of a port, one beat per lane each round:
+// with up to 4 lanes a word feeds SETUP_AIE_ROUNDS_PER_WORD rounds, with more lanes a round needs
+// SETUP_AIE_WORDS_PER_ROUND words
+#define SETUP_AIE_ROUNDS_PER_WORD (PORT_LANES < SETUP_AIE_BEATS_PER_WORD ? SETUP_AIE_BEATS_PER_WORD / PORT_LANES : 1)
+#define SETUP_AIE_WORDS_PER_ROUND (PORT_LANES > SETUP_AIE_BEATS_PER_WORD ? PORT_LANES / SETUP_AIE_BEATS_PER_WORD : 1)
+static_assert((NUM_LANES & (NUM_LANES - 1)) == 0, "NUM_LANES must be a power of two");
+static_assert(NUM_LANES % (SYSTEM_COMPUTE_UNITS * SYSTEM_MEM_PORTS) == 0, "every memory port feeds the same number of lanes");
+
+// AXI burst tuning of the reader stage, can be overridden at compile time (see MAX_BURST_LENGTH and
+// NUM_READ_OUTSTANDING in fpga/Makefile)
+#ifndef SETUP_AIE_MAX_BURST_LENGTH
+#define SETUP_AIE_MAX_BURST_LENGTH 64
+#endif
+#ifndef SETUP_AIE_NUM_READ_OUTSTANDING
+#define SETUP_AIE_NUM_READ_OUTSTANDING 16
+#endif
+
+// Depth of the FIFO between the reader and the width converter: it must absorb a full burst
+#define SETUP_AIE_FIFO_DEPTH (SETUP_AIE_MAX_BURST_LENGTH * 2)
+// Number of 512-bit words each m_axi port exposes to C/RTL cosimulation
+#define SETUP_AIE_COSIM_DEPTH 65536
+// With SYSTEM_JOB_DESCRIPTORS: jobs the table (or entries the command ring) exposes to C/RTL cosimulation, and
+// jobs the table reader can be ahead of the ports
+#define SETUP_AIE_COSIM_JOBS 1024
+#define SETUP_AIE_JOB_FIFO_DEPTH 16
 
 extern "C" {
-    void setup_aie(int32_t size, int32_t* input, hls::stream<ap_int<sizeof(int32_t) * 8 * 4>>& s);
+    void setup_aie(int32_t size, MEM_PORT_PARAMS(ap_uint<SETUP_AIE_MEM_WIDTH>*, input) MOVER_STATS_PARAM(stats) JOB_DESCRIPTORS_PARAM(jobs), hls::stream<setup_aie_beat> s[CU_PLIOS]);
 }
 
 #endif // SETUP_AIE_HPP
\ No newline at end of file
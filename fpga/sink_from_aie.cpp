@@ -28,31 +28,546 @@ SOFTWARE.
 #include <ap_axi_sdata.h>
 #include "../common/common.h"
 
+// Round r of a port: reads one beat from every lane of the port and packs them into the 512-bit word(s)
+template <int PORT>
+static void collect_round(int r, int rounds, int num_beats, ap_uint<SINK_FROM_AIE_MEM_WIDTH * SINK_FROM_AIE_WORDS_PER_ROUND>& buffer,
+    hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS], hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words)
+{
+#pragma HLS inline
+    ap_uint<SINK_FROM_AIE_PLIO_WIDTH * PORT_LANES> round_data = 0;
+    for (int l = 0; l < PORT_LANES; l++)
+    {
+#pragma HLS unroll
+        if (r * PORT_LANES + l < num_beats)
+            round_data.range(SINK_FROM_AIE_PLIO_WIDTH * (l + 1) - 1, SINK_FROM_AIE_PLIO_WIDTH * l) = input_stream[PORT * PORT_LANES + l].read().data;
+    }
+
+    if (SINK_FROM_AIE_ROUNDS_PER_WORD > 1)
+    {
+        // a word spans several rounds: shift the new beats in from the top
+        buffer >>= SINK_FROM_AIE_PLIO_WIDTH * PORT_LANES;
+        buffer.range(SINK_FROM_AIE_MEM_WIDTH * SINK_FROM_AIE_WORDS_PER_ROUND - 1, SINK_FROM_AIE_MEM_WIDTH * SINK_FROM_AIE_WORDS_PER_ROUND - SINK_FROM_AIE_PLIO_WIDTH * PORT_LANES) = round_data;
+        if (r % SINK_FROM_AIE_ROUNDS_PER_WORD == SINK_FROM_AIE_ROUNDS_PER_WORD - 1 || r == rounds - 1)
+        {
+            // align a partial last word to the bottom
+            int missing = SINK_FROM_AIE_ROUNDS_PER_WORD - 1 - r % SINK_FROM_AIE_ROUNDS_PER_WORD;
+            words.write(buffer >> (missing * SINK_FROM_AIE_PLIO_WIDTH * PORT_LANES));
+            buffer = 0;
+        }
+    }
+    else
+    {
+        // a round spans one or more words
+        buffer = round_data;
+        for (int w = 0; w < SINK_FROM_AIE_WORDS_PER_ROUND; w++)
+        {
+#pragma HLS unroll
+            if (r * PORT_LANES + w * SINK_FROM_AIE_BEATS_PER_WORD < num_beats)
+                words.write(buffer.range(SINK_FROM_AIE_MEM_WIDTH * (w + 1) - 1, SINK_FROM_AIE_MEM_WIDTH * w));
+        }
+    }
+}
+
+// Stage 1: collects one beat per lane of the port each round, in the same round-robin order used by setup_aie,
+// and packs SINK_FROM_AIE_BEATS_PER_WORD consecutive beats into one 512-bit word.
+// The last word is padded with zeros when the number of beats is not a multiple of SINK_FROM_AIE_BEATS_PER_WORD.
+// PORT is a template parameter so that every port reads its own lanes with constant indices.
+template <int PORT>
+static void collect(int num_beats, hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS], hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words)
+{
+    const int rounds = (num_beats + PORT_LANES - 1) / PORT_LANES;
+    ap_uint<SINK_FROM_AIE_MEM_WIDTH * SINK_FROM_AIE_WORDS_PER_ROUND> buffer = 0;
+    for (int r = 0; r < rounds; r++)
+    {
+#pragma HLS pipeline II=1
+        collect_round<PORT>(r, rounds, num_beats, buffer, input_stream, words);
+    }
+}
+
+#if SYSTEM_MOVER_STATS
+// Stage 1 with performance counters: every iteration (one per cycle) first checks that the round can proceed,
+// and counts the cycle as a stream stall when a lane has no beat yet (the AIE is not producing), or as a memory
+// stall when the round fills a word and the FIFO of the writer is full. The counters add up over the jobs of a run.
+template <int PORT>
+static void collect_counted(int num_beats, hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS], hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words,
+    mover_counters& counters)
+{
+    const int rounds = (num_beats + PORT_LANES - 1) / PORT_LANES;
+    ap_uint<SINK_FROM_AIE_MEM_WIDTH * SINK_FROM_AIE_WORDS_PER_ROUND> buffer = 0;
+    int r = 0;
+    while (r < rounds)
+    {
+#pragma HLS pipeline II=1
+        counters.cycles++;
+        bool lane_empty = false;
+        for (int l = 0; l < PORT_LANES; l++)
+        {
+#pragma HLS unroll
+            if (r * PORT_LANES + l < num_beats && input_stream[PORT * PORT_LANES + l].empty())
+                lane_empty = true;
+        }
+        const bool fills_word = SINK_FROM_AIE_ROUNDS_PER_WORD == 1 || r % SINK_FROM_AIE_ROUNDS_PER_WORD == SINK_FROM_AIE_ROUNDS_PER_WORD - 1 || r == rounds - 1;
+        if (lane_empty)
+            counters.stall_stream++;
+        else if (fills_word && words.full())
+            counters.stall_memory++;
+        else
+        {
+            collect_round<PORT>(r, rounds, num_beats, buffer, input_stream, words);
+            if (counters.beats == 0)
+                counters.first_beat = counters.cycles;
+            counters.last_beat = counters.cycles;
+            counters.beats += (num_beats - r * PORT_LANES < PORT_LANES) ? num_beats - r * PORT_LANES : PORT_LANES;
+            r++;
+        }
+    }
+    counters.words += (num_beats + SINK_FROM_AIE_BEATS_PER_WORD - 1) / SINK_FROM_AIE_BEATS_PER_WORD;
+}
+
+// the counters of a run of one job go to write_stats() at the end
+template <int PORT>
+static void collect_stats(int num_beats, hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS], hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words,
+    hls::stream<ap_uint<MOVER_STATS_WIDTH>>& stats)
+{
+    mover_counters counters;
+    collect_counted<PORT>(num_beats, input_stream, words, counters);
+    stats.write(counters.record());
+}
+
+#endif
+
+// Stage 2: writes the 512-bit words to memory with bursts
+static void write_output(int num_words, hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words, ap_uint<SINK_FROM_AIE_MEM_WIDTH>* output)
+{
+    for (int w = 0; w < num_words; w++)
+    {
+#pragma HLS pipeline II=1
+        output[w] = words.read();
+    }
+}
+
+#if SYSTEM_FRAMED_OUTPUT
+// Stage 1 of a framed output: every lane sends any number of beats for the job, then one trailer beat with TLAST
+// set. Each cycle the port takes one beat from one of its lanes, round-robin over the lanes whose trailer has not
+// arrived yet, packs the data beats into 512-bit words and stops when every lane closed its frame. The words go
+// to the writer in bursts of up to SINK_FROM_AIE_MAX_BURST_LENGTH, each announced on bursts once its words are in
+// the FIFO (0 ends the job). Beats beyond the capacity of the slice are dropped but still counted, so the host
+// sees the overflow in the produced count. The stalls are counted as in collect_stats().
+template <int PORT>
+static void collect_framed(int capacity_beats, hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS], hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words,
+    hls::stream<ap_uint<16>>& bursts, hls::stream<ap_uint<64>>& produced
+#if SYSTEM_MOVER_STATS
+    , hls::stream<ap_uint<MOVER_STATS_WIDTH>>& stats
+#endif
+    )
+{
+    ap_uint<PORT_LANES> open = 0;
+    open = ~open;
+    int l = 0;
+    int beats = 0;    // data beats received
+    int in_word = 0;  // beats packed in word
+    int in_burst = 0; // words written since the last burst
+    int num_words = 0;
+    ap_uint<SINK_FROM_AIE_MEM_WIDTH> word = 0;
+    mover_counters counters;
+    while (open != 0)
+    {
+#pragma HLS pipeline II=1
+        counters.cycles++;
+        bool lane_empty = false;
+        for (int i = 0; i < PORT_LANES; i++)
+        {
+#pragma HLS unroll
+            if (i == l && input_stream[PORT * PORT_LANES + i].empty())
+                lane_empty = true;
+        }
+        if (lane_empty)
+            counters.stall_stream++;
+        else if (in_word == SINK_FROM_AIE_BEATS_PER_WORD - 1 && words.full())
+            counters.stall_memory++;
+        else
+        {
+            ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0> beat;
+            for (int i = 0; i < PORT_LANES; i++)
+            {
+#pragma HLS unroll
+                if (i == l)
+                    beat = input_stream[PORT * PORT_LANES + i].read();
+            }
+            if (beat.last)
+                open.clear(l);
+            else
+            {
+                if (beats < capacity_beats)
+                {
+                    // shift the beat in from the top, like collect_round()
+                    word >>= SINK_FROM_AIE_PLIO_WIDTH;
+                    word.range(SINK_FROM_AIE_MEM_WIDTH - 1, SINK_FROM_AIE_MEM_WIDTH - SINK_FROM_AIE_PLIO_WIDTH) = beat.data;
+                    if (++in_word == SINK_FROM_AIE_BEATS_PER_WORD)
+                    {
+                        words.write(word);
+                        in_word = 0;
+                        num_words++;
+                        if (++in_burst == SINK_FROM_AIE_MAX_BURST_LENGTH)
+                        {
+                            bursts.write(in_burst);
+                            in_burst = 0;
+                        }
+                    }
+                }
+                if (beats == 0)
+                    counters.first_beat = counters.cycles;
+                counters.last_beat = counters.cycles;
+                beats++;
+            }
+            // the next lane still open after l (l itself if it is the only one)
+            int next = l;
+            for (int k = PORT_LANES - 1; k > 0; k--)
+            {
+#pragma HLS unroll
+                const int c = (l + k) % PORT_LANES;
+                if (open[c])
+                    next = c;
+            }
+            l = next;
+        }
+    }
+    if (in_word != 0)
+    {
+        // align a partial last word to the bottom
+        words.write(word >> (SINK_FROM_AIE_PLIO_WIDTH * (SINK_FROM_AIE_BEATS_PER_WORD - in_word)));
+        num_words++;
+        in_burst++;
+    }
+    if (in_burst != 0)
+        bursts.write(in_burst);
+    bursts.write(0);
+    produced.write(beats * SINK_FROM_AIE_ELEMENTS_PER_BEAT);
+#if SYSTEM_MOVER_STATS
+    counters.beats = beats;
+    counters.words = num_words;
+    stats.write(counters.record());
+#endif
+}
+
+// Stage 2 of a framed output: writes the words of every burst announced by collect_framed(), until the 0 that
+// ends the job
+static void write_framed(hls::stream<ap_uint<16>>& bursts, hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words, ap_uint<SINK_FROM_AIE_MEM_WIDTH>* output)
+{
+    int base = 0;
+    for (int n = bursts.read(); n != 0; n = bursts.read())
+    {
+        for (int w = 0; w < n; w++)
+        {
+#pragma HLS pipeline II=1
+#pragma HLS loop_tripcount max=SINK_FROM_AIE_MAX_BURST_LENGTH
+            output[base + w] = words.read();
+        }
+        base += n;
+    }
+}
+
+// Last stage of a framed output: the number of elements written by every port, once all of them are done
+static void write_produced(hls::stream<ap_uint<64>> counts[SYSTEM_MEM_PORTS], ap_uint<64>* produced)
+{
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+    {
+#pragma HLS pipeline II=1
+        produced[p] = counts[p].read();
+    }
+}
+#endif
+
+#if SYSTEM_JOB_DESCRIPTORS
+// Stage 1 with job descriptors: collects every job like a whole run
+template <int PORT>
+static void collect_jobs(int num_jobs, hls::stream<int32_t>& beats, hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS],
+    hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words)
+{
+    for (int j = 0; j < num_jobs; j++)
+        collect<PORT>(beats.read(), input_stream, words);
+}
+
+#if SYSTEM_MOVER_STATS
+// the same, with the counters of every job summed in one record per run
+template <int PORT>
+static void collect_jobs_stats(int num_jobs, hls::stream<int32_t>& beats, hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS],
+    hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words, hls::stream<ap_uint<MOVER_STATS_WIDTH>>& stats)
+{
+    mover_counters counters;
+    for (int j = 0; j < num_jobs; j++)
+        collect_counted<PORT>(beats.read(), input_stream, words, counters);
+    stats.write(counters.record());
+}
+#endif
+
+// Stage 2 with job descriptors: writes the slice of the port of every job where the table puts it
+static void write_job_output(int num_jobs, hls::stream<job_slice>& slices, hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words, ap_uint<SINK_FROM_AIE_MEM_WIDTH>* output)
+{
+    for (int j = 0; j < num_jobs; j++)
+    {
+        const job_slice slice = slices.read();
+        const int num_words = (slice.beats + SINK_FROM_AIE_BEATS_PER_WORD - 1) / SINK_FROM_AIE_BEATS_PER_WORD;
+        for (int w = 0; w < num_words; w++)
+        {
+#pragma HLS pipeline II=1
+            output[slice.first_word + w] = words.read();
+        }
+    }
+}
+#endif
+
+#if SYSTEM_PACKET_SWITCHING
+// Stage 1 with packet switching: the pktmerge of the graph interleaves the packets of the PORT_LANES lanes of the
+// port on its stream PORT, whole packets at a time but in any order. The id in the header gives the lane of each
+// packet and every lane counts its packets: packet k of lane l is block k * PORT_LANES + l of the slice, the one
+// setup_aie took its input from. The block index goes to the writer ahead of the words of the block. The data is
+// shifted by the 32-bit header (see distribute_packets() in setup_aie.cpp), so every beat of the block takes the
+// upper words of a beat and the first word of the next one. One loop over the beats of all the packets, one beat
+// per cycle.
+template <int PORT>
+static void collect_packets(int num_packets, hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS], hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words,
+    hls::stream<int>& blocks)
+{
+    const int data_beats = PACKET_BEATS(SINK_FROM_AIE_PLIO_WIDTH) - 1;
+    const int num_beats = num_packets * (data_beats + 1);
+    int received[PORT_LANES];
+#pragma HLS array_partition variable=received complete
+    for (int l = 0; l < PORT_LANES; l++)
+    {
+#pragma HLS unroll
+        received[l] = 0;
+    }
+    int b = 0;
+    int in_word = 0;
+    ap_uint<SINK_FROM_AIE_PLIO_WIDTH> prev = 0;
+    ap_uint<SINK_FROM_AIE_MEM_WIDTH> word = 0;
+    for (int i = 0; i < num_beats; i++)
+    {
+#pragma HLS pipeline II=1
+        const ap_uint<SINK_FROM_AIE_PLIO_WIDTH> in = input_stream[PORT].read().data;
+        if (b == 0)
+        {
+            const int lane = packet_id(in.range(31, 0));
+            blocks.write(received[lane] * PORT_LANES + lane);
+            received[lane]++;
+        }
+        else
+        {
+            ap_uint<SINK_FROM_AIE_PLIO_WIDTH> beat;
+            beat.range(SINK_FROM_AIE_PLIO_WIDTH - 1, SINK_FROM_AIE_PLIO_WIDTH - 32) = in.range(31, 0);
+            if (SINK_FROM_AIE_PLIO_WIDTH > 32)
+                beat.range(SINK_FROM_AIE_PLIO_WIDTH - 33, 0) = prev.range(SINK_FROM_AIE_PLIO_WIDTH - 1, 32);
+            // shift the beat in from the top, like collect_round()
+            word >>= SINK_FROM_AIE_PLIO_WIDTH;
+            word.range(SINK_FROM_AIE_MEM_WIDTH - 1, SINK_FROM_AIE_MEM_WIDTH - SINK_FROM_AIE_PLIO_WIDTH) = beat;
+            if (++in_word == SINK_FROM_AIE_BEATS_PER_WORD)
+            {
+                words.write(word);
+                in_word = 0;
+            }
+        }
+        prev = in;
+        b = b == data_beats ? 0 : b + 1;
+    }
+}
+
+// Stage 2 with packet switching: writes the words of every block where collect_packets() says, one burst each
+static void write_packets(int num_packets, hls::stream<int>& blocks, hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>>& words, ap_uint<SINK_FROM_AIE_MEM_WIDTH>* output)
+{
+    for (int n = 0; n < num_packets; n++)
+    {
+        const int base = blocks.read() * PACKET_WORDS;
+        for (int w = 0; w < PACKET_WORDS; w++)
+        {
+#pragma HLS pipeline II=1
+            output[base + w] = words.read();
+        }
+    }
+}
+#endif
+
+#if SYSTEM_PACKET_SWITCHING
+// packet collector and writer of memory port p: num_beats beats of the slice, in blocks of one kernel buffer
+#define SINK_FROM_AIE_PORT(p, output) \
+    collect_packets<p>(num_beats / (PACKET_BEATS(SINK_FROM_AIE_PLIO_WIDTH) - 1), input_stream, words[p], blocks[p]); \
+    write_packets(num_beats / (PACKET_BEATS(SINK_FROM_AIE_PLIO_WIDTH) - 1), blocks[p], words[p], output);
+#elif SYSTEM_JOB_DESCRIPTORS && SYSTEM_MOVER_STATS
+// collector and writer of memory port p, job by job, with their counters
+#define SINK_FROM_AIE_PORT(p, output) \
+    collect_jobs_stats<p>(num_jobs, beats[p], input_stream, words[p], records[p]); \
+    write_job_output(num_jobs, slices[p], words[p], output);
+#elif SYSTEM_JOB_DESCRIPTORS
+// collector and writer of memory port p, job by job
+#define SINK_FROM_AIE_PORT(p, output) \
+    collect_jobs<p>(num_jobs, beats[p], input_stream, words[p]); \
+    write_job_output(num_jobs, slices[p], words[p], output);
+#elif SYSTEM_FRAMED_OUTPUT && SYSTEM_MOVER_STATS
+// framed collector and writer of memory port p, with their counters
+#define SINK_FROM_AIE_PORT(p, output) \
+    collect_framed<p>(num_beats, input_stream, words[p], bursts[p], counts[p], records[p]); \
+    write_framed(bursts[p], words[p], output);
+#elif SYSTEM_FRAMED_OUTPUT
+// framed collector and writer of memory port p
+#define SINK_FROM_AIE_PORT(p, output) \
+    collect_framed<p>(num_beats, input_stream, words[p], bursts[p], counts[p]); \
+    write_framed(bursts[p], words[p], output);
+#elif SYSTEM_MOVER_STATS
+// collector and writer of memory port p, with their counters
+#define SINK_FROM_AIE_PORT(p, output) \
+    collect_stats<p>(num_beats, input_stream, words[p], records[p]); \
+    write_output(num_words, words[p], output);
+#else
+// collector and writer of memory port p
+#define SINK_FROM_AIE_PORT(p, output) \
+    collect<p>(num_beats, input_stream, words[p]); \
+    write_output(num_words, words[p], output);
+#endif
+
+#if SYSTEM_FREE_RUNNING
+// collector and writer of memory port p, on the slice of one job of the command ring
+#define SINK_FROM_AIE_RING_PORT(p, output) \
+    collect<p>(slice.beats, input_stream, words[p]); \
+    write_output(num_words, words[p], output + slice.first_word);
+
+// One job of the command ring, moved like a run of one job: a dataflow region of its own, that the free-running
+// top level calls for every command it gets
+static void move_job(job_slice slice, hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS],
+    MEM_PORT_PARAMS(ap_uint<SINK_FROM_AIE_MEM_WIDTH>*, output))
+{
+#pragma HLS dataflow
+    const int num_words = (slice.beats + SINK_FROM_AIE_BEATS_PER_WORD - 1) / SINK_FROM_AIE_BEATS_PER_WORD;
+
+    hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>> words[SYSTEM_MEM_PORTS];
+DO_PRAGMA(HLS stream variable=words depth=SINK_FROM_AIE_FIFO_DEPTH)
+
+    SINK_FROM_AIE_RING_PORT(0, output)
+#if SYSTEM_MEM_PORTS > 1
+    SINK_FROM_AIE_RING_PORT(1, output_1)
+#endif
+#if SYSTEM_MEM_PORTS > 2
+    SINK_FROM_AIE_RING_PORT(2, output_2)
+    SINK_FROM_AIE_RING_PORT(3, output_3)
+#endif
+}
+#endif
+
 extern "C" {
-// We need 1 input stream, from AIE
-// We need 1 write what the AIE sends to the PL, into memory
+// We need CU_PLIOS input streams, from AIE (SINK_FROM_AIE_PLIO_WIDTH-bit PLIOs)
+// We need SYSTEM_MEM_PORTS outputs to write what the AIE sends to the PL, into memory (512-bit bursts)
 // We need 1 input from host
 
 void sink_from_aie(
-    hls::stream<int32_t>& input_stream, 
-    int32_t* output, 
-    int size)
+    hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS], 
+    MEM_PORT_PARAMS(ap_uint<SINK_FROM_AIE_MEM_WIDTH>*, output),
+    int size
+    MOVER_STATS_PARAM(stats)
+    SINK_FROM_AIE_PRODUCED_PARAM(produced)
+    JOB_DESCRIPTORS_PARAM(jobs))
 {
 
 // PRAGMA for stream
 #pragma HLS interface axis port=input_stream // there are several options, just look for them :) 
 // PRAGMA for memory interation - AXI master-slave
-#pragma HLS INTERFACE m_axi port=output depth=100 offset=slave bundle=gmem1
+// one bundle for each memory port (see the sp lines of linking/xclbin_overlay.cfg)
+DO_PRAGMA(HLS INTERFACE m_axi port=output depth=SINK_FROM_AIE_COSIM_DEPTH offset=slave bundle=gmem1 max_write_burst_length=SINK_FROM_AIE_MAX_BURST_LENGTH num_write_outstanding=SINK_FROM_AIE_NUM_WRITE_OUTSTANDING)
 #pragma HLS INTERFACE s_axilite port=output bundle=control
+#if SYSTEM_MEM_PORTS > 1
+DO_PRAGMA(HLS INTERFACE m_axi port=output_1 depth=SINK_FROM_AIE_COSIM_DEPTH offset=slave bundle=gmem2 max_write_burst_length=SINK_FROM_AIE_MAX_BURST_LENGTH num_write_outstanding=SINK_FROM_AIE_NUM_WRITE_OUTSTANDING)
+#pragma HLS INTERFACE s_axilite port=output_1 bundle=control
+#endif
+#if SYSTEM_MEM_PORTS > 2
+DO_PRAGMA(HLS INTERFACE m_axi port=output_2 depth=SINK_FROM_AIE_COSIM_DEPTH offset=slave bundle=gmem3 max_write_burst_length=SINK_FROM_AIE_MAX_BURST_LENGTH num_write_outstanding=SINK_FROM_AIE_NUM_WRITE_OUTSTANDING)
+DO_PRAGMA(HLS INTERFACE m_axi port=output_3 depth=SINK_FROM_AIE_COSIM_DEPTH offset=slave bundle=gmem4 max_write_burst_length=SINK_FROM_AIE_MAX_BURST_LENGTH num_write_outstanding=SINK_FROM_AIE_NUM_WRITE_OUTSTANDING)
+#pragma HLS INTERFACE s_axilite port=output_2 bundle=control
+#pragma HLS INTERFACE s_axilite port=output_3 bundle=control
+#endif
+#if SYSTEM_MOVER_STATS
+// the counters of every port (see mover_stats.hpp), on their own bundle
+DO_PRAGMA(HLS INTERFACE m_axi port=stats depth=SYSTEM_MEM_PORTS offset=slave bundle=stats)
+#pragma HLS INTERFACE s_axilite port=stats bundle=control
+#endif
+#if SYSTEM_FRAMED_OUTPUT
+// the number of elements written by every port, on its own bundle
+DO_PRAGMA(HLS INTERFACE m_axi port=produced depth=SYSTEM_MEM_PORTS offset=slave bundle=produced)
+#pragma HLS INTERFACE s_axilite port=produced bundle=control
+#endif
+#if SYSTEM_JOB_DESCRIPTORS
+// the job table (see job_descriptors.hpp), on its own bundle
+DO_PRAGMA(HLS INTERFACE m_axi port=jobs depth=SINK_FROM_AIE_COSIM_JOBS offset=slave bundle=jobs)
+#pragma HLS INTERFACE s_axilite port=jobs bundle=control
+#endif
 // PRAGMA for AXI-LITE : required to move params from host to PL
 #pragma HLS interface s_axilite port=size bundle=control
 #pragma HLS interface s_axilite port=return bundle=control
 
-    for (int i = 0; i < size; i++)
+#if SYSTEM_FREE_RUNNING
+    // size is the number of command slots of the ring in jobs, that the mover serves until the stop command (see
+    // command_ring.hpp)
+    int slot = 0;
+    for (ap_uint<32> n = 0; size > 0; n++)
     {
-        int32_t x = input_stream.read();
-        output[i] = x;
+        const ap_uint<JOB_DESC_WIDTH> command = wait_command(jobs, n, slot);
+        const uint32_t elements = command.range(32 * JOB_SIZE + 31, 32 * JOB_SIZE);
+        const bool stop = elements == RING_STOP;
+        if (!stop)
+            move_job(port_slice<JOB_OUTPUT, SINK_FROM_AIE_ELEMENTS_PER_BEAT>(command), input_stream, MEM_PORT_NAMES(output));
+        complete_command(jobs, size, n, slot, stop ? 0 : elements);
+        if (stop)
+            break;
+        slot = slot == size - 1 ? 0 : slot + 1;
     }
+#else
+#pragma HLS dataflow
+
+    // size is the number of elements of data_t, each beat carries SINK_FROM_AIE_ELEMENTS_PER_BEAT of them (4
+    // int32_t with 128-bit PLIOs) and each word SINK_FROM_AIE_BEATS_PER_WORD beats.
+    // Each memory port writes size / SYSTEM_MEM_PORTS elements to its own buffer, padded to a multiple of 64 bytes.
+    // With SYSTEM_FRAMED_OUTPUT size is the capacity of the buffer instead: the lanes decide how much they send.
+    // With SYSTEM_JOB_DESCRIPTORS size is the number of jobs of the table, each written as described above.
+    // With SYSTEM_PACKET_SWITCHING the slice of each port comes back in packets, see collect_packets().
+    int num_beats = size / SYSTEM_MEM_PORTS / SINK_FROM_AIE_ELEMENTS_PER_BEAT;
+    int num_words = (num_beats + SINK_FROM_AIE_BEATS_PER_WORD - 1) / SINK_FROM_AIE_BEATS_PER_WORD;
+
+    hls::stream<ap_uint<SINK_FROM_AIE_MEM_WIDTH>> words[SYSTEM_MEM_PORTS];
+DO_PRAGMA(HLS stream variable=words depth=SINK_FROM_AIE_FIFO_DEPTH)
+
+#if SYSTEM_MOVER_STATS
+    hls::stream<ap_uint<MOVER_STATS_WIDTH>> records[SYSTEM_MEM_PORTS];
+#endif
+#if SYSTEM_PACKET_SWITCHING
+    hls::stream<int> blocks[SYSTEM_MEM_PORTS];
+DO_PRAGMA(HLS stream variable=blocks depth=4)
+#endif
+#if SYSTEM_FRAMED_OUTPUT
+    hls::stream<ap_uint<16>> bursts[SYSTEM_MEM_PORTS];
+DO_PRAGMA(HLS stream variable=bursts depth=4)
+    hls::stream<ap_uint<64>> counts[SYSTEM_MEM_PORTS];
+#endif
+#if SYSTEM_JOB_DESCRIPTORS
+    int num_jobs = size;
+    hls::stream<job_slice> slices[SYSTEM_MEM_PORTS];
+    hls::stream<int32_t> beats[SYSTEM_MEM_PORTS];
+DO_PRAGMA(HLS stream variable=slices depth=SINK_FROM_AIE_JOB_FIFO_DEPTH)
+DO_PRAGMA(HLS stream variable=beats depth=SINK_FROM_AIE_JOB_FIFO_DEPTH)
+    read_jobs<JOB_OUTPUT, SINK_FROM_AIE_ELEMENTS_PER_BEAT>(num_jobs, jobs, slices, beats);
+#endif
+
+    SINK_FROM_AIE_PORT(0, output)
+#if SYSTEM_MEM_PORTS > 1
+    SINK_FROM_AIE_PORT(1, output_1)
+#endif
+#if SYSTEM_MEM_PORTS > 2
+    SINK_FROM_AIE_PORT(2, output_2)
+    SINK_FROM_AIE_PORT(3, output_3)
+#endif
+#if SYSTEM_MOVER_STATS
+    write_stats(records, stats);
+#endif
+#if SYSTEM_FRAMED_OUTPUT
+    write_produced(counts, produced);
+#endif
+#endif
 }
 }
 // extern "C"
@@ -3,12 +3,75 @@
 
 #include <cstdint>
 #include <hls_stream.h>
+#include <ap_int.h>
+#include <ap_axi_sdata.h>
+#include "../common/common.h"
+#include "mover_stats.hpp"
+#include "job_descriptors.hpp"
+#include "command_ring.hpp"
+#include "packet_header.hpp"
+
+// Width of the AIE output PLIO (set in common/system_config.h) and of the memory-side port
+#define SINK_FROM_AIE_PLIO_WIDTH SYSTEM_PLIO_OUT_WIDTH
+#define SINK_FROM_AIE_MEM_WIDTH 512
+#define SINK_FROM_AIE_BEATS_PER_WORD (SINK_FROM_AIE_MEM_WIDTH / SINK_FROM_AIE_PLIO_WIDTH)
+// elements of data_t (see common/constants.h) in each beat
+#define SINK_FROM_AIE_DATA_BITS (sizeof(data_t) * 8)
+#define SINK_FROM_AIE_ELEMENTS_PER_BEAT (SINK_FROM_AIE_PLIO_WIDTH / SINK_FROM_AIE_DATA_BITS)
+
+// The output is striped over SYSTEM_MEM_PORTS m_axi ports (output, output_1, ...) like the input of setup_aie:
+// port p collects lanes p * PORT_LANES ... (p + 1) * PORT_LANES - 1 into the slice p of the buffer.
+// Collection of the beats from the PORT_LANES lanes of a port, one beat per lane each round (same order as
+// setup_aie): with fewer lanes than beats per word a word is filled by SINK_FROM_AIE_ROUNDS_PER_WORD rounds,
+// with more lanes a round fills SINK_FROM_AIE_WORDS_PER_ROUND words
+#define SINK_FROM_AIE_ROUNDS_PER_WORD (PORT_LANES < SINK_FROM_AIE_BEATS_PER_WORD ? SINK_FROM_AIE_BEATS_PER_WORD / PORT_LANES : 1)
+#define SINK_FROM_AIE_WORDS_PER_ROUND (PORT_LANES > SINK_FROM_AIE_BEATS_PER_WORD ? PORT_LANES / SINK_FROM_AIE_BEATS_PER_WORD : 1)
+static_assert((NUM_LANES & (NUM_LANES - 1)) == 0, "NUM_LANES must be a power of two");
+static_assert(NUM_LANES % (SYSTEM_COMPUTE_UNITS * SYSTEM_MEM_PORTS) == 0, "every memory port collects the same number of lanes");
+// the lanes are interleaved beat by beat, so the beats must carry as many elements as those of setup_aie
+static_assert(NUM_LANES == 1 || SYSTEM_PLIO_IN_WIDTH == SYSTEM_PLIO_OUT_WIDTH, "with more lanes the input and output PLIOs must have the same width");
+static_assert(SINK_FROM_AIE_PLIO_WIDTH % SINK_FROM_AIE_DATA_BITS == 0, "the beats must carry whole elements");
+
+// With SYSTEM_FRAMED_OUTPUT the AIE kernels decide how much they output: every lane ends each job with a trailer
+// beat carrying TLAST, sink_from_aie writes the beats up to the trailers and then the number of elements each port
+// wrote to the produced buffer (one 64-bit count per port), which the host reads to sync back only those
+#if SYSTEM_FRAMED_OUTPUT
+#define SINK_FROM_AIE_PRODUCED_PARAM(name) , ap_uint<64>* name
+#define SINK_FROM_AIE_PRODUCED_ARG(name) , name
+#else
+#define SINK_FROM_AIE_PRODUCED_PARAM(name)
+#define SINK_FROM_AIE_PRODUCED_ARG(name)
+#endif
+
+// AXI burst tuning of the writer stage, can be overridden at compile time (see MAX_BURST_LENGTH and
+// NUM_WRITE_OUTSTANDING in fpga/Makefile)
+#ifndef SINK_FROM_AIE_MAX_BURST_LENGTH
+#define SINK_FROM_AIE_MAX_BURST_LENGTH 64
+#endif
+#ifndef SINK_FROM_AIE_NUM_WRITE_OUTSTANDING
+#define SINK_FROM_AIE_NUM_WRITE_OUTSTANDING 16
+#endif
+
+// With SYSTEM_PACKET_SWITCHING the PORT_LANES lanes of each port share one stream, input_stream[p] for port p: every
+// packet is one kernel buffer, written back to the block of the slice it was taken from (see packet_header.hpp)
+
+// Depth of the FIFO between the width converter and the writer: it must absorb a full burst
+#define SINK_FROM_AIE_FIFO_DEPTH (SINK_FROM_AIE_MAX_BURST_LENGTH * 2)
+// Number of 512-bit words each m_axi port exposes to C/RTL cosimulation
+#define SINK_FROM_AIE_COSIM_DEPTH 65536
+// With SYSTEM_JOB_DESCRIPTORS: jobs the table (or entries the command ring) exposes to C/RTL cosimulation, and
+// jobs the table reader can be ahead of the ports
+#define SINK_FROM_AIE_COSIM_JOBS 1024
+#define SINK_FROM_AIE_JOB_FIFO_DEPTH 16
 
 extern "C" {
     void sink_from_aie(
-        hls::stream<int32_t>& input_stream, 
-        int32_t* output, 
-        int size);
+        hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> input_stream[CU_PLIOS], 
+        MEM_PORT_PARAMS(ap_uint<SINK_FROM_AIE_MEM_WIDTH>*, output),
+        int size
+        MOVER_STATS_PARAM(stats)
+        SINK_FROM_AIE_PRODUCED_PARAM(produced)
+        JOB_DESCRIPTORS_PARAM(jobs));
 }
 
 #endif // SINK_FROM_AIE_HPP
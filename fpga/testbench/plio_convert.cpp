@@ -0,0 +1,58 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <iostream>
+#include <string>
+#include "utils.hpp"
+
+// Converts PLIO data files between the text format of the AIE simulators and binary traces (see utils.hpp), so
+// that large testbench inputs are generated and checked in binary and only converted for the simulator
+static int usage(const char* name) {
+    std::cerr << "Usage: " << name << " to-trace <TEXT> <TRACE> <BEAT_BITS> <ELEMENT_BITS> [int|uint|float]" << std::endl
+              << "       " << name << " to-text <TRACE> <TEXT>" << std::endl;
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    const std::string mode = argc > 1 ? argv[1] : "";
+    try {
+        if (mode == "to-trace" && (argc == 6 || argc == 7)) {
+            const std::string type = argc == 7 ? argv[6] : "int";
+            plio_trace_format format = PLIO_TRACE_INT;
+            if (type == "uint") format = PLIO_TRACE_UINT;
+            else if (type == "float") format = PLIO_TRACE_FLOAT;
+            else if (type != "int") return usage(argv[0]);
+            aie_text_to_trace(argv[2], argv[3], std::stoi(argv[4]), std::stoi(argv[5]), format);
+        }
+        else if (mode == "to-text" && argc == 4) {
+            trace_to_aie_text(argv[2], argv[3]);
+        }
+        else {
+            return usage(argv[0]);
+        }
+    } catch (const std::exception&) {
+        return 1;
+    }
+    return 0;
+}
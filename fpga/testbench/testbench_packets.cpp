@@ -0,0 +1,187 @@
+/*
+MIT License
+
+Copyright (c) 2023 Paolo Salvatore Galfano, Giuseppe Sorrentino
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <iostream>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "../setup_aie.hpp"
+#include "../sink_from_aie.hpp"
+
+#if !SYSTEM_PACKET_SWITCHING
+#error "testbench_packets needs packet_switching = yes in kernel.cfg"
+#endif
+
+// This testbench checks the packet switched path (SYSTEM_PACKET_SWITCHING) from end to end: setup_aie sends the
+// slice of every memory port as packets on the stream of the port, the testbench plays the graph (a pktsplit that
+// hands every packet to the buffer of its lane, kernels that copy their buffers and a pktmerge that sends the output
+// buffers back in an order of its own) and sink_from_aie must put every block back where it came from.
+// On the way it checks the framing of every packet sent by setup_aie: the header with the id of the lane and its
+// parity, TLAST on the last beat only, and a last beat that only holds the last word of the buffer.
+// The II=1 of distribute_packets() and collect_packets() is checked on the synthesis reports, as for
+// testbench_setupaie_burst.cpp.
+
+// sizes in number of data_t elements, rounded down to a multiple of SYSTEM_SIZE_ALIGN (at least one buffer per
+// lane). The largest must fit SETUP_AIE_COSIM_DEPTH words
+static const int32_t test_sizes[] = {SYSTEM_SIZE_ALIGN, 3 * SYSTEM_SIZE_ALIGN, 1 << 20};
+
+// each 512-bit word packs ELEMENTS_PER_WORD consecutive elements of SETUP_AIE_DATA_BITS bits
+static const int32_t ELEMENTS_PER_WORD = SETUP_AIE_MEM_WIDTH / SETUP_AIE_DATA_BITS;
+// the 32-bit words of a kernel buffer
+static const int BUFFER_WORDS = SYSTEM_PACKET_ELEMENTS * SYSTEM_DATA_BITS / 32;
+// the movers only move bits: the testbench packs integer patterns as wide as data_t (the same for float and bfloat16)
+typedef ap_int<SETUP_AIE_DATA_BITS> element_t;
+
+// pktsplit and tile DMA of the lanes of a port: reads the packets of the stream and returns the buffers of every
+// lane in order, as 32-bit words
+std::vector<std::deque<std::vector<uint32_t>>> split_packets(hls::stream<setup_aie_beat>& s, int& errors) {
+    std::vector<std::deque<std::vector<uint32_t>>> buffers(PORT_LANES);
+    const int words_per_beat = SETUP_AIE_PLIO_WIDTH / 32;
+    while (!s.empty()) {
+        std::vector<uint32_t> packet;
+        bool last = false;
+        while (!last && !s.empty()) {
+            const setup_aie_beat beat = s.read();
+            last = beat.last;
+            const int words = last ? 1 : words_per_beat;
+            if (last && beat.keep != 0xF)
+                errors++;
+            for (int w = 0; w < words; w++)
+                packet.push_back(beat.data.range(32 * w + 31, 32 * w).to_uint());
+        }
+        const ap_uint<32> header = packet[0];
+        if (!last || (int) packet.size() != BUFFER_WORDS + 1 || header != packet_header(packet_id(header)) || packet_id(header) >= PORT_LANES) {
+            if (errors < 10)
+                std::cout << "ERROR: malformed packet of " << packet.size() << " words, header " << std::hex << packet[0] << std::dec << std::endl;
+            errors++;
+            continue;
+        }
+        buffers[packet_id(header)].emplace_back(packet.begin() + 1, packet.end());
+    }
+    return buffers;
+}
+
+// tile DMA and pktmerge of the lanes of a port: sends every buffer back as a packet, with the header of an AIE
+// tile (its own row and column) and the id of the lane. The lanes take turns backwards, a lane with a higher id
+// going first, so the packets reach sink_from_aie in another order than setup_aie sent them
+void merge_packets(std::vector<std::deque<std::vector<uint32_t>>>& buffers, hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>>& s) {
+    const int words_per_beat = SINK_FROM_AIE_PLIO_WIDTH / 32;
+    for (bool sent = true; sent;) {
+        sent = false;
+        for (int l = PORT_LANES - 1; l >= 0; l--) {
+            if (buffers[l].empty())
+                continue;
+            std::vector<uint32_t> packet = buffers[l].front();
+            buffers[l].pop_front();
+            ap_uint<32> header = 0;
+            header.range(4, 0) = l;
+            header.range(20, 16) = 1;
+            header.range(27, 21) = 10 + l;
+            packet.insert(packet.begin(), header.to_uint());
+            for (size_t w = 0; w < packet.size(); w += words_per_beat) {
+                ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0> beat;
+                beat.data = 0;
+                for (int k = 0; k < words_per_beat && w + k < packet.size(); k++)
+                    beat.data.range(32 * k + 31, 32 * k) = packet[w + k];
+                beat.last = w + words_per_beat >= packet.size();
+                s.write(beat);
+            }
+            sent = true;
+        }
+    }
+}
+
+int run_test(int32_t size) {
+    size -= size % SYSTEM_SIZE_ALIGN;
+    // every memory port reads and writes its own contiguous slice of the buffers
+    const int32_t slice = size / SYSTEM_MEM_PORTS;
+    const int32_t num_words = (slice + ELEMENTS_PER_WORD - 1) / ELEMENTS_PER_WORD;
+    ap_uint<SETUP_AIE_MEM_WIDTH> *input[SYSTEM_MEM_PORTS], *output[SYSTEM_MEM_PORTS];
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+        input[p] = new ap_uint<SETUP_AIE_MEM_WIDTH>[num_words];
+        output[p] = new ap_uint<SETUP_AIE_MEM_WIDTH>[num_words];
+    }
+    for (int32_t i = 0; i < size; i++) {
+        const int32_t lsb = (i % slice % ELEMENTS_PER_WORD) * SETUP_AIE_DATA_BITS;
+        input[i / slice][i % slice / ELEMENTS_PER_WORD].range(lsb + SETUP_AIE_DATA_BITS - 1, lsb) = (element_t) (i * 3 + 1);
+    }
+
+    hls::stream<setup_aie_beat> s[CU_PLIOS];
+    hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> r[CU_PLIOS];
+    ap_uint<MOVER_STATS_WIDTH> stats[SYSTEM_MEM_PORTS];
+    ap_uint<64> produced[SYSTEM_MEM_PORTS];
+    ap_uint<JOB_DESC_WIDTH> jobs[RING_ENTRIES(RING_LINE)];
+    setup_aie(size, MEM_PORT_ARGS(input) MOVER_STATS_ARG(stats) JOB_DESCRIPTORS_ARG(jobs), s);
+
+    int errors = 0;
+    for (int p = 0; p < CU_PLIOS; p++) {
+        std::vector<std::deque<std::vector<uint32_t>>> buffers = split_packets(s[p], errors);
+        // every lane gets the same number of buffers
+        for (int l = 0; l < PORT_LANES; l++) {
+            if ((int32_t) buffers[l].size() != slice / SYSTEM_PACKET_ELEMENTS / PORT_LANES) {
+                std::cout << "ERROR: size " << size << ": lane " << l << " of port " << p << " got " << buffers[l].size() << " buffers" << std::endl;
+                errors++;
+            }
+        }
+        merge_packets(buffers, r[p]);
+    }
+    sink_from_aie(r, MEM_PORT_ARGS(output), size MOVER_STATS_ARG(stats) SINK_FROM_AIE_PRODUCED_ARG(produced) JOB_DESCRIPTORS_ARG(jobs));
+
+    for (int p = 0; p < CU_PLIOS; p++) {
+        if (!r[p].empty()) {
+            std::cout << "ERROR: size " << size << ": sink_from_aie left " << r[p].size() << " beats on port " << p << std::endl;
+            errors++;
+        }
+    }
+    for (int32_t i = 0; i < size; i++) {
+        const int32_t lsb = (i % slice % ELEMENTS_PER_WORD) * SETUP_AIE_DATA_BITS;
+        const element_t val = output[i / slice][i % slice / ELEMENTS_PER_WORD].range(lsb + SETUP_AIE_DATA_BITS - 1, lsb);
+        // narrow types wrap around, as they do in the input buffer
+        if (val != (element_t) (i * 3 + 1)) {
+            if (errors < 10)
+                std::cout << "ERROR: size " << size << ": element " << i << " is " << (int) val << std::endl;
+            errors++;
+        }
+    }
+
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+        delete[] input[p];
+        delete[] output[p];
+    }
+    std::cout << "size " << size << ": " << size / SYSTEM_PACKET_ELEMENTS << " packets on " << CU_PLIOS << " PLIO(s) for " << CU_LANES << " lanes, "
+              << (errors ? "FAILED" : "passed") << std::endl;
+    return errors;
+}
+
+int main(int argc, char* argv[]) {
+    int errors = 0;
+    for (int32_t size : test_sizes) {
+        errors += run_test(size);
+    }
+    if (errors) {
+        std::cout << "Test failed with " << errors << " errors" << std::endl;
+        return 1;
+    }
+    std::cout << "Test passed!" << std::endl;
+    return 0;
+}
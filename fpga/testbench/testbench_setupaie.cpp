@@ -29,6 +29,10 @@ SOFTWARE.
 #include <cmath>
 #include "../setup_aie.hpp"
 #include <iostream>
+#include <string>
+
+// the movers only move bits: the testbench packs integer patterns as wide as data_t (the same for float and bfloat16)
+typedef ap_int<SETUP_AIE_DATA_BITS> element_t;
 
 void read_from_stream(float *buffer, hls::stream<float> &stream, size_t size) {
     for (unsigned int i = 0; i < size; i++) {
@@ -36,16 +40,38 @@ void read_from_stream(float *buffer, hls::stream<float> &stream, size_t size) {
     }
 }
 
-int main(int argc, char* argv[]) {
+int main() {
     // In a testbench, you will use you kernel as a C function
     // You will need to create the input and output of your function
-    hls::stream<ap_int<sizeof(float)*8*4>> s;
-    int size = 32;
-    int *input = new int[32];
-    for (unsigned int i = 0; i < size; i++) {
-        input[i] = i;
+    // one stream for each lane of the compute unit (see CU_LANES in common/common.h), or for each memory port
+    // with SYSTEM_PACKET_SWITCHING (CU_PLIOS), whose job gives one buffer to every lane
+    hls::stream<setup_aie_beat> s[CU_PLIOS];
+    int size = SYSTEM_PACKET_SWITCHING ? SYSTEM_SIZE_ALIGN : 32;
+    // The kernel reads 512-bit words, each one packing 512 / SETUP_AIE_DATA_BITS consecutive elements of data_t
+    // (16 int32_t, 32 int16_t or 64 int8_t). With SYSTEM_MEM_PORTS > 1 each port reads a contiguous slice of the
+    // input from its own buffer
+    const int elements_per_word = SETUP_AIE_MEM_WIDTH / SETUP_AIE_DATA_BITS;
+    const int slice = size / SYSTEM_MEM_PORTS;
+    ap_uint<SETUP_AIE_MEM_WIDTH> *input[SYSTEM_MEM_PORTS];
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+        input[p] = new ap_uint<SETUP_AIE_MEM_WIDTH>[(slice + elements_per_word - 1) / elements_per_word];
+    for (int i = 0; i < size; i++) {
+        const int lsb = (i % slice % elements_per_word) * SETUP_AIE_DATA_BITS;
+        input[i / slice][i % slice / elements_per_word].range(lsb + SETUP_AIE_DATA_BITS - 1, lsb) = (element_t) i;
     }
-    setup_aie(size, input, s);
+#if SYSTEM_MOVER_STATS
+    // performance counters of the ports
+    ap_uint<MOVER_STATS_WIDTH> stats[SYSTEM_MEM_PORTS];
+#endif
+    // with SYSTEM_JOB_DESCRIPTORS the run is a table of one job, at the start of every slice (with
+    // SYSTEM_FREE_RUNNING a command ring with that job)
+    ap_uint<JOB_DESC_WIDTH> jobs[RING_ENTRIES(RING_LINE)];
+    setup_aie(single_job(jobs, size), MEM_PORT_ARGS(input) MOVER_STATS_ARG(stats) JOB_DESCRIPTORS_ARG(jobs), s);
+    // a persistent kernel serves jobs until the shutdown header, so the simulation input must end with it
+    // (aie/src/graph.cpp runs a single graph iteration)
+    const unsigned int header_frames = SYSTEM_PERSISTENT_GRAPH ? 2 : 1;
+    if (SYSTEM_PERSISTENT_GRAPH)
+        setup_aie(-1, MEM_PORT_ARGS(input) MOVER_STATS_ARG(stats) JOB_DESCRIPTORS_ARG(jobs), s);
 
     // Here you will se a warning: THIS IS THE MOST IMPORTANT PART OF THE TESTBENCH
 
@@ -58,31 +84,56 @@ int main(int argc, char* argv[]) {
     // And now? Since you want to effectively test your AIE...this code may practically write the AIE input
     // write into data 
     
-    // If the function worked I can print values in the stream and check them
-    std::ofstream file;
-    file.open("../../aie/data/in_plio_source_1.txt");
-    if (file.is_open()) {
+    // If the function worked I can print values in the stream and check them.
+#if SYSTEM_PACKET_SWITCHING
+    // The lanes of memory port p share in_plio_<p+1>, whose file holds the packets of the port: one beat per line,
+    // printed as 32-bit words like the header, and TLAST before the last beat of every packet, that only holds the
+    // last word of the buffer (see fpga/packet_header.hpp)
+    for (unsigned int p = 0; p < CU_PLIOS; p++) {
+        std::ofstream file;
+        file.open("../../aie/data/in_plio_source_" + std::to_string(p + 1) + ".txt");
+        if (!file.is_open()) {
+            std::cout << "Error opening file - Ignore this error if you are in Full_HLS_MODE - Here are the packets of port " << p << std::endl;
+        }
+        while (!s[p].empty()) {
+            setup_aie_beat beat = s[p].read();
+            const unsigned int words = beat.last ? 1 : SETUP_AIE_PLIO_WIDTH / 32;
+            if (beat.last && file.is_open())
+                file << "TLAST" << std::endl;
+            for (unsigned int j = 0; j < words; j++) {
+                int val = beat.data.range(32 * j + 31, 32 * j).to_int();
+                if (file.is_open())
+                    file << val << (j == words - 1 ? "\n" : " ");
+                std::cout << val << std::endl;
+            }
+        }
+    }
+#else
+    // Lane l gets beats l, l + CU_LANES, l + 2*CU_LANES, ... plus its own header, and it feeds in_plio_<l+1>
+    // (with SYSTEM_MEM_PORTS > 1 the same holds within the slice of each port and its PORT_LANES lanes).
+    // Each line of the file holds one PLIO beat, i.e. SETUP_AIE_ELEMENTS_PER_BEAT values (4 int32_t with 128-bit PLIOs).
+    // The header count is 32-bit whatever data_t is: with narrow types it spans the first 32 / SETUP_AIE_DATA_BITS values
+    const unsigned int size_loop = slice / SETUP_AIE_ELEMENTS_PER_BEAT;
+    for (unsigned int l = 0; l < CU_LANES; l++) {
+        unsigned int lane_loops = size_loop / PORT_LANES + (l % PORT_LANES < size_loop % PORT_LANES ? 1 : 0);
+        std::ofstream file;
+        file.open("../../aie/data/in_plio_source_" + std::to_string(l + 1) + ".txt");
+        if (!file.is_open()) {
+            std::cout << "Error opening file - Ignore this error if you are in Full_HLS_MODE - Here is the kernel output of lane " << l << std::endl;
+        }
         // read the stream of ap_int
-        ap_int<sizeof(int) * 8 * 4> tmp;
-        for (unsigned int i = 0; i < (size/4)+1; i++) {
-            tmp = s.read();
-            for (unsigned int j = 0; j < 4; j++) {
-                float val = tmp.range(31 + j * 32, j * 32);
-                file << val << std::endl;
+        ap_int<SETUP_AIE_PLIO_WIDTH> tmp;
+        for (unsigned int i = 0; i < lane_loops + SETUP_AIE_HEADER_BEATS * header_frames; i++) {
+            tmp = s[l].read();
+            for (unsigned int j = 0; j < SETUP_AIE_ELEMENTS_PER_BEAT; j++) {
+                int val = (element_t) tmp.range(SETUP_AIE_DATA_BITS - 1 + j * SETUP_AIE_DATA_BITS, j * SETUP_AIE_DATA_BITS);
+                if (file.is_open())
+                    file << val << (j == SETUP_AIE_ELEMENTS_PER_BEAT - 1 ? "\n" : " ");
                 std::cout<<val<<std::endl;
             }
         }
-    } else {
-        std::cout << "Error opening file - Ignore this error if you are in Full_HLS_MODE - Here is the kernel output" << std::endl;
-        ap_int<sizeof(int) * 8 * 4> tmp;
-            for (unsigned int i = 0; i < (size/4)+1; i++) {
-                tmp = s.read();
-                for (unsigned int j = 0; j < 4; j++) {
-                    float val = tmp.range(31 + j * 32, j * 32);
-                    std::cout<<val<<std::endl;
-                }
-            }
     }
+#endif
 
     // In a different, complete, test, here you may even run the AIE and then continue your test. But for this
     // modular test...it's enough to check the stream and the file :=).
@@ -0,0 +1,289 @@
+/*
+MIT License
+
+Copyright (c) 2023 Paolo Salvatore Galfano, Giuseppe Sorrentino
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <iostream>
+#include <cstdint>
+#include "../setup_aie.hpp"
+
+#if SYSTEM_PACKET_SWITCHING
+#error "with SYSTEM_PACKET_SWITCHING the lanes get packets: run testbench_packets instead"
+#endif
+
+// This testbench stresses the dataflow version of setup_aie with large inputs.
+// In csim it checks that every lane carries exactly its header beats plus its share of the payload beats
+// (SETUP_AIE_ELEMENTS_PER_BEAT elements each), dealt round-robin and in the right order from the slice of the
+// input read by the memory port of the lane.
+// The II=1 of the reader and of the lane distributor is checked on the synthesis report:
+//   make full_test_hls src=setup_aie.cpp tb=testbench/testbench_setupaie_burst.cpp
+//   make check_ii dir=<the generated full_test_* folder>
+// while cosim reports the achieved throughput (about one beat per lane per cycle once the first burst arrived).
+// With SYSTEM_MOVER_STATS it also checks the performance counters of every port, and with SYSTEM_JOB_DESCRIPTORS
+// that a table of jobs scattered in the buffers reaches the lanes job by job, each with its own headers (with
+// SYSTEM_FREE_RUNNING the jobs are posted to a command ring, whose completions are checked too).
+
+// sizes in number of data_t elements, rounded down to a multiple of SYSTEM_SIZE_ALIGN.
+// The largest must fit SETUP_AIE_COSIM_DEPTH words
+static const int32_t test_sizes[] = {32, 36, 4096, 1 << 20};
+
+// each 512-bit word packs ELEMENTS_PER_WORD consecutive elements of SETUP_AIE_DATA_BITS bits
+static const int32_t ELEMENTS_PER_WORD = SETUP_AIE_MEM_WIDTH / SETUP_AIE_DATA_BITS;
+// the movers only move bits: the testbench packs integer patterns as wide as data_t (the same for float and bfloat16)
+typedef ap_int<SETUP_AIE_DATA_BITS> element_t;
+
+int run_test(int32_t size) {
+    size -= size % SYSTEM_SIZE_ALIGN;
+    // every memory port reads its own contiguous slice of the input
+    const int32_t slice = size / SYSTEM_MEM_PORTS;
+    const int32_t num_words = (slice + ELEMENTS_PER_WORD - 1) / ELEMENTS_PER_WORD;
+    ap_uint<SETUP_AIE_MEM_WIDTH> *input[SYSTEM_MEM_PORTS];
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+        input[p] = new ap_uint<SETUP_AIE_MEM_WIDTH>[num_words];
+    for (int32_t i = 0; i < size; i++) {
+        const int32_t lsb = (i % slice % ELEMENTS_PER_WORD) * SETUP_AIE_DATA_BITS;
+        input[i / slice][i % slice / ELEMENTS_PER_WORD].range(lsb + SETUP_AIE_DATA_BITS - 1, lsb) = (element_t) (i * 3 + 1);
+    }
+
+    hls::stream<ap_int<SETUP_AIE_PLIO_WIDTH>> s[CU_LANES];
+    ap_uint<MOVER_STATS_WIDTH> stats[SYSTEM_MEM_PORTS];
+    // with SYSTEM_JOB_DESCRIPTORS the run is a table of one job, at the start of every slice (with
+    // SYSTEM_FREE_RUNNING a command ring with that job)
+    ap_uint<JOB_DESC_WIDTH> jobs[RING_ENTRIES(RING_LINE)];
+    setup_aie(single_job(jobs, size), MEM_PORT_ARGS(input) MOVER_STATS_ARG(stats) JOB_DESCRIPTORS_ARG(jobs), s);
+
+    const int32_t size_loop = slice / SETUP_AIE_ELEMENTS_PER_BEAT;
+    int errors = 0;
+#if SYSTEM_MOVER_STATS
+    // in csim the reader has filled the FIFO before the distributor starts and the lanes never fill, so every
+    // port moves one round per cycle without stalls
+    const int32_t rounds = (size_loop + PORT_LANES - 1) / PORT_LANES;
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+        const uint64_t cycles = stats[p].range(64 * STATS_CYCLES + 63, 64 * STATS_CYCLES);
+        const uint64_t beats = stats[p].range(64 * STATS_BEATS + 63, 64 * STATS_BEATS);
+        const uint64_t stalls = stats[p].range(64 * STATS_STALL_STREAM + 63, 64 * STATS_STALL_STREAM) + stats[p].range(64 * STATS_STALL_MEMORY + 63, 64 * STATS_STALL_MEMORY);
+        const uint64_t words = stats[p].range(64 * STATS_WORDS + 63, 64 * STATS_WORDS);
+        const uint64_t last_beat = stats[p].range(64 * STATS_LAST_BEAT + 63, 64 * STATS_LAST_BEAT);
+        if (cycles != (uint64_t) rounds || beats != (uint64_t) size_loop || stalls != 0 || words != (uint64_t) num_words || last_beat != cycles) {
+            std::cout << "ERROR: size " << size << ": port " << p << " counted " << cycles << " cycles, " << beats << " beats, "
+                      << stalls << " stalls, " << words << " words" << std::endl;
+            errors++;
+        }
+    }
+#endif
+    for (int lane = 0; lane < CU_LANES; lane++) {
+        // l is the index of the lane among the PORT_LANES lanes of its port
+        const int p = lane / PORT_LANES, l = lane % PORT_LANES;
+        const int32_t lane_loops = size_loop / PORT_LANES + (l < size_loop % PORT_LANES ? 1 : 0);
+        if ((int32_t) s[lane].size() != lane_loops + SETUP_AIE_HEADER_BEATS) {
+            std::cout << "ERROR: size " << size << ": lane " << lane << " has " << s[lane].size() << " beats, expected " << lane_loops + SETUP_AIE_HEADER_BEATS << std::endl;
+            errors++;
+        }
+
+        // the first header beat holds the number of kernel iterations, the others are zero
+        for (int h = 0; h < SETUP_AIE_HEADER_BEATS; h++) {
+            ap_int<SETUP_AIE_PLIO_WIDTH> header = s[lane].read();
+            ap_int<SETUP_AIE_PLIO_WIDTH> expected = 0;
+            if (h == 0)
+                expected.range(31, 0) = lane_loops / SETUP_AIE_BEATS_PER_VECTOR;
+            if (header != expected) {
+                std::cout << "ERROR: size " << size << ": wrong header beat " << h << " on lane " << lane << std::endl;
+                errors++;
+            }
+        }
+
+        for (int32_t i = 0; i < lane_loops && !s[lane].empty(); i++) {
+            ap_int<SETUP_AIE_PLIO_WIDTH> tmp = s[lane].read();
+            const int32_t j = p * size_loop + i * PORT_LANES + l;
+            for (int k = 0; k < SETUP_AIE_ELEMENTS_PER_BEAT; k++) {
+                // narrow types wrap around, as they do in the input buffer
+                element_t val = tmp.range(SETUP_AIE_DATA_BITS - 1 + k * SETUP_AIE_DATA_BITS, k * SETUP_AIE_DATA_BITS);
+                if (val != (element_t) ((j * SETUP_AIE_ELEMENTS_PER_BEAT + k) * 3 + 1)) {
+                    if (errors < 10)
+                        std::cout << "ERROR: size " << size << ": element " << j * SETUP_AIE_ELEMENTS_PER_BEAT + k << " is " << (int) val << std::endl;
+                    errors++;
+                }
+            }
+        }
+    }
+
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+        delete[] input[p];
+    std::cout << "size " << size << ": " << size_loop * SYSTEM_MEM_PORTS + CU_LANES * SETUP_AIE_HEADER_BEATS << " beats on " << CU_LANES << " lanes, " << (errors ? "FAILED" : "passed") << std::endl;
+    return errors;
+}
+
+// a negative size must only send the JOB_SHUTDOWN header to every lane, without reading the input
+int run_shutdown_test() {
+    hls::stream<ap_int<SETUP_AIE_PLIO_WIDTH>> s[CU_LANES];
+    ap_uint<SETUP_AIE_MEM_WIDTH> *input[SYSTEM_MEM_PORTS] = {};
+    ap_uint<MOVER_STATS_WIDTH> stats[SYSTEM_MEM_PORTS];
+    ap_uint<JOB_DESC_WIDTH> jobs[1] = {};
+    setup_aie(-1, MEM_PORT_ARGS(input) MOVER_STATS_ARG(stats) JOB_DESCRIPTORS_ARG(jobs), s);
+
+    int errors = 0;
+    for (int l = 0; l < CU_LANES; l++) {
+        if ((int32_t) s[l].size() != SETUP_AIE_HEADER_BEATS) {
+            std::cout << "ERROR: shutdown: lane " << l << " has " << s[l].size() << " beats, expected " << SETUP_AIE_HEADER_BEATS << std::endl;
+            errors++;
+            continue;
+        }
+        for (int h = 0; h < SETUP_AIE_HEADER_BEATS; h++) {
+            ap_int<SETUP_AIE_PLIO_WIDTH> header = s[l].read();
+            ap_int<SETUP_AIE_PLIO_WIDTH> expected = 0;
+            if (h == 0)
+                expected.range(31, 0) = JOB_SHUTDOWN;
+            if (header != expected) {
+                std::cout << "ERROR: shutdown: wrong header beat " << h << " on lane " << l << std::endl;
+                errors++;
+            }
+        }
+    }
+    std::cout << "shutdown: " << (errors ? "FAILED" : "passed") << std::endl;
+    return errors;
+}
+
+#if SYSTEM_JOB_DESCRIPTORS
+// job sizes in units of SYSTEM_SIZE_ALIGN elements; empty jobs only send their headers
+static const int32_t test_jobs[] = {3, 0, 17, 1, 64};
+
+// one launch with a table of jobs, each starting one word after the end of the previous one in every slice
+int run_jobs_test() {
+    int errors = 0;
+    const int32_t num_jobs = sizeof(test_jobs) / sizeof(test_jobs[0]);
+    ap_uint<JOB_DESC_WIDTH> jobs[num_jobs];
+    int32_t first_word[num_jobs];
+    int32_t num_words = 0;
+    for (int32_t j = 0; j < num_jobs; j++) {
+        const int32_t slice = test_jobs[j] * SYSTEM_SIZE_ALIGN / SYSTEM_MEM_PORTS;
+        first_word[j] = num_words + 1;
+        num_words = first_word[j] + (slice + ELEMENTS_PER_WORD - 1) / ELEMENTS_PER_WORD;
+        jobs[j] = job_descriptor(first_word[j], test_jobs[j] * SYSTEM_SIZE_ALIGN, 0);
+    }
+    ap_uint<SETUP_AIE_MEM_WIDTH> *input[SYSTEM_MEM_PORTS];
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+        input[p] = new ap_uint<SETUP_AIE_MEM_WIDTH>[num_words];
+        // the words between the jobs must never be read
+        for (int32_t w = 0; w < num_words; w++)
+            input[p][w] = -1;
+    }
+    for (int32_t j = 0; j < num_jobs; j++) {
+        const int32_t slice = test_jobs[j] * SYSTEM_SIZE_ALIGN / SYSTEM_MEM_PORTS;
+        for (int32_t i = 0; i < slice * SYSTEM_MEM_PORTS; i++) {
+            const int32_t lsb = (i % slice % ELEMENTS_PER_WORD) * SETUP_AIE_DATA_BITS;
+            input[i / slice][first_word[j] + i % slice / ELEMENTS_PER_WORD].range(lsb + SETUP_AIE_DATA_BITS - 1, lsb) = (element_t) (i * 3 + j);
+        }
+    }
+
+    hls::stream<ap_int<SETUP_AIE_PLIO_WIDTH>> s[CU_LANES];
+    ap_uint<MOVER_STATS_WIDTH> stats[SYSTEM_MEM_PORTS];
+#if SYSTEM_FREE_RUNNING
+    // the jobs and the stop command fill the ring without wrapping around: the mover must serve them in order,
+    // complete each one and return on the stop
+    const int32_t slots = (num_jobs + RING_LINE) / RING_LINE * RING_LINE;
+    ap_uint<JOB_DESC_WIDTH> ring[RING_ENTRIES(slots)];
+    for (int32_t j = 0; j < num_jobs; j++)
+        post_command(ring, slots, j, jobs[j]);
+    post_command(ring, slots, num_jobs, job_descriptor(0, RING_STOP, 0));
+    setup_aie(slots, MEM_PORT_ARGS(input) MOVER_STATS_ARG(stats) JOB_DESCRIPTORS_ARG(ring), s);
+
+    if ((uint32_t) ring[RING_TAIL].range(31, 0) != (uint32_t) num_jobs + 1) {
+        std::cout << "ERROR: jobs: the tail is " << (uint32_t) ring[RING_TAIL].range(31, 0) << ", expected " << num_jobs + 1 << std::endl;
+        errors++;
+    }
+    for (int32_t j = 0; j <= num_jobs; j++) {
+        const ap_uint<JOB_DESC_WIDTH> record = ring[RING_COMMANDS + slots + j];
+        const uint32_t job = record.range(32 * RING_DONE_JOB + 31, 32 * RING_DONE_JOB);
+        const uint32_t elements = record.range(32 * RING_DONE_SIZE + 31, 32 * RING_DONE_SIZE);
+        if (job != (uint32_t) j || elements != (uint32_t) (j < num_jobs ? test_jobs[j] * SYSTEM_SIZE_ALIGN : 0)) {
+            std::cout << "ERROR: jobs: the completion of job " << j << " is job " << job << " with " << elements << " elements" << std::endl;
+            errors++;
+        }
+    }
+#else
+    setup_aie(num_jobs, MEM_PORT_ARGS(input) MOVER_STATS_ARG(stats) JOB_DESCRIPTORS_ARG(jobs), s);
+#endif
+
+    for (int32_t j = 0; j < num_jobs; j++) {
+        const int32_t size_loop = test_jobs[j] * SYSTEM_SIZE_ALIGN / SYSTEM_MEM_PORTS / SETUP_AIE_ELEMENTS_PER_BEAT;
+        for (int lane = 0; lane < CU_LANES; lane++) {
+            const int p = lane / PORT_LANES, l = lane % PORT_LANES;
+            const int32_t lane_loops = size_loop / PORT_LANES + (l < size_loop % PORT_LANES ? 1 : 0);
+            if ((int32_t) s[lane].size() < lane_loops + SETUP_AIE_HEADER_BEATS) {
+                std::cout << "ERROR: job " << j << ": lane " << lane << " has only " << s[lane].size() << " beats left" << std::endl;
+                errors++;
+                continue;
+            }
+            for (int h = 0; h < SETUP_AIE_HEADER_BEATS; h++) {
+                ap_int<SETUP_AIE_PLIO_WIDTH> header = s[lane].read();
+                ap_int<SETUP_AIE_PLIO_WIDTH> expected = 0;
+                if (h == 0)
+                    expected.range(31, 0) = lane_loops / SETUP_AIE_BEATS_PER_VECTOR;
+                if (header != expected) {
+                    std::cout << "ERROR: job " << j << ": wrong header beat " << h << " on lane " << lane << std::endl;
+                    errors++;
+                }
+            }
+            for (int32_t i = 0; i < lane_loops; i++) {
+                ap_int<SETUP_AIE_PLIO_WIDTH> tmp = s[lane].read();
+                const int32_t b = p * size_loop + i * PORT_LANES + l;
+                for (int k = 0; k < SETUP_AIE_ELEMENTS_PER_BEAT; k++) {
+                    element_t val = tmp.range(SETUP_AIE_DATA_BITS - 1 + k * SETUP_AIE_DATA_BITS, k * SETUP_AIE_DATA_BITS);
+                    if (val != (element_t) ((b * SETUP_AIE_ELEMENTS_PER_BEAT + k) * 3 + j)) {
+                        if (errors < 10)
+                            std::cout << "ERROR: job " << j << ": element " << b * SETUP_AIE_ELEMENTS_PER_BEAT + k << " is " << (int) val << std::endl;
+                        errors++;
+                    }
+                }
+            }
+        }
+    }
+    for (int lane = 0; lane < CU_LANES; lane++) {
+        if (!s[lane].empty()) {
+            std::cout << "ERROR: jobs: lane " << lane << " has " << s[lane].size() << " beats too many" << std::endl;
+            errors++;
+        }
+    }
+
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+        delete[] input[p];
+    std::cout << "jobs: " << num_jobs << " jobs in one launch, " << (errors ? "FAILED" : "passed") << std::endl;
+    return errors;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    int errors = 0;
+    for (int32_t size : test_sizes) {
+        errors += run_test(size);
+    }
+    errors += run_shutdown_test();
+#if SYSTEM_JOB_DESCRIPTORS
+    errors += run_jobs_test();
+#endif
+    if (errors) {
+        std::cout << "Test failed with " << errors << " errors" << std::endl;
+        return 1;
+    }
+    std::cout << "Test passed!" << std::endl;
+    return 0;
+}
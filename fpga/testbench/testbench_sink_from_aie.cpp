@@ -28,42 +28,125 @@ SOFTWARE.
 #include <ap_axi_sdata.h>
 #include "../sink_from_aie.hpp"
 #include <cmath>
+#include <string>
+#include <sstream>
 
+// the movers only move bits: the testbench packs integer patterns as wide as data_t (the same for float and bfloat16)
+typedef ap_int<SINK_FROM_AIE_DATA_BITS> element_t;
 
-int main(int argc, char *argv[]) { 
+
+int main() {
     // This testbech will test the sink_from_aie kernel
     // The kernel will receive a stream of data from the AIE
     // and will write it into memory
 
-    // I will create a stream of data
-    hls::stream<int32_t> s;
-    int size = 32;
-    // I create the buffer to write into memory
-    int *buffer = new int[size];
+    // I will create a stream of data for each lane: each beat of the AIE output PLIOs carries
+    // SINK_FROM_AIE_ELEMENTS_PER_BEAT elements (4 with 128-bit PLIOs)
+    hls::stream<ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0>> s[CU_PLIOS];
+    // with SYSTEM_PACKET_SWITCHING the job of the simulation gives one buffer to every lane
+    int size = SYSTEM_PACKET_SWITCHING ? SYSTEM_SIZE_ALIGN : 32;
+    // I create the buffer to write into memory: the kernel writes 512-bit words of 512 / SINK_FROM_AIE_DATA_BITS
+    // elements each (16 int32_t, 32 int16_t or 64 int8_t), one buffer for each of the SYSTEM_MEM_PORTS slices
+    const int elements_per_word = SINK_FROM_AIE_MEM_WIDTH / SINK_FROM_AIE_DATA_BITS;
+    const int slice = size / SYSTEM_MEM_PORTS;
+    ap_uint<SINK_FROM_AIE_MEM_WIDTH> *buffer[SYSTEM_MEM_PORTS];
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+        buffer[p] = new ap_uint<SINK_FROM_AIE_MEM_WIDTH>[(slice + elements_per_word - 1) / elements_per_word];
 
-    // I have to read the output of AI Engine from the file. 
-    // Otherwise, I have no input for my testbench
-    std::ifstream file;
-    file.open("../../aie/x86simulator_output/data/out_plio_sink_1.txt");
-    if (!file) {
-        std::cerr << "Unable to open file ../../aie/x86simulator_output/data/out_plio_sink_1.txt - as this file is source data, adjust your files in the build directory" << std::endl;
-        return 1;
+#if SYSTEM_PACKET_SWITCHING
+    // With SYSTEM_PACKET_SWITCHING there is one file for each memory port (out_plio_<p+1>), holding the packets of
+    // its lanes as the pktmerge sent them: one beat of 32-bit words per line, TLAST before the last beat of every
+    // packet (see fpga/packet_header.hpp)
+    for (int p = 0; p < CU_PLIOS; p++) {
+        std::string file_name = "../../aie/x86simulator_output/data/out_plio_sink_" + std::to_string(p + 1) + ".txt";
+        std::ifstream file(file_name);
+        if (!file) {
+            std::cerr << "Unable to open file " << file_name << " - as this file is source data, adjust your files in the build directory" << std::endl;
+            return 1;
+        }
+        std::string line;
+        bool last = false;
+        while (std::getline(file, line)) {
+            if (line.find("TLAST") != std::string::npos) {
+                last = true;
+                continue;
+            }
+            std::istringstream words(line);
+            ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0> beat;
+            beat.data = 0;
+            int x, j = 0;
+            for (; j < SINK_FROM_AIE_PLIO_WIDTH / 32 && words >> x; j++)
+                beat.data.range(32 * j + 31, 32 * j) = x;
+            if (j == 0)
+                continue;
+            beat.last = last;
+            last = false;
+            s[p].write(beat);
+        }
     }
+#else
+    // I have to read the output of AI Engine from the files, one for each lane (out_plio_<l+1>). 
+    // Otherwise, I have no input for my testbench
+    for (int l = 0; l < CU_LANES; l++) {
+        std::string file_name = "../../aie/x86simulator_output/data/out_plio_sink_" + std::to_string(l + 1) + ".txt";
+        std::ifstream file;
+        file.open(file_name);
+        if (!file) {
+            std::cerr << "Unable to open file " << file_name << " - as this file is source data, adjust your files in the build directory" << std::endl;
+            return 1;
+        }
 
-    for (int i = 0; i < size; i++) {
-        int x;
-        file >> x;
-        s.write(x);
+        // the simulator writes one PLIO beat per line, i.e. SINK_FROM_AIE_ELEMENTS_PER_BEAT elements.
+        // Lane l produced beats l, l + CU_LANES, l + 2*CU_LANES, ... (of the slice of its port, with PORT_LANES
+        // lanes per port)
+        const int num_beats = slice / SINK_FROM_AIE_ELEMENTS_PER_BEAT;
+        int lane_beats = num_beats / PORT_LANES + (l % PORT_LANES < num_beats % PORT_LANES ? 1 : 0);
+        for (int i = 0; i < lane_beats; i++) {
+            ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0> beat;
+            for (unsigned int j = 0; j < SINK_FROM_AIE_ELEMENTS_PER_BEAT; j++) {
+                int x;
+                file >> x;
+                beat.data.range(SINK_FROM_AIE_DATA_BITS - 1 + j * SINK_FROM_AIE_DATA_BITS, j * SINK_FROM_AIE_DATA_BITS) = (element_t) x;
+            }
+            beat.last = 0;
+            s[l].write(beat);
+        }
+#if SYSTEM_FRAMED_OUTPUT
+        // every lane closes its frame with a trailer beat carrying TLAST, which the kernel does not write
+        ap_axiu<SINK_FROM_AIE_PLIO_WIDTH, 0, 0, 0> trailer;
+        trailer.data = 0;
+        trailer.last = 1;
+        s[l].write(trailer);
+#endif
     }
+#endif
 
-    sink_from_aie(s,buffer,size);
+#if SYSTEM_MOVER_STATS
+    // performance counters of the ports
+    ap_uint<MOVER_STATS_WIDTH> stats[SYSTEM_MEM_PORTS];
+#endif
+#if SYSTEM_FRAMED_OUTPUT
+    // elements written by the ports
+    ap_uint<64> produced[SYSTEM_MEM_PORTS];
+#endif
+    // with SYSTEM_JOB_DESCRIPTORS the run is a table of one job, at the start of every slice (with
+    // SYSTEM_FREE_RUNNING a command ring with that job)
+    ap_uint<JOB_DESC_WIDTH> jobs[RING_ENTRIES(RING_LINE)];
+    sink_from_aie(s,MEM_PORT_ARGS(buffer),single_job(jobs, size) MOVER_STATS_ARG(stats) SINK_FROM_AIE_PRODUCED_ARG(produced) JOB_DESCRIPTORS_ARG(jobs));
+#if SYSTEM_FRAMED_OUTPUT
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+        std::cerr << "port " << p << " produced " << produced[p] << " of " << slice << " elements" << std::endl;
+#endif
 
     // if the kernel is correct, it will contains the expected data.
     // I can print them, for example, to check that they are equal to the output of AIE
-    for (unsigned int i = 0; i < size; i++) {
-        std::cout << buffer[i] << std::endl;
+    for (int i = 0; i < size; i++) {
+        const int lsb = (i % slice % elements_per_word) * SINK_FROM_AIE_DATA_BITS;
+        int val = (element_t) buffer[i / slice][i % slice / elements_per_word].range(lsb + SINK_FROM_AIE_DATA_BITS - 1, lsb);
+        std::cout << val << std::endl;
     }
-    delete[] buffer;
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+        delete[] buffer[p];
 
     // Note that: you may also have a code that runs the AI Engine from your kernel, and so a testbench
     // that simulates the entire application flow. It is useful, but still I would suggest to use single kernel testbench too.
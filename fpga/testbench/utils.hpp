@@ -24,6 +24,16 @@ SOFTWARE.
 
 #include <iostream>
 #include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <hls_stream.h>
 #include <ap_axi_sdata.h>
 
@@ -182,3 +192,308 @@ bool assert_stream_size(hls::stream<T>& stream, const int expected_size) {
     }
     return true;
 }
+
+// ---------------------------------------------------------------------------------------------------------------
+// Binary PLIO traces
+//
+// The AIE simulators read and write text files with one PLIO beat per line, its elements separated by spaces, and
+// the functions above convert every element through iostream, which dominates testbenches with millions of
+// samples. A binary trace holds the same beats as raw bits: a plio_trace_header, then beats * beat_bits / 8 bytes,
+// each beat little-endian with element 0 in its low bits (as in ap_int::range). Traces are read and written
+// through mmap, so loading a stream costs one bulk copy per beat. aie_text_to_trace() and trace_to_aie_text()
+// convert from and to the simulator format (make plio_convert builds them as a command line tool).
+
+#define PLIO_TRACE_MAGIC "PLIOTRC1"
+
+// how the elements of a trace are printed in the text format
+enum plio_trace_format { PLIO_TRACE_INT = 0, PLIO_TRACE_UINT = 1, PLIO_TRACE_FLOAT = 2 };
+
+struct plio_trace_header {
+    char magic[8];          // PLIO_TRACE_MAGIC, without the terminator
+    uint32_t beat_bits;     // width of the PLIO, a multiple of 8
+    uint32_t element_bits;  // 8, 16, 32 or 64, a divisor of beat_bits (16-bit floats are bfloat16)
+    uint32_t format;        // plio_trace_format
+    uint32_t reserved;
+    uint64_t beats;
+};
+static_assert(sizeof(plio_trace_header) == 32, "the beats of a trace start 32 bytes into the file");
+
+inline void plio_trace_error(const std::string& message) {
+    std::cout << "ERROR: " << message << std::endl;
+    throw std::exception();
+}
+
+// A file mapped in memory: read-only when opened, read-write when created with a size
+class mapped_file {
+public:
+    explicit mapped_file(const std::string& path) {
+        fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0)
+            fail("could not open file " + path);
+        map(path, st.st_size, PROT_READ);
+    }
+
+    mapped_file(const std::string& path, size_t size) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate(fd, size) != 0)
+            fail("could not create file " + path);
+        map(path, size, PROT_READ | PROT_WRITE);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() {
+        if (bytes) munmap(bytes, length);
+        if (fd >= 0) close(fd);
+    }
+
+    uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    // the destructor does not run when a constructor throws, so the file is closed here
+    void fail(const std::string& message) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+        plio_trace_error(message);
+    }
+
+    void map(const std::string& path, size_t size, int protection) {
+        length = size;
+        if (size == 0) return;
+        void* p = mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+            fail("could not map file " + path);
+        bytes = static_cast<uint8_t*>(p);
+        // the beats are read once, front to back
+        madvise(p, size, MADV_SEQUENTIAL);
+    }
+
+    int fd = -1;
+    uint8_t* bytes = nullptr;
+    size_t length = 0;
+};
+
+// Bulk copy of the bits of a beat from / to its little-endian bytes, 64 bits at a time
+template <typename T>
+void bits_from_bytes(T& bits, const uint8_t* bytes, int width) {
+    for (int lo = 0; lo < width; lo += 64) {
+        const int n = width - lo < 64 ? width - lo : 64;
+        uint64_t v = 0;
+        std::memcpy(&v, bytes + lo / 8, n / 8);
+        bits.range(lo + n - 1, lo) = (unsigned long long) v;
+    }
+}
+
+template <typename T>
+void bits_to_bytes(const T& bits, uint8_t* bytes, int width) {
+    for (int lo = 0; lo < width; lo += 64) {
+        const int n = width - lo < 64 ? width - lo : 64;
+        const uint64_t v = bits.range(lo + n - 1, lo).to_uint64();
+        std::memcpy(bytes + lo / 8, &v, n / 8);
+    }
+}
+
+// Beat types of the testbench streams: the PLIO width of each and how it unpacks from / packs to a trace beat
+template <int W> int beat_width(const ap_int<W>&) { return W; }
+template <int W> int beat_width(const ap_uint<W>&) { return W; }
+template <int W, int U, int I, int D> int beat_width(const ap_axis<W, U, I, D>&) { return W; }
+template <int W, int U, int I, int D> int beat_width(const ap_axiu<W, U, I, D>&) { return W; }
+
+template <int W> void unpack_beat(ap_int<W>& beat, const uint8_t* bytes, bool last) { bits_from_bytes(beat, bytes, W); }
+template <int W> void unpack_beat(ap_uint<W>& beat, const uint8_t* bytes, bool last) { bits_from_bytes(beat, bytes, W); }
+template <int W, int U, int I, int D>
+void unpack_beat(ap_axis<W, U, I, D>& beat, const uint8_t* bytes, bool last) {
+    bits_from_bytes(beat.data, bytes, W);
+    beat.keep = -1;
+    beat.last = last;
+}
+template <int W, int U, int I, int D>
+void unpack_beat(ap_axiu<W, U, I, D>& beat, const uint8_t* bytes, bool last) {
+    bits_from_bytes(beat.data, bytes, W);
+    beat.keep = -1;
+    beat.last = last;
+}
+
+template <int W> void pack_beat(const ap_int<W>& beat, uint8_t* bytes) { bits_to_bytes(beat, bytes, W); }
+template <int W> void pack_beat(const ap_uint<W>& beat, uint8_t* bytes) { bits_to_bytes(beat, bytes, W); }
+template <int W, int U, int I, int D>
+void pack_beat(const ap_axis<W, U, I, D>& beat, uint8_t* bytes) { bits_to_bytes(beat.data, bytes, W); }
+template <int W, int U, int I, int D>
+void pack_beat(const ap_axiu<W, U, I, D>& beat, uint8_t* bytes) { bits_to_bytes(beat.data, bytes, W); }
+
+// Read-only view of a binary trace
+class plio_trace_reader {
+public:
+    explicit plio_trace_reader(const std::string& path) : file(path) {
+        if (file.size() < sizeof(plio_trace_header))
+            plio_trace_error(path + " is not a PLIO trace");
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, PLIO_TRACE_MAGIC, sizeof(header.magic)) != 0)
+            plio_trace_error(path + " is not a PLIO trace");
+        if (file.size() < sizeof(header) + header.beats * beat_bytes())
+            plio_trace_error(path + " is truncated");
+    }
+
+    uint64_t beats() const { return header.beats; }
+    int beat_bits() const { return header.beat_bits; }
+    int element_bits() const { return header.element_bits; }
+    plio_trace_format format() const { return (plio_trace_format) header.format; }
+    size_t beat_bytes() const { return header.beat_bits / 8; }
+    const uint8_t* beat(uint64_t i) const { return file.data() + sizeof(header) + i * beat_bytes(); }
+
+private:
+    mapped_file file;
+    plio_trace_header header;
+};
+
+// Binary trace of a known number of beats, created (or overwritten) at construction
+class plio_trace_writer {
+public:
+    plio_trace_writer(const std::string& path, uint64_t beats, int beat_bits, int element_bits, plio_trace_format format = PLIO_TRACE_INT)
+        : file(path, file_size(beats, beat_bits, element_bits)) {
+        plio_trace_header header = {};
+        std::memcpy(header.magic, PLIO_TRACE_MAGIC, sizeof(header.magic));
+        header.beat_bits = beat_bits;
+        header.element_bits = element_bits;
+        header.format = format;
+        header.beats = beats;
+        std::memcpy(file.data(), &header, sizeof(header));
+        bytes = beat_bits / 8;
+    }
+
+    uint8_t* beat(uint64_t i) { return file.data() + sizeof(plio_trace_header) + i * bytes; }
+
+private:
+    // checked before the file is created, so an invalid trace leaves no file behind
+    static size_t file_size(uint64_t beats, int beat_bits, int element_bits) {
+        if (beat_bits <= 0 || element_bits <= 0 || beat_bits % 8 != 0 || element_bits % 8 != 0 || element_bits > 64 || beat_bits % element_bits != 0)
+            plio_trace_error("invalid PLIO trace of " + std::to_string(beat_bits) + "-bit beats and " + std::to_string(element_bits) + "-bit elements");
+        return sizeof(plio_trace_header) + beats * (beat_bits / 8);
+    }
+
+    mapped_file file;
+    size_t bytes;
+};
+
+// Binary counterparts of read_stream_from_file() and write_stream_to_file(): the beats of the trace must be as
+// wide as those of the stream
+template <typename T>
+unsigned read_stream_from_trace(hls::stream<T>& stream_out, const std::string& file_path) {
+    plio_trace_reader trace(file_path);
+    T beat;
+    if (trace.beat_bits() != beat_width(beat))
+        plio_trace_error(file_path + " holds " + std::to_string(trace.beat_bits()) + "-bit beats, the stream " + std::to_string(beat_width(beat)) + "-bit ones");
+    for (uint64_t i = 0; i < trace.beats(); i++) {
+        unpack_beat(beat, trace.beat(i), i == trace.beats() - 1);
+        stream_out.write(beat);
+    }
+    std::cout << "# Read " << trace.beats() << " beats from trace " << file_path << std::endl;
+    return trace.beats();
+}
+
+// element_bits and format only matter for the conversion to text
+template <typename T>
+unsigned write_stream_to_trace(hls::stream<T>& stream_out, const std::string& file_path, int element_bits, plio_trace_format format = PLIO_TRACE_INT) {
+    const uint64_t beats = stream_out.size();
+    T beat;
+    plio_trace_writer trace(file_path, beats, beat_width(beat), element_bits, format);
+    for (uint64_t i = 0; i < beats; i++)
+        pack_beat(stream_out.read(), trace.beat(i));
+    std::cout << "# Wrote " << beats << " beats to trace " << file_path << std::endl;
+    return beats;
+}
+
+// Converts a simulator text file (one beat per line, the elements separated by spaces) to a binary trace. The
+// lines that do not start with a number, e.g. the TLAST markers and timestamps of aiesimulator, are skipped.
+// 16-bit floats are stored as bfloat16, rounded to nearest even. Returns the number of beats
+inline uint64_t aie_text_to_trace(const std::string& text_path, const std::string& trace_path, int beat_bits, int element_bits,
+                                  plio_trace_format format = PLIO_TRACE_INT) {
+    if (format == PLIO_TRACE_FLOAT && element_bits != 16 && element_bits != 32)
+        plio_trace_error("float traces have 16-bit (bfloat16) or 32-bit elements");
+    mapped_file text(text_path);
+    const char* p = reinterpret_cast<const char*>(text.data());
+    const char* const end = p + text.size();
+    const size_t element_bytes = element_bits / 8;
+    std::vector<uint8_t> elements;
+    elements.reserve(text.size() / 2);
+    // strtoll and strtof stop at the end of the mapping only on a non-number, so parse one line at a time
+    std::string line;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        line.assign(p, eol);
+        p = eol + 1;
+        const char* c = line.c_str();
+        while (*c == ' ' || *c == '\t') c++;
+        if (!(*c == '-' || *c == '+' || *c == '.' || (*c >= '0' && *c <= '9'))) continue;
+        while (*c) {
+            char* next;
+            uint64_t bits;
+            if (format == PLIO_TRACE_FLOAT) {
+                const float f = std::strtof(c, &next);
+                uint32_t u;
+                std::memcpy(&u, &f, sizeof(u));
+                bits = element_bits == 16 ? (u + 0x7fff + ((u >> 16) & 1)) >> 16 : u;
+            } else if (format == PLIO_TRACE_UINT) {
+                bits = std::strtoull(c, &next, 10);
+            } else {
+                bits = (uint64_t) std::strtoll(c, &next, 10);
+            }
+            if (next == c) break;
+            const size_t at = elements.size();
+            elements.resize(at + element_bytes);
+            std::memcpy(&elements[at], &bits, element_bytes);
+            c = next;
+        }
+    }
+    const size_t beat_bytes = beat_bits / 8;
+    if (elements.size() % beat_bytes != 0)
+        plio_trace_error(text_path + " does not hold a whole number of " + std::to_string(beat_bits) + "-bit beats");
+    const uint64_t beats = elements.size() / beat_bytes;
+    plio_trace_writer trace(trace_path, beats, beat_bits, element_bits, format);
+    if (beats) std::memcpy(trace.beat(0), elements.data(), elements.size());
+    std::cout << "# Converted " << beats << " beats from " << text_path << " to trace " << trace_path << std::endl;
+    return beats;
+}
+
+// Converts a binary trace to the simulator text format, one beat per line. Returns the number of beats
+inline uint64_t trace_to_aie_text(const std::string& trace_path, const std::string& text_path) {
+    plio_trace_reader trace(trace_path);
+    FILE* file = std::fopen(text_path.c_str(), "w");
+    if (!file)
+        plio_trace_error("could not open file " + text_path);
+    const int element_bits = trace.element_bits();
+    const int per_beat = trace.beat_bits() / element_bits;
+    std::vector<char> line(per_beat * 32 + 2);
+    for (uint64_t i = 0; i < trace.beats(); i++) {
+        const uint8_t* beat = trace.beat(i);
+        size_t n = 0;
+        for (int e = 0; e < per_beat; e++) {
+            uint64_t bits = 0;
+            std::memcpy(&bits, beat + e * element_bits / 8, element_bits / 8);
+            char* out = line.data() + n;
+            int written;
+            if (trace.format() == PLIO_TRACE_FLOAT) {
+                uint32_t u = element_bits == 16 ? (uint32_t) bits << 16 : (uint32_t) bits;
+                float f;
+                std::memcpy(&f, &u, sizeof(f));
+                written = std::snprintf(out, 32, "%.9g", f);
+            } else if (trace.format() == PLIO_TRACE_UINT) {
+                written = std::snprintf(out, 32, "%llu", (unsigned long long) bits);
+            } else {
+                // sign-extend the element
+                const int64_t v = element_bits == 64 ? (int64_t) bits : (int64_t) (bits << (64 - element_bits)) >> (64 - element_bits);
+                written = std::snprintf(out, 32, "%lld", (long long) v);
+            }
+            n += written;
+            line[n++] = e == per_beat - 1 ? '\n' : ' ';
+        }
+        std::fwrite(line.data(), 1, n, file);
+    }
+    std::fclose(file);
+    std::cout << "# Converted " << trace.beats() << " beats from trace " << trace_path << " to " << text_path << std::endl;
+    return trace.beats();
+}
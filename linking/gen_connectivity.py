@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+# Generates xclbin_overlay.cfg with one stream_connect pair for each lane (for each memory port with packet switching)
+# and one sp line for each m_axi port of every compute unit.
+# The shape of the system (lanes, PLIO widths, memory banks) is read from ../common/system_config.h, written
+# by aie/src/template_generator/gen_template.py, so the linker configuration always matches aie/src/graph.h
+# and the PL movers. gen_template.py also calls build_cfg() directly when it generates the system.
+
+import os, re, sys
+
+license_header = """# MIT License
+
+# Copyright (c) 2023 Paolo Salvatore Galfano, Giuseppe Sorrentino
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+"""
+
+
+def build_cfg(lanes, plio_in_width, plio_out_width, input_banks, output_banks, stats=False, framed=False, descriptors=False,
+              compute_units=1, packet_switching=False):
+    """Return the content of xclbin_overlay.cfg for the given system.
+
+    input_banks and output_banks list the bank of each m_axi port of setup_aie (gmem0, gmem1, ...) and of
+    sink_from_aie (gmem1, gmem2, ...): port p moves the slice p of the buffer. With stats each mover also has
+    the m_axi port of its stats buffer, in the bank of its first port. With framed sink_from_aie also has the
+    m_axi port of its produced counts, in the bank of its first port. With descriptors both movers also have the
+    m_axi port of their job table, in the bank of their first port. With compute_units > 1 the kernels are
+    replicated (setup_aie_<c>, sink_from_aie_<c>): the banks are listed unit by unit, and unit c streams to lanes
+    c * lanes / compute_units and following. With packet_switching the lanes of each port share one pair of
+    PLIOs, so every unit has one stream per memory port instead of one per lane.
+    """
+    mem_ports = len(input_banks) // compute_units
+    cu_lanes = lanes // compute_units
+    cu_plios = mem_ports if packet_switching else cu_lanes
+    setup_cus = '.'.join(f'setup_aie_{c}' for c in range(compute_units))
+    sink_cus = '.'.join(f'sink_from_aie_{c}' for c in range(compute_units))
+    lines = [
+        license_header,
+        f'# Generated for NUM_LANES = {lanes}, do not edit by hand: change the [system] section of',
+        '# aie/src/template_generator/kernel.cfg and run gen_template.py, or run make connectivity',
+        '',
+        '[connectivity]',
+        f'nk = setup_aie:{compute_units}:{setup_cus}',
+        f'nk = sink_from_aie:{compute_units}:{sink_cus}',
+        '',
+    ]
+    for c in range(compute_units):
+        lines.append(f'slr = setup_aie_{c}:SLR0')
+        lines.append(f'slr = sink_from_aie_{c}:SLR0')
+    lines.append('')
+    if mem_ports > 1:
+        lines.append(f'# the buffers are striped over {mem_ports} m_axi ports per mover, one per memory bank')
+    for c in range(compute_units):
+        if compute_units > 1:
+            lines.append(f'# compute unit {c}')
+        cu_in, cu_out = input_banks[c * mem_ports:(c + 1) * mem_ports], output_banks[c * mem_ports:(c + 1) * mem_ports]
+        lines += [f'sp = sink_from_aie_{c}.m_axi_gmem{p + 1}:{bank}' for p, bank in enumerate(cu_out)]
+        lines += [f'sp = setup_aie_{c}.m_axi_gmem{p}:{bank}' for p, bank in enumerate(cu_in)]
+        if stats:
+            lines.append('# performance counters of the movers (SYSTEM_MOVER_STATS)')
+            lines.append(f'sp = sink_from_aie_{c}.m_axi_stats:{cu_out[0]}')
+            lines.append(f'sp = setup_aie_{c}.m_axi_stats:{cu_in[0]}')
+        if framed:
+            lines.append('# elements written by each port of sink_from_aie (SYSTEM_FRAMED_OUTPUT)')
+            lines.append(f'sp = sink_from_aie_{c}.m_axi_produced:{cu_out[0]}')
+        if descriptors:
+            lines.append('# job tables of the movers (SYSTEM_JOB_DESCRIPTORS)')
+            lines.append(f'sp = sink_from_aie_{c}.m_axi_jobs:{cu_out[0]}')
+            lines.append(f'sp = setup_aie_{c}.m_axi_jobs:{cu_in[0]}')
+    lines += [
+        '',
+        f'# the input PLIOs are plio_{plio_in_width}_bits and the output ones plio_{plio_out_width}_bits (see aie/src/graph.h),',
+        '# the same widths of the PL streams',
+    ]
+    if packet_switching:
+        lines.append(f'# packet switching: the {cu_lanes // mem_ports} lanes of each memory port share its pair of PLIOs')
+    for l in range(cu_plios * compute_units):
+        c, s = l // cu_plios, l % cu_plios
+        lines.append(f'stream_connect = setup_aie_{c}.s_{s}:ai_engine_0.in_plio_{l + 1}')
+        lines.append(f'stream_connect = ai_engine_0.out_plio_{l + 1}:sink_from_aie_{c}.input_stream_{s}')
+    lines += [
+        '',
+        '[vivado]',
+        '# use following line to improve the hw_emu running speed affected by platform',
+        'prop=fileset.sim_1.xsim.elaborate.xelab.more_options={-override_timeprecision -timescale=1ns/1ps}',
+        '',
+    ]
+    return '\n'.join(lines)
+
+
+def read_system_config(path):
+    """Return (lanes, plio_in_width, plio_out_width, input_banks, output_banks, stats, framed, descriptors,
+    compute_units, packet_switching) from system_config.h."""
+    with open(path) as f:
+        text = f.read()
+    def define(name, default=None):
+        m = re.search(rf'^\s*#define\s+{name}\s+"?([\w,]+)"?', text, re.MULTILINE)
+        if not m and default is not None:
+            return default
+        if not m:
+            print(f"ERROR: {name} not found in {path}", file=sys.stderr)
+            sys.exit(1)
+        return m.group(1)
+    lanes = int(define('NUM_LANES'))
+    if lanes < 1 or lanes & (lanes - 1):
+        print("ERROR: NUM_LANES must be a power of two", file=sys.stderr)
+        sys.exit(1)
+    return (lanes, int(define('SYSTEM_PLIO_IN_WIDTH')), int(define('SYSTEM_PLIO_OUT_WIDTH')),
+            define('SYSTEM_INPUT_BANKS').split(','), define('SYSTEM_OUTPUT_BANKS').split(','),
+            define('SYSTEM_MOVER_STATS', '0') == '1', define('SYSTEM_FRAMED_OUTPUT', '0') == '1',
+            define('SYSTEM_JOB_DESCRIPTORS', '0') == '1', int(define('SYSTEM_COMPUTE_UNITS', '1')),
+            define('SYSTEM_PACKET_SWITCHING', '0') == '1')
+
+
+if __name__ == '__main__':
+    here    = os.path.dirname(os.path.abspath(__file__))
+    system  = os.path.join(here, '..', 'common', 'system_config.h')
+    out_cfg = os.path.join(here, 'xclbin_overlay.cfg')
+
+    params = read_system_config(system)
+    with open(out_cfg, 'w') as f:
+        f.write(build_cfg(*params))
+
+    print(f"Generated {out_cfg} for {params[0]} lane(s)")
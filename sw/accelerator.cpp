@@ -0,0 +1,367 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "accelerator.hpp"
+#include "host_utils.hpp"
+#include "../common/common.h"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+namespace voted {
+
+// the load of the xclbin, as a span of the trace (the constructor loads it in its initializer list)
+static xrt::uuid load_xclbin(xrt::device& device, const std::string& xclbin_file) {
+    trace_span span("load xclbin", -1, "xrt");
+    return device.load_xclbin(xclbin_file);
+}
+
+accelerator::accelerator(const std::string& xclbin_file, int device_id, accelerator_config config)
+    : config(config),
+      device(device_id),
+      xclbin_uuid(load_xclbin(device, xclbin_file)),
+      krnl_setup_aie(device, xclbin_uuid, compute_unit("setup_aie", 0)),
+      krnl_sink_from_aie(device, xclbin_uuid, compute_unit("sink_from_aie", 0)),
+      banks_input(port_banks(krnl_setup_aie, arg_setup_aie_input)),
+      banks_output(port_banks(krnl_sink_from_aie, arg_sink_from_aie_output)),
+      graph(device, xclbin_uuid),
+      pool(device),
+      ring(device, krnl_setup_aie, krnl_sink_from_aie, (size_t) std::max(config.inflight_batches, 1) * config.max_batch_requests)
+{
+    if (this->config.inflight_batches < 1) this->config.inflight_batches = 1;
+    // a framed sink reports what each port produced for the whole run, not per request
+    if (SYSTEM_FRAMED_OUTPUT) this->config.max_batch_requests = 1;
+    const size_t slice_bytes = padded_bytes(striped_buffer::slice_size(config.max_batch_elements));
+    trace_span alloc_span("allocate buffers", -1, "xrt");
+    for (int p = 0; p < SYSTEM_MEM_PORTS && !SYSTEM_FREE_RUNNING; p++) {
+        pool.reserve(slice_bytes, banks_input[p], this->config.inflight_batches);
+        pool.reserve(slice_bytes, banks_output[p], this->config.inflight_batches);
+    }
+    for (int i = 0; i < this->config.inflight_batches; i++) {
+        runs.emplace_back(xrt::run(krnl_setup_aie), xrt::run(krnl_sink_from_aie));
+        // with SYSTEM_MOVER_STATS every run needs its stats buffer, the counters are not read back here
+        stats_buffers.emplace_back(mover_stats_buffer(device, krnl_setup_aie, arg_setup_aie_stats),
+                                   mover_stats_buffer(device, krnl_sink_from_aie, arg_sink_from_aie_stats));
+        stats_buffers.back().first.set_arg(runs.back().first);
+        stats_buffers.back().second.set_arg(runs.back().second);
+        produced_buffers.emplace_back(device, krnl_sink_from_aie, arg_sink_from_aie_produced);
+        produced_buffers.back().set_arg(runs.back().second);
+        job_tables.emplace_back(device, krnl_setup_aie, krnl_sink_from_aie, this->config.max_batch_requests);
+    }
+    if (SYSTEM_FREE_RUNNING) {
+        // every request of a batch starts on a whole word, which costs at most one word each
+        region_words = slice_bytes / 64 + this->config.max_batch_requests;
+        const size_t capacity = region_words * this->config.inflight_batches * 64 / sizeof(data_t) * SYSTEM_MEM_PORTS;
+        shared_in  = striped_buffer(pool, capacity, banks_input);
+        shared_out = striped_buffer(pool, capacity, banks_output);
+        xrt::run run_setup(krnl_setup_aie), run_sink(krnl_sink_from_aie);
+        shared_in.set_args(run_setup, arg_setup_aie_input);
+        shared_out.set_args(run_sink, arg_sink_from_aie_output);
+        ring.start(run_setup, run_sink);
+    }
+    alloc_span.end();
+    dispatcher = std::thread(&accelerator::dispatcher_loop, this);
+    completer  = std::thread(&accelerator::completion_loop, this);
+}
+
+accelerator::~accelerator() {
+    stopping.store(true);
+    {
+        std::lock_guard<std::mutex> guard(submit_mutex);
+        submit_cv.notify_one();
+    }
+    dispatcher.join();
+    completer.join();
+    ring.stop();
+}
+
+std::future<result> accelerator::submit(span<const data_t> input) {
+    request* r = new request();
+    r->id = submitted_requests++;
+    tracer::get().async_begin("request", "host", r->id);
+    r->input.assign(input.begin(), input.end());
+    std::future<result> future = r->promise.get_future();
+    submitted.push(r);
+    if (dispatcher_sleeping.load()) {
+        std::lock_guard<std::mutex> guard(submit_mutex);
+        submit_cv.notify_one();
+    }
+    return future;
+}
+
+// Each request starts on a multiple of SYSTEM_SIZE_ALIGN elements (one 128-bit beat with the default system), so
+// the compute never mixes two requests in one vector and the batch always has a size the movers accept
+static size_t beat_aligned(size_t elements) {
+    return (elements + SYSTEM_SIZE_ALIGN - 1) / SYSTEM_SIZE_ALIGN * SYSTEM_SIZE_ALIGN;
+}
+
+// Pops requests until the batch is full or the timeout expires. Returns the number of elements in the batch
+size_t accelerator::collect(std::vector<request*>& requests) {
+    size_t elements = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(config.batch_timeout_us);
+    request* r;
+    if (held) {
+        requests.push_back(held);
+        elements += beat_aligned(held->input.size());
+        held = nullptr;
+    }
+    while (requests.size() < config.max_batch_requests && elements < config.max_batch_elements) {
+        if (submitted.pop(r)) {
+            // the free-running movers have a fixed region per batch: a request that would overflow it opens the next one
+            if (SYSTEM_FREE_RUNNING && !requests.empty() && elements + beat_aligned(r->input.size()) > config.max_batch_elements) {
+                held = r;
+                break;
+            }
+            requests.push_back(r);
+            elements += beat_aligned(r->input.size());
+            if (elements >= config.max_batch_elements) break;
+        } else if (!requests.empty() && std::chrono::steady_clock::now() >= deadline) {
+            break;
+        } else if (requests.empty()) {
+            if (stopping.load() && submitted.empty()) break;
+            // nothing to do: park until a producer signals, with a timeout against missed wake-ups
+            std::unique_lock<std::mutex> lock(submit_mutex);
+            dispatcher_sleeping.store(true);
+            if (submitted.empty() && !stopping.load())
+                submit_cv.wait_for(lock, std::chrono::milliseconds(1));
+            dispatcher_sleeping.store(false);
+            deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(config.batch_timeout_us);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    return elements;
+}
+
+void accelerator::launch(batch* b) {
+    b->id = launched;
+    tracer::get().async_begin("batch", "host", b->id);
+    // batches complete in order, so the run pair of the oldest in-flight batch is always the one to reuse
+    const size_t slot = launched % runs.size();
+    // with job descriptors every request is a job of the run: the kernels get a header for each request, and the
+    // slices of the requests start on whole words, which the batch pays in padding
+    size_t run_elements = b->elements;
+    if (SYSTEM_JOB_DESCRIPTORS) {
+        b->jobs = &job_tables[slot];
+        b->jobs->clear(SYSTEM_FREE_RUNNING ? slot * region_words : 0);
+        for (request* r : b->requests)
+            b->jobs->add(beat_aligned(r->input.size()));
+        run_elements = b->jobs->capacity();
+    }
+    if (SYSTEM_FREE_RUNNING) {
+        // the buffers of the movers are fixed, a request bigger than a batch has nowhere to go
+        if (run_elements > (slot + 1) * region_words * 64 / sizeof(data_t) * SYSTEM_MEM_PORTS)
+            throw std::runtime_error("accelerator: a batch of " + std::to_string(b->elements) +
+                                     " elements does not fit the free-running buffers, raise max_batch_elements");
+    } else {
+        // a request bigger than a batch gets a larger buffer from the pool
+        trace_span span("acquire buffers", b->id, "xrt");
+        const size_t capacity = std::max(run_elements, config.max_batch_elements);
+        b->buf_in  = striped_buffer(pool, capacity, banks_input);
+        b->buf_out = striped_buffer(pool, capacity, banks_output);
+    }
+
+    {
+        // with several memory ports a request can span two slices, striped_buffer (or the job table) splits the copy
+        trace_span span("copy requests in", b->id);
+        for (size_t i = 0; i < b->requests.size(); i++) {
+            const std::vector<data_t>& input = b->requests[i]->input;
+            if (SYSTEM_JOB_DESCRIPTORS) {
+                b->jobs->write(SYSTEM_FREE_RUNNING ? shared_in : b->buf_in, i, input.data(), input.size());
+            } else {
+                b->buf_in.write(b->elements, b->offsets[i], input.data(), input.size());
+                b->buf_in.clear(b->elements, b->offsets[i] + input.size(), beat_aligned(input.size()) - input.size());
+            }
+        }
+    }
+    {
+        trace_span span("sync to device", b->id, "xrt");
+        if (SYSTEM_FREE_RUNNING)
+            b->jobs->sync(shared_in, XCL_BO_SYNC_BO_TO_DEVICE);
+        else
+            b->buf_in.sync(XCL_BO_SYNC_BO_TO_DEVICE, run_elements);
+    }
+
+    b->run_setup = runs[slot].first;
+    b->run_sink  = runs[slot].second;
+    b->produced  = produced_buffers[slot];
+    launched++;
+    if (SYSTEM_FREE_RUNNING) {
+        // the ring has a slot for every request of the in-flight batches, posting never waits for the movers
+        trace_span span("post jobs", b->id, "xrt");
+        for (size_t i = 0; i < b->jobs->jobs(); i++)
+            b->last_command = ring.post(b->jobs->descriptor(i));
+        return;
+    }
+    if (SYSTEM_JOB_DESCRIPTORS) {
+        b->jobs->set_args(b->run_setup, b->run_sink);
+    } else {
+        b->run_setup.set_arg(arg_setup_aie_size,  (int32_t) b->elements);
+        b->run_sink.set_arg(arg_sink_from_aie_size,   (int32_t) b->elements);
+    }
+    b->buf_in.set_args(b->run_setup, arg_setup_aie_input);
+    b->buf_out.set_args(b->run_sink, arg_sink_from_aie_output);
+    trace_span span("start runs", b->id, "xrt");
+    graph.start_job(b->elements);
+    b->run_sink.start();
+    b->run_setup.start();
+}
+
+void accelerator::dispatcher_loop() {
+    trace_thread_name("dispatcher");
+    while (true) {
+        batch* b = new batch();
+        b->elements = collect(b->requests);
+        if (b->requests.empty()) {
+            delete b;
+            break; // stopping, and everything was dispatched
+        }
+        size_t offset = 0;
+        for (request* r : b->requests) {
+            b->offsets.push_back(offset);
+            offset += beat_aligned(r->input.size());
+        }
+
+        // keep at most inflight_batches on the device, the completion thread frees the slots
+        {
+            std::unique_lock<std::mutex> lock(inflight_mutex);
+            inflight_cv.wait(lock, [&] { return (int) inflight.size() < config.inflight_batches; });
+        }
+        try {
+            launch(b);
+        } catch (...) {
+            for (request* r : b->requests) {
+                tracer::get().async_end("request", "host", r->id);
+                r->promise.set_exception(std::current_exception());
+                delete r;
+            }
+            tracer::get().async_end("batch", "host", b->id);
+            delete b;
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> guard(inflight_mutex);
+            inflight.push_back(b);
+        }
+        inflight_cv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> guard(inflight_mutex);
+        dispatcher_done = true;
+    }
+    inflight_cv.notify_all();
+}
+
+void accelerator::complete(batch* b) {
+    std::vector<size_t> counts; // elements written by each port of the sink
+    try {
+        if (SYSTEM_FREE_RUNNING) {
+            // the sink completes the jobs in order, the last one of the batch completes all of them
+            trace_span span("wait command ring", b->id, "xrt");
+            ring.wait(b->last_command);
+        } else {
+            {
+                trace_span span("wait setup_aie", b->id, "xrt");
+                b->run_setup.wait();
+            }
+            {
+                trace_span span("wait sink_from_aie", b->id, "xrt");
+                b->run_sink.wait();
+            }
+        }
+        counts = b->produced.counts(b->elements);
+        const size_t slice = striped_buffer::slice_size(b->elements);
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+            if (counts[p] > slice)
+                throw std::runtime_error("sink_from_aie port " + std::to_string(p) + " produced " +
+                                         std::to_string(counts[p]) + " elements, the slice holds " + std::to_string(slice));
+        trace_span span("sync from device", b->id, "xrt");
+        if (SYSTEM_FREE_RUNNING)
+            b->jobs->sync(shared_out, XCL_BO_SYNC_BO_FROM_DEVICE);
+        else if (SYSTEM_JOB_DESCRIPTORS)
+            b->buf_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE, b->jobs->capacity());
+        else
+            b->buf_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE, counts);
+    } catch (...) {
+        for (request* r : b->requests) {
+            tracer::get().async_end("request", "host", r->id);
+            r->promise.set_exception(std::current_exception());
+            delete r;
+        }
+        tracer::get().async_end("batch", "host", b->id);
+        return;
+    }
+
+    trace_span span("copy results out", b->id);
+    if (SYSTEM_FRAMED_OUTPUT) {
+        // one request per batch: its result is what the ports produced, in port order, without the padding
+        request* r = b->requests[0];
+        result res;
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+            res.output.insert(res.output.end(), b->buf_out.slice(p), b->buf_out.slice(p) + counts[p]);
+        if (res.output.size() > r->input.size()) res.output.resize(r->input.size());
+        tracer::get().async_end("request", "host", r->id);
+        r->promise.set_value(std::move(res));
+        delete r;
+        tracer::get().async_end("batch", "host", b->id);
+        return;
+    }
+    for (size_t i = 0; i < b->requests.size(); i++) {
+        request* r = b->requests[i];
+        result res;
+        res.output.resize(r->input.size());
+        if (SYSTEM_JOB_DESCRIPTORS)
+            b->jobs->read(SYSTEM_FREE_RUNNING ? shared_out : b->buf_out, i, res.output.data(), r->input.size());
+        else
+            b->buf_out.read(b->elements, b->offsets[i], res.output.data(), r->input.size());
+        tracer::get().async_end("request", "host", r->id);
+        r->promise.set_value(std::move(res));
+        delete r;
+    }
+    tracer::get().async_end("batch", "host", b->id);
+}
+
+void accelerator::completion_loop() {
+    trace_thread_name("completion");
+    while (true) {
+        batch* b;
+        {
+            std::unique_lock<std::mutex> lock(inflight_mutex);
+            inflight_cv.wait(lock, [&] { return !inflight.empty() || dispatcher_done; });
+            if (inflight.empty()) break;
+            b = inflight.front();
+        }
+        complete(b);
+        {
+            std::lock_guard<std::mutex> guard(inflight_mutex);
+            inflight.erase(inflight.begin());
+        }
+        inflight_cv.notify_all();
+        delete b; // the leases go back to the pool
+    }
+}
+
+} // namespace voted
@@ -0,0 +1,175 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Reusable host library around the setup_aie -> AIE -> sink_from_aie pipeline.
+// The xclbin is loaded once, then any number of threads can submit() requests concurrently: a request is
+// pushed on a lock-free queue and the caller gets a std::future right away. A dispatcher thread packs the
+// pending requests into one device run (batching the small ones), a completion thread waits for the runs and
+// fans the results back out to the futures, so request threads never block on run.wait(). With
+// SYSTEM_FREE_RUNNING the movers are started once, with the accelerator, and every batch is posted to their
+// command ring instead of being launched.
+#ifndef ACCELERATOR_HPP
+#define ACCELERATOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "experimental/xrt_kernel.h"
+#include "experimental/xrt_uuid.h"
+#include "../common/constants.h"
+#include "bo_pool.hpp"
+#include "striped_buffer.hpp"
+#include "graph_control.hpp"
+#include "mover_stats.hpp"
+#include "produced_buffer.hpp"
+#include "job_table.hpp"
+#include "command_ring.hpp"
+#include "mpsc_queue.hpp"
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+namespace voted {
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+template <typename T> using span = std::span<T>;
+#else
+// Minimal std::span replacement for C++17 builds
+template <typename T>
+class span {
+public:
+    span(T* ptr, size_t count) : ptr(ptr), count(count) {}
+    template <typename Container>
+    span(Container& c) : ptr(c.data()), count(c.size()) {}
+    T* data() const { return ptr; }
+    size_t size() const { return count; }
+    T* begin() const { return ptr; }
+    T* end() const { return ptr + count; }
+private:
+    T* ptr;
+    size_t count;
+};
+#endif
+
+struct result {
+    std::vector<data_t> output;
+};
+
+struct accelerator_config {
+    size_t max_batch_elements = 1 << 20; // a batch is closed when it reaches this many elements...
+    size_t max_batch_requests = 1024;    // ...or this many requests
+    int batch_timeout_us = 50;           // how long the dispatcher waits for more requests to fill a batch
+    int inflight_batches = 2;            // batches queued on the kernels at the same time
+};
+
+class accelerator {
+public:
+    accelerator(const std::string& xclbin_file, int device_id = 0, accelerator_config config = accelerator_config());
+    // Completes all the submitted requests, then stops the threads
+    ~accelerator();
+
+    accelerator(const accelerator&) = delete;
+    accelerator& operator=(const accelerator&) = delete;
+
+    // Thread-safe and non-blocking: the input is copied, so the caller can reuse it immediately
+    std::future<result> submit(span<const data_t> input);
+
+private:
+    struct request {
+        uint64_t id; // in submission order, tags the request in the trace (trace.hpp)
+        std::vector<data_t> input;
+        std::promise<result> promise;
+    };
+
+    struct batch {
+        striped_buffer buf_in;
+        striped_buffer buf_out;
+        xrt::run run_setup;
+        xrt::run run_sink;
+        produced_buffer produced; // the produced argument of run_sink, with SYSTEM_FRAMED_OUTPUT
+        job_table* jobs = nullptr; // one job per request, with SYSTEM_JOB_DESCRIPTORS
+        std::vector<request*> requests;
+        std::vector<size_t> offsets; // first element of each request in the buffers
+        size_t elements = 0;
+        uint64_t id = 0; // in launch order
+        uint32_t last_command = 0; // command of its last request, with SYSTEM_FREE_RUNNING
+    };
+
+    void dispatcher_loop();
+    void completion_loop();
+    size_t collect(std::vector<request*>& requests);
+    void launch(batch* b);
+    void complete(batch* b);
+
+    accelerator_config config;
+    xrt::device device;
+    xrt::uuid xclbin_uuid;
+    xrt::kernel krnl_setup_aie;
+    xrt::kernel krnl_sink_from_aie;
+    std::vector<xrtMemoryGroup> banks_input;  // one per memory port of the movers
+    std::vector<xrtMemoryGroup> banks_output;
+    graph_control graph; // destroyed after the threads are joined, so a persistent graph is drained last
+    bo_pool pool;
+    std::vector<std::pair<xrt::run, xrt::run>> runs; // setup/sink run pair of each in-flight batch
+    std::vector<std::pair<mover_stats_buffer, mover_stats_buffer>> stats_buffers; // their stats arguments
+    std::vector<produced_buffer> produced_buffers; // the produced argument of their sink run
+    std::vector<job_table> job_tables; // their job tables
+    // with SYSTEM_FREE_RUNNING the movers serve the ring from the constructor on, on buffers where the batch of
+    // slot i takes the words [i * region_words, (i + 1) * region_words) of every slice
+    striped_buffer shared_in;
+    striped_buffer shared_out;
+    size_t region_words = 0;
+    command_ring ring; // destroyed first, so the movers stop before their buffers go
+    request* held = nullptr; // popped by collect() but left for the next batch, with SYSTEM_FREE_RUNNING
+    size_t launched = 0;
+    std::atomic<uint64_t> submitted_requests{0};
+
+    // submission: lock-free for the producers, the mutex only parks the idle dispatcher
+    mpsc_queue<request*> submitted;
+    std::atomic<bool> dispatcher_sleeping{false};
+    std::mutex submit_mutex;
+    std::condition_variable submit_cv;
+
+    // launched batches, in order, from the dispatcher to the completion thread
+    std::vector<batch*> inflight;
+    std::mutex inflight_mutex;
+    std::condition_variable inflight_cv;
+
+    std::atomic<bool> stopping{false};
+    bool dispatcher_done = false;
+    std::thread dispatcher;
+    std::thread completer;
+};
+
+} // namespace voted
+
+#endif // ACCELERATOR_HPP
@@ -0,0 +1,113 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Example of the asynchronous request API: several client threads submit requests of random sizes to one
+// voted::accelerator, which batches them into device runs. Every client checks its results.
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include "accelerator.hpp"
+#include "host_utils.hpp"
+#include "trace.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <XCLBIN_PATH> [DEVICE_ID] [--clients N] [--requests N] [--max-size ELEMENTS] [--trace FILE]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int device_id = 0;
+    int clients = 8;
+    int requests = 1000;
+    int max_size = 4096;
+    std::string trace_file; // Chrome trace of the requests, batches and XRT calls (see trace.hpp)
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--clients" && i + 1 < argc) clients = std::stoi(argv[++i]);
+        else if (arg == "--requests" && i + 1 < argc) requests = std::stoi(argv[++i]);
+        else if (arg == "--max-size" && i + 1 < argc) max_size = std::stoi(argv[++i]);
+        else if (arg == "--trace" && i + 1 < argc) trace_file = argv[++i];
+        else device_id = std::stoi(arg);
+    }
+
+    // before the accelerator starts its threads, so that they get their names in the trace
+    if (!trace_file.empty()) {
+        tracer::get().open(trace_file);
+        trace_thread_name("main");
+    }
+
+    std::cout << "1. Loading bitstream (" << argv[1] << ") on device " << device_id << "... ";
+    voted::accelerator accel(argv[1], device_id);
+    std::cout << "Done" << std::endl;
+
+    std::cout << "2. Running " << clients << " clients with " << requests << " requests each... ";
+    std::atomic<int> errors{0};
+    std::atomic<size_t> elements{0};
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; c++) {
+        threads.emplace_back([&, c] {
+            trace_thread_name("client " + std::to_string(c));
+            std::mt19937 gen(c);
+            std::uniform_int_distribution<int> size_dist(1, max_size);
+            std::vector<std::vector<data_t>> inputs(requests);
+            std::vector<std::future<voted::result>> futures;
+            // submit everything first: submit() never waits for the device
+            for (int r = 0; r < requests; r++) {
+                inputs[r].resize(size_dist(gen));
+                for (size_t i = 0; i < inputs[r].size(); i++) inputs[r][i] = c * 1000000 + r * 1000 + i;
+                futures.push_back(accel.submit(inputs[r]));
+                elements += inputs[r].size();
+            }
+            for (int r = 0; r < requests; r++) {
+                try {
+                    if (futures[r].get().output != inputs[r]) errors++;
+                } catch (const std::exception& e) {
+                    std::cerr << "Request failed: " << e.what() << std::endl;
+                    errors++;
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Done" << std::endl;
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "Throughput: " << clients * requests / seconds << " requests/s, "
+              << elements * sizeof(data_t) / seconds / 1e9 << " GB/s" << std::endl;
+
+    if (errors) {
+        std::cout << "Test failed: " << errors << " wrong results" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Test passed!" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,263 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Throughput/latency benchmark of the whole setup_aie -> AIE -> sink_from_aie pipeline.
+// For every input size and repetition count it times, for each repetition, the three phases separately:
+//   h2d:    buf_in.sync(TO_DEVICE)
+//   kernel: start of both kernels -> wait of both kernels
+//   d2h:    buf_out.sync(FROM_DEVICE)
+// (with SYSTEM_MEM_PORTS > 1 each buffer is one xrt::bo per memory port, and a phase syncs all of them)
+// and writes p50/p99 latency and GB/s of each phase to a CSV file, one row per (size, repetitions).
+// It runs both on the card and under XCL_EMULATION_MODE=hw_emu, where the default sweep is much smaller.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "experimental/xrt_kernel.h"
+#include "experimental/xrt_uuid.h"
+#include "../common/common.h"
+#include "host_utils.hpp"
+#include "striped_buffer.hpp"
+#include "graph_control.hpp"
+#include "mover_stats.hpp"
+#include "produced_buffer.hpp"
+#include "job_table.hpp"
+#include "command_ring.hpp"
+
+typedef std::chrono::high_resolution_clock bench_clock;
+
+struct phase_stats {
+    double p50_us;
+    double p99_us;
+};
+
+// nearest-rank percentile
+phase_stats compute_stats(std::vector<double> samples_us) {
+    std::sort(samples_us.begin(), samples_us.end());
+    auto rank = [&](double p) {
+        size_t idx = (size_t) (p * samples_us.size() + 0.999999);
+        return samples_us[std::min(samples_us.size(), std::max<size_t>(idx, 1)) - 1];
+    };
+    return phase_stats{rank(0.50), rank(0.99)};
+}
+
+double elapsed_us(bench_clock::time_point from, bench_clock::time_point to) {
+    return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+double gbps(size_t bytes, double us) {
+    return us > 0 ? bytes / (us * 1e3) : 0;
+}
+
+std::vector<int> parse_list(const std::string& list) {
+    std::vector<int> values;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) values.push_back(std::stoi(item));
+    return values;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <XCLBIN_PATH> [--device ID] [--min BYTES] [--max BYTES] [--reps R1,R2,...] [--csv FILE]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string xclbin_file = argv[1];
+
+    char *env_emu = getenv("XCL_EMULATION_MODE");
+    bool hw_emu = env_emu && std::string(env_emu) == "hw_emu";
+
+    // sizes go from min to max bytes, multiplying by 4 at each step. hw_emu simulates every cycle of the
+    // kernels, so its default sweep stops at a few hundred KB with few repetitions
+    int device_id = 0;
+    size_t min_bytes = 4 << 10;
+    size_t max_bytes = hw_emu ? (256 << 10) : (4ULL << 30);
+    std::vector<int> reps_list = hw_emu ? std::vector<int>{2, 4} : std::vector<int>{10, 100};
+    std::string csv_file = "benchmark.csv";
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--device" && i + 1 < argc) device_id = std::stoi(argv[++i]);
+        else if (arg == "--min" && i + 1 < argc) min_bytes = std::stoull(argv[++i]);
+        else if (arg == "--max" && i + 1 < argc) max_bytes = std::stoull(argv[++i]);
+        else if (arg == "--reps" && i + 1 < argc) reps_list = parse_list(argv[++i]);
+        else if (arg == "--csv" && i + 1 < argc) csv_file = argv[++i];
+        else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << bold_on << "Benchmark running in " << (hw_emu ? "hardware emulation" : "hardware") << " mode" << bold_off << std::endl;
+
+    std::cout << "1. Loading bitstream (" << xclbin_file << ") on device " << device_id << "... ";
+    xrt::device device = xrt::device(device_id);
+    xrt::uuid xclbin_uuid = device.load_xclbin(xclbin_file);
+    std::cout << "Done" << std::endl;
+
+    // with SYSTEM_COMPUTE_UNITS > 1 only the first pair of movers is used, see scale_out.hpp for all of them
+    xrt::kernel krnl_setup_aie     = xrt::kernel(device, xclbin_uuid, compute_unit("setup_aie", 0));
+    xrt::kernel krnl_sink_from_aie = xrt::kernel(device, xclbin_uuid, compute_unit("sink_from_aie", 0));
+    // starts the graph when it is persistent, every run below then goes through the same graph iteration
+    graph_control graph(device, xclbin_uuid);
+    // the kernels overwrite their counters at every run (with SYSTEM_MOVER_STATS), the benchmark does not read them
+    mover_stats_buffer stats_setup(device, krnl_setup_aie, arg_setup_aie_stats);
+    mover_stats_buffer stats_sink(device, krnl_sink_from_aie, arg_sink_from_aie_stats);
+    // with SYSTEM_FRAMED_OUTPUT the warm-up checks only what the sink produced, the timed runs read back every slice
+    produced_buffer produced(device, krnl_sink_from_aie, arg_sink_from_aie_produced);
+    // with SYSTEM_JOB_DESCRIPTORS every size is a table of one job
+    job_table jobs(device, krnl_setup_aie, krnl_sink_from_aie, 1);
+    // with SYSTEM_FREE_RUNNING the movers are started once per size and every repetition posts the job to their
+    // ring, so the kernel time is the dispatch latency of the ring plus the transfer
+    command_ring ring(device, krnl_setup_aie, krnl_sink_from_aie, 1);
+
+    // one memory bank for each memory port of the movers
+    std::vector<xrtMemoryGroup> banks_input  = port_banks(krnl_setup_aie, arg_setup_aie_input);
+    std::vector<xrtMemoryGroup> banks_output = port_banks(krnl_sink_from_aie, arg_sink_from_aie_output);
+
+    std::ofstream csv(csv_file);
+    if (!csv.is_open()) {
+        std::cerr << "Unable to open " << csv_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    csv << "bytes,reps,"
+        << "h2d_p50_us,h2d_p99_us,kernel_p50_us,kernel_p99_us,d2h_p50_us,d2h_p99_us,total_p50_us,total_p99_us,"
+        << "h2d_gbps,kernel_gbps,d2h_gbps,total_gbps" << std::endl;
+
+    std::cout << "2. Sweeping from " << min_bytes << " to " << max_bytes << " bytes, results in " << csv_file << std::endl;
+    int failures = 0;
+    for (size_t bytes = min_bytes; bytes <= max_bytes; bytes *= 4) {
+        // SYSTEM_SIZE_ALIGN elements (one 128-bit beat with the default system) is the smallest unit the movers handle
+        const size_t size = (bytes / sizeof(data_t)) / SYSTEM_SIZE_ALIGN * SYSTEM_SIZE_ALIGN;
+        if (size == 0 || size > INT32_MAX) continue;
+
+        // slice p of the buffers goes through memory port p
+        const size_t slice = size / SYSTEM_MEM_PORTS;
+        xrt::bo buf_in[SYSTEM_MEM_PORTS], buf_out[SYSTEM_MEM_PORTS];
+        try {
+            for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+                buf_in[p]  = xrt::bo(device, padded_bytes(slice), xrt::bo::flags::normal, banks_input[p]);
+                buf_out[p] = xrt::bo(device, padded_bytes(slice), xrt::bo::flags::normal, banks_output[p]);
+            }
+        } catch (const std::exception& e) {
+            std::cout << "   " << bytes << " bytes: skipped, allocation failed (" << e.what() << ")" << std::endl;
+            continue;
+        }
+
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+            data_t* in_ptr = buf_in[p].map<data_t*>();
+            for (size_t i = 0; i < slice; i++) in_ptr[i] = p * slice + i + 1;
+        }
+
+        xrt::run run_setup = xrt::run(krnl_setup_aie);
+        xrt::run run_sink  = xrt::run(krnl_sink_from_aie);
+        if (SYSTEM_JOB_DESCRIPTORS) {
+            jobs.clear();
+            jobs.add(size);
+            jobs.set_args(run_setup, run_sink);
+        } else {
+            run_setup.set_arg(arg_setup_aie_size,  (int32_t) size);
+            run_sink.set_arg(arg_sink_from_aie_size,   (int32_t) size);
+        }
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+            run_setup.set_arg(arg_setup_aie_input + p, buf_in[p]);
+            run_sink.set_arg(arg_sink_from_aie_output + p, buf_out[p]);
+        }
+        stats_setup.set_arg(run_setup);
+        stats_sink.set_arg(run_sink);
+        produced.set_arg(run_sink);
+        ring.start(run_setup, run_sink);
+
+        for (int reps : reps_list) {
+            std::vector<double> h2d, kernel, d2h, total;
+            // the first repetition is a warm-up, and the one used to check the result
+            for (int r = -1; r < reps; r++) {
+                auto t0 = bench_clock::now();
+                for (xrt::bo& b : buf_in) b.sync(XCL_BO_SYNC_BO_TO_DEVICE, padded_bytes(slice), 0);
+                auto t1 = bench_clock::now();
+                if (SYSTEM_FREE_RUNNING) {
+                    ring.wait(ring.post(jobs.descriptor(0)));
+                } else {
+                    graph.start_job(size);
+                    run_sink.start();
+                    run_setup.start();
+                    run_setup.wait();
+                    run_sink.wait();
+                }
+                auto t2 = bench_clock::now();
+                for (xrt::bo& b : buf_out) b.sync(XCL_BO_SYNC_BO_FROM_DEVICE, padded_bytes(slice), 0);
+                auto t3 = bench_clock::now();
+
+                if (r < 0) {
+                    bool correct = true;
+                    const std::vector<size_t> counts = produced.counts(size);
+                    for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+                        const data_t* in_ptr = buf_in[p].map<data_t*>();
+                        correct &= counts[p] <= slice && std::equal(in_ptr, in_ptr + counts[p], buf_out[p].map<data_t*>());
+                    }
+                    if (!correct) {
+                        std::cout << "   " << bytes << " bytes: wrong result" << std::endl;
+                        failures++;
+                    }
+                    continue;
+                }
+                h2d.push_back(elapsed_us(t0, t1));
+                kernel.push_back(elapsed_us(t1, t2));
+                d2h.push_back(elapsed_us(t2, t3));
+                total.push_back(elapsed_us(t0, t3));
+            }
+            if (reps <= 0) continue;
+
+            const size_t data_bytes = size * sizeof(data_t);
+            phase_stats s_h2d = compute_stats(h2d), s_kernel = compute_stats(kernel);
+            phase_stats s_d2h = compute_stats(d2h), s_total = compute_stats(total);
+            csv << data_bytes << "," << reps << ","
+                << s_h2d.p50_us << "," << s_h2d.p99_us << ","
+                << s_kernel.p50_us << "," << s_kernel.p99_us << ","
+                << s_d2h.p50_us << "," << s_d2h.p99_us << ","
+                << s_total.p50_us << "," << s_total.p99_us << ","
+                << gbps(data_bytes, s_h2d.p50_us) << "," << gbps(data_bytes, s_kernel.p50_us) << ","
+                << gbps(data_bytes, s_d2h.p50_us) << "," << gbps(data_bytes, s_total.p50_us) << std::endl;
+            std::cout << "   " << data_bytes << " bytes x " << reps << ": kernel p50 " << s_kernel.p50_us
+                      << " us, p99 " << s_kernel.p99_us << " us, end-to-end " << gbps(data_bytes, s_total.p50_us) << " GB/s" << std::endl;
+        }
+        // the buffers of the next size need new runs
+        ring.stop();
+    }
+    std::cout << "Done" << std::endl;
+
+    if (graph.controlled()) {
+        std::cout << "3. Shutting down the graph... ";
+        graph.shutdown();
+        std::cout << "Done" << std::endl;
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
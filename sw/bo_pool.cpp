@@ -0,0 +1,161 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bo_pool.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+
+#define HUGEPAGE_SIZE (2UL << 20)
+
+bo_lease::bo_lease(bo_lease&& other) noexcept {
+    *this = std::move(other);
+}
+
+bo_lease& bo_lease::operator=(bo_lease&& other) noexcept {
+    if (this != &other) {
+        give_back();
+        pool = other.pool;
+        buffer = other.buffer;
+        host = other.host;
+        bytes = other.bytes;
+        group = other.group;
+        other.pool = nullptr;
+    }
+    return *this;
+}
+
+bo_lease::~bo_lease() {
+    give_back();
+}
+
+void bo_lease::give_back() {
+    if (pool) pool->release(buffer, host, bytes, group);
+    pool = nullptr;
+}
+
+bo_pool::bo_pool(const xrt::device& device, backing mode, bool hugepages, const xrt::xclbin& xclbin)
+    : device(device), mode(mode), hugepages(hugepages) {
+    if (mode != backing::host_only) return;
+    // the host_only buffers go in the host memory bank, whatever the bank of the kernel argument they are for
+    if (xclbin) {
+        for (const xrt::xclbin::mem& mem : xclbin.get_mems()) {
+            if (mem.get_used() && mem.get_tag().compare(0, 4, "HOST") == 0) {
+                host_bank = mem.get_index();
+                return;
+            }
+        }
+    }
+    throw std::runtime_error("bo_pool: host_only buffers need a host memory bank (HOST[0]) in the xclbin");
+}
+
+bo_pool::~bo_pool() {
+    if (leased)
+        std::cerr << "bo_pool: destroyed with " << leased << " buffers still leased" << std::endl;
+    // every copy of a bo must go before the memory it wraps
+    free_list.clear();
+    for (entry& e : all) e.buffer = xrt::bo();
+    for (entry& e : all)
+        if (e.mapped_bytes) munmap(e.host, e.mapped_bytes);
+}
+
+// Size classes are powers of two, starting from one page
+size_t bo_pool::size_class(size_t bytes) {
+    size_t size = sysconf(_SC_PAGESIZE);
+    while (size < bytes) size <<= 1;
+    return size;
+}
+
+bo_pool::entry bo_pool::allocate(size_t bytes, xrtMemoryGroup group) {
+    if (mode == backing::host_only) {
+        xrt::bo buffer = xrt::bo(device, bytes, xrt::bo::flags::host_only, host_bank);
+        return entry{buffer, buffer.map<void*>(), bytes, 0};
+    }
+
+    // page-aligned memory straight from mmap, on hugepages if requested and available
+    void* host = MAP_FAILED;
+    size_t mapped = bytes;
+    if (hugepages) {
+        mapped = (bytes + HUGEPAGE_SIZE - 1) / HUGEPAGE_SIZE * HUGEPAGE_SIZE;
+        host = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+    if (host == MAP_FAILED) {
+        mapped = bytes;
+        host = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (host == MAP_FAILED) throw std::bad_alloc();
+        if (hugepages) madvise(host, mapped, MADV_HUGEPAGE); // transparent hugepages, best effort
+    }
+    try {
+        return entry{xrt::bo(device, host, bytes, group), host, bytes, mapped};
+    } catch (...) {
+        munmap(host, mapped);
+        throw;
+    }
+}
+
+bo_lease bo_pool::acquire(size_t bytes, xrtMemoryGroup group) {
+    const size_t size = size_class(bytes);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<entry>& list = free_list[key_t(size, group)];
+        if (!list.empty()) {
+            entry e = list.back();
+            list.pop_back();
+            leased++;
+            return bo_lease(this, e.buffer, e.host, e.bytes, group);
+        }
+    }
+    entry e = allocate(size, group);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        all.push_back(e);
+        leased++;
+    }
+    return bo_lease(this, e.buffer, e.host, e.bytes, group);
+}
+
+void bo_pool::reserve(size_t bytes, xrtMemoryGroup group, int count) {
+    const size_t size = size_class(bytes);
+    for (int i = 0; i < count; i++) {
+        entry e = allocate(size, group);
+        std::lock_guard<std::mutex> guard(lock);
+        all.push_back(e);
+        free_list[key_t(size, group)].push_back(e);
+    }
+}
+
+void bo_pool::release(xrt::bo buffer, void* host, size_t bytes, xrtMemoryGroup group) {
+    std::lock_guard<std::mutex> guard(lock);
+    leased--;
+    free_list[key_t(bytes, group)].push_back(entry{buffer, host, bytes, 0});
+}
+
+size_t bo_pool::allocated_bytes() const {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t total = 0;
+    for (const entry& e : all) total += e.bytes;
+    return total;
+}
@@ -0,0 +1,123 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Pool of persistent xrt::bo backed by page-aligned host memory.
+// Memory is allocated once (optionally on hugepages), wrapped as a userptr or host_only xrt::bo, and reused
+// across runs. Buffers are kept by size class (power of two) and memory bank (group_id), so an application
+// fills device-visible memory directly through host_ptr() and pays neither a memcpy nor an allocation per call.
+#ifndef BO_POOL_HPP
+#define BO_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_xclbin.h"
+
+class bo_pool;
+
+// A buffer taken from the pool: it goes back to the pool when destroyed
+class bo_lease {
+public:
+    bo_lease() {}
+    bo_lease(bo_lease&& other) noexcept;
+    bo_lease& operator=(bo_lease&& other) noexcept;
+    bo_lease(const bo_lease&) = delete;
+    bo_lease& operator=(const bo_lease&) = delete;
+    ~bo_lease();
+
+    xrt::bo& bo() { return buffer; }
+    void* host_ptr() const { return host; }
+    template <typename T> T* data() const { return static_cast<T*>(host); }
+    size_t capacity() const { return bytes; }
+    explicit operator bool() const { return pool != nullptr; }
+
+private:
+    friend class bo_pool;
+    bo_lease(bo_pool* pool, xrt::bo buffer, void* host, size_t bytes, xrtMemoryGroup group)
+        : pool(pool), buffer(buffer), host(host), bytes(bytes), group(group) {}
+    void give_back();
+
+    bo_pool* pool = nullptr;
+    xrt::bo buffer;
+    void* host = nullptr;
+    size_t bytes = 0;
+    xrtMemoryGroup group = 0;
+};
+
+class bo_pool {
+public:
+    enum class backing {
+        userptr,   // host memory allocated by the pool and wrapped with xrt::bo(device, ptr, size, group)
+        host_only  // host memory allocated by XRT with xrt::bo::flags::host_only (needs a host memory bank)
+    };
+
+    // hugepages: back the userptr buffers with 2 MB pages, falling back to normal pages when unavailable.
+    // xclbin: the xclbin loaded on the device, needed by host_only to find its host memory bank (HOST[0]). The
+    // buffers are allocated there instead of in the bank given to acquire(), so the xclbin must connect the
+    // kernel arguments they are passed to to host memory (e.g. sp=setup_aie_0.input:HOST[0])
+    bo_pool(const xrt::device& device, backing mode = backing::userptr, bool hugepages = false, const xrt::xclbin& xclbin = xrt::xclbin());
+    // every lease must be given back before the pool is destroyed
+    ~bo_pool();
+    bo_pool(const bo_pool&) = delete;
+    bo_pool& operator=(const bo_pool&) = delete;
+
+    // Returns a buffer of at least `bytes` in memory bank `group`, reusing a free one of the same size class
+    bo_lease acquire(size_t bytes, xrtMemoryGroup group);
+
+    // Allocates `count` buffers up front, so that the first runs do not pay for the allocation either
+    void reserve(size_t bytes, xrtMemoryGroup group, int count);
+
+    size_t allocated_bytes() const;
+
+private:
+    friend class bo_lease;
+
+    struct entry {
+        xrt::bo buffer;
+        void* host;
+        size_t bytes;
+        size_t mapped_bytes; // 0 if the memory belongs to XRT
+    };
+    typedef std::pair<size_t, xrtMemoryGroup> key_t;
+
+    static size_t size_class(size_t bytes);
+    entry allocate(size_t bytes, xrtMemoryGroup group);
+    void release(xrt::bo buffer, void* host, size_t bytes, xrtMemoryGroup group);
+
+    xrt::device device;
+    backing mode;
+    bool hugepages;
+    xrtMemoryGroup host_bank = 0;
+    mutable std::mutex lock;
+    std::map<key_t, std::vector<entry>> free_list;
+    std::vector<entry> all;
+    int leased = 0;
+};
+
+#endif // BO_POOL_HPP
@@ -0,0 +1,163 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Host side of the free-running movers (SYSTEM_FREE_RUNNING in common/system_config.h, RING_* fields in
+// common/common.h). start() launches setup_aie and sink_from_aie once, on buffers that every job then lives in,
+// and each run serves a command ring in its own bank: post() writes the descriptor of a job in the next command
+// slot of both rings and bumps their head, with no run to start, and wait() polls the tail of the sink ring,
+// i.e. the jobs whose output is in memory. stop() posts the stop command, after which the runs return; the graph
+// keeps running (graph_control shuts it down). Without SYSTEM_FREE_RUNNING the ring does nothing.
+#ifndef COMMAND_RING_HPP
+#define COMMAND_RING_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+#include "../common/common.h"
+#include "host_utils.hpp"
+
+class command_ring {
+public:
+    command_ring() {}
+    // rings of at least `slots` command slots (a multiple of RING_LINE), in the bank of the jobs argument of each mover
+    command_ring(const xrt::device& device, const xrt::kernel& setup_aie, const xrt::kernel& sink_from_aie, size_t slots)
+        : slots((std::max<size_t>(slots, 1) + RING_LINE - 1) / RING_LINE * RING_LINE) {
+        if (!SYSTEM_FREE_RUNNING) return;
+        const size_t bytes = RING_ENTRIES(this->slots) * entry_bytes;
+        ring_setup = xrt::bo(device, bytes, xrt::bo::flags::normal, setup_aie.group_id(arg_setup_aie_jobs));
+        ring_sink  = xrt::bo(device, bytes, xrt::bo::flags::normal, sink_from_aie.group_id(arg_sink_from_aie_jobs));
+    }
+    // Stops the movers if stop() was not called
+    ~command_ring() {
+        try {
+            stop();
+        } catch (const std::exception& e) {
+            std::cerr << "command_ring: stop failed: " << e.what() << std::endl;
+        }
+    }
+
+    command_ring(const command_ring&) = delete;
+    command_ring& operator=(const command_ring&) = delete;
+
+    // Starts a run of each mover that serves its ring until stop(). The runs must have their buffer arguments
+    // set: the offsets of every job posted then refer to those buffers
+    void start(xrt::run setup, xrt::run sink) {
+        if (!SYSTEM_FREE_RUNNING || started) return;
+        const std::vector<char> empty(ring_setup.size(), 0);
+        for (xrt::bo* ring : {&ring_setup, &ring_sink}) {
+            ring->write(empty.data());
+            ring->sync(XCL_BO_SYNC_BO_TO_DEVICE);
+        }
+        posted = 0;
+        setup.set_arg(arg_setup_aie_size, (int32_t) slots);
+        setup.set_arg(arg_setup_aie_jobs, ring_setup);
+        sink.set_arg(arg_sink_from_aie_size, (int32_t) slots);
+        sink.set_arg(arg_sink_from_aie_jobs, ring_sink);
+        run_setup = setup;
+        run_sink = sink;
+        run_sink.start();
+        run_setup.start();
+        started = true;
+    }
+
+    // Posts a job (its JOB_FIELDS descriptor fields, see job_table.hpp) to both movers and returns its number.
+    // Waits while every slot holds a job that did not complete yet. Only one thread may post
+    uint32_t post(const uint32_t* descriptor) {
+        if (!started) throw std::runtime_error("command_ring: the movers are not running");
+        while (posted - completed() >= slots)
+            std::this_thread::yield();
+        // the descriptor has to be in memory before the head that makes it visible to the mover
+        const size_t command = (RING_COMMANDS + posted % slots) * entry_bytes;
+        const uint32_t head[JOB_FIELDS] = {posted + 1};
+        for (xrt::bo* ring : {&ring_sink, &ring_setup}) {
+            ring->write(descriptor, entry_bytes, command);
+            ring->sync(XCL_BO_SYNC_BO_TO_DEVICE, entry_bytes, command);
+            ring->write(head, entry_bytes, RING_HEAD * entry_bytes);
+            ring->sync(XCL_BO_SYNC_BO_TO_DEVICE, entry_bytes, RING_HEAD * entry_bytes);
+        }
+        return posted++;
+    }
+
+    // Number of jobs sink_from_aie completed, from the tail of its ring
+    uint32_t completed() {
+        std::lock_guard<std::mutex> guard(mutex);
+        uint32_t tail[JOB_FIELDS];
+        ring_sink.sync(XCL_BO_SYNC_BO_FROM_DEVICE, entry_bytes, RING_TAIL * entry_bytes);
+        ring_sink.read(tail, entry_bytes, RING_TAIL * entry_bytes);
+        return tail[0];
+    }
+
+    // Waits for job n to complete and returns the elements the sink moved for it. Its completion record is
+    // reused by job n + slots, so wait before posting that many more jobs
+    uint32_t wait(uint32_t n) {
+        while ((int32_t) (completed() - n) <= 0)
+            std::this_thread::yield();
+        std::lock_guard<std::mutex> guard(mutex);
+        uint32_t record[JOB_FIELDS];
+        const size_t offset = (RING_COMMANDS + slots + n % slots) * entry_bytes;
+        ring_sink.sync(XCL_BO_SYNC_BO_FROM_DEVICE, entry_bytes, offset);
+        ring_sink.read(record, entry_bytes, offset);
+        if (record[RING_DONE_JOB] != n)
+            throw std::runtime_error("command_ring: the completion of job " + std::to_string(n) + " was overwritten by job " +
+                                     std::to_string(record[RING_DONE_JOB]));
+        return record[RING_DONE_SIZE];
+    }
+
+    // Posts the stop command after the jobs already posted and waits for both runs to return
+    void stop() {
+        if (!started) return;
+        uint32_t stop_command[JOB_FIELDS] = {};
+        stop_command[JOB_SIZE] = RING_STOP;
+        post(stop_command);
+        started = false;
+        run_setup.wait();
+        run_sink.wait();
+    }
+
+    bool running() const { return started; }
+    size_t capacity() const { return slots; }
+
+private:
+    static const size_t entry_bytes = JOB_FIELDS * sizeof(uint32_t);
+
+    uint32_t slots = RING_LINE;
+    uint32_t posted = 0; // jobs posted since start()
+    xrt::bo ring_setup;
+    xrt::bo ring_sink;
+    xrt::run run_setup;
+    xrt::run run_sink;
+    std::mutex mutex;    // between the poster and the waiters, that sync the same lines
+    bool started = false;
+};
+
+#endif // COMMAND_RING_HPP
@@ -0,0 +1,105 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "graph_control.hpp"
+#include <iostream>
+#include "host_utils.hpp"
+
+// Ending a graph that runs until stopped: by then the jobs went through, the kernels only wait for the next one
+static const uint64_t end_timeout_cycles = 1000;
+
+// with RTP ports the graph cannot run on its own: the host has to write them
+#define HAS_RTP_PARAM(name, type, value) || true
+static const bool has_rtp = SYSTEM_RTP_ITERATIONS SYSTEM_RTP_PARAMS(HAS_RTP_PARAM);
+
+graph_control::graph_control(const xrt::device& device, const xrt::uuid& xclbin_uuid, const std::string& name) : name(name) {
+    if (!SYSTEM_PERSISTENT_GRAPH && !has_rtp) return;
+    graph = std::make_unique<xrt::graph>(device, xclbin_uuid, name);
+
+    // asynchronous RTPs block the first invocation until they get a value
+#define SET_RTP_DEFAULT(param, type, value) set_param(#param, (type) value);
+    SYSTEM_RTP_PARAMS(SET_RTP_DEFAULT)
+#undef SET_RTP_DEFAULT
+
+    if (SYSTEM_PERSISTENT_GRAPH) {
+        for (int cu = 0; cu < SYSTEM_COMPUTE_UNITS; cu++) {
+            const xrt::kernel setup_aie(device, xclbin_uuid, compute_unit("setup_aie", cu));
+            xrt::run run(setup_aie);
+            // a negative size makes setup_aie send only the shutdown header
+            run.set_arg(arg_setup_aie_size, (int32_t) -1);
+            stats_shutdown.emplace_back(device, setup_aie, arg_setup_aie_stats);
+            stats_shutdown.back().set_arg(run);
+            if (SYSTEM_JOB_DESCRIPTORS) {
+                // the shutdown run reads no job, but its table argument must be set
+                jobs_shutdown.emplace_back(device, JOB_FIELDS * sizeof(uint32_t), xrt::bo::flags::normal, setup_aie.group_id(arg_setup_aie_jobs));
+                run.set_arg(arg_setup_aie_jobs, jobs_shutdown.back());
+            }
+            run_shutdown.push_back(run);
+        }
+        // one iteration: the kernels loop over the jobs internally and return on JOB_SHUTDOWN, so the iteration
+        // ends exactly when the graph is drained and wait() returns (with run(-1) the graph could only be killed)
+        graph->run(1);
+    }
+    else {
+        // every kernel invocation is one job, the graph runs until shutdown()
+        graph->run(-1);
+    }
+    started = true;
+}
+
+graph_control::~graph_control() {
+    try {
+        shutdown();
+    } catch (const std::exception& e) {
+        std::cerr << "graph_control: shutdown failed: " << e.what() << std::endl;
+    }
+}
+
+std::string graph_control::port(const std::string& param, int lane) const {
+    return name + "." + param + "[" + std::to_string(lane) + "]";
+}
+
+void graph_control::start_job(size_t elements, int cu) {
+    if (!SYSTEM_RTP_ITERATIONS || !graph) return;
+    std::lock_guard<std::mutex> lock(update_mutex);
+    for (int l = cu * CU_LANES; l < (cu + 1) * CU_LANES; l++)
+        graph->update(port("iterations", l), (int32_t) lane_iterations(elements, l));
+}
+
+void graph_control::shutdown() {
+    if (!started) return;
+    started = false;
+    if (SYSTEM_PERSISTENT_GRAPH) {
+        // setup_aie processes its runs in order, so the shutdown header follows the payload of every queued job
+        for (xrt::run& run : run_shutdown)
+            run.start();
+        for (xrt::run& run : run_shutdown)
+            run.wait();
+        graph->wait();
+        graph->end();
+    }
+    else {
+        graph->end(end_timeout_cycles);
+    }
+}
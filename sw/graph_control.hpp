@@ -0,0 +1,97 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Host-side control of the AIE graph.
+// With a persistent graph (SYSTEM_PERSISTENT_GRAPH in common/system_config.h) the host starts a single graph
+// iteration through xrt::graph: its kernel invocation serves every job back to back, framed by the headers of
+// setup_aie, so consecutive runs pay no graph init/run/end. shutdown() drains it: it sends the JOB_SHUTDOWN header
+// after the jobs already queued on setup_aie, waits for the kernels to return and ends the graph.
+// With runtime parameter (RTP) ports (SYSTEM_RTP_ITERATIONS, SYSTEM_RTP_PARAMS) the host runs the graph until
+// shutdown(), writes the iterations of each job with start_job() and the kernel parameters with set_param().
+// Otherwise the graph runs on its own, as loaded with the xclbin, and graph_control does nothing.
+// With SYSTEM_COMPUTE_UNITS > 1 every pair of movers has its own lanes: start_job() writes the RTPs of the lanes of
+// one unit, and shutdown() sends the JOB_SHUTDOWN header through every unit.
+#ifndef GRAPH_CONTROL_HPP
+#define GRAPH_CONTROL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "experimental/xrt_graph.h"
+#include "experimental/xrt_kernel.h"
+#include "experimental/xrt_uuid.h"
+#include "../common/common.h"
+#include "mover_stats.hpp"
+
+class graph_control {
+public:
+    // name is the name of the graph instance in aie/src/graph.cpp
+    graph_control(const xrt::device& device, const xrt::uuid& xclbin_uuid, const std::string& name = "aie_graph");
+    // Shuts the graph down if shutdown() was not called
+    ~graph_control();
+
+    graph_control(const graph_control&) = delete;
+    graph_control& operator=(const graph_control&) = delete;
+
+    // To be called before starting setup_aie (compute unit cu) on a job of the given number of elements: with
+    // SYSTEM_RTP_ITERATIONS it writes the iterations RTP of every lane of the unit. The RTP is synchronous, so this
+    // blocks while the kernels have not started the previous job yet. Thread-safe
+    void start_job(size_t elements, int cu = 0);
+
+    // Writes an asynchronous RTP parameter (SYSTEM_RTP_PARAMS) on every lane. The kernels use the new value from
+    // their next invocation, i.e. from the next job that was not started yet
+    template <typename T>
+    void set_param(const std::string& param, T value) {
+        if (!graph) return;
+        std::lock_guard<std::mutex> lock(update_mutex);
+        for (int l = 0; l < NUM_LANES; l++)
+            graph->update(port(param, l), value);
+    }
+
+    // Stops the graph. A persistent graph is drained first: the jobs already started on setup_aie and
+    // sink_from_aie go through it (their sink runs must have been started, otherwise their output has nowhere
+    // to go). A graph with RTP ports is simply ended, so wait for the sink runs of every job before
+    void shutdown();
+
+    // true when the host drives the graph, i.e. when shutdown() has something to do
+    bool controlled() const { return graph != nullptr; }
+    bool persistent() const { return SYSTEM_PERSISTENT_GRAPH && graph != nullptr; }
+    bool running() const { return started; }
+
+private:
+    std::string port(const std::string& param, int lane) const;
+
+    std::string name;
+    std::unique_ptr<xrt::graph> graph;
+    std::mutex update_mutex; // the movers of different compute units may start their jobs from different threads
+    // the shutdown run of every compute unit, with its arguments
+    std::vector<xrt::run> run_shutdown;
+    std::vector<mover_stats_buffer> stats_shutdown;
+    std::vector<xrt::bo> jobs_shutdown; // with SYSTEM_JOB_DESCRIPTORS
+    bool started = false;
+};
+
+#endif // GRAPH_CONTROL_HPP
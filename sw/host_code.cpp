@@ -4,43 +4,165 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
 #include "experimental/xrt_kernel.h"
 #include "experimental/xrt_uuid.h"
+#include "experimental/xrt_xclbin.h"
 #include "../common/common.h"
+#include "host_utils.hpp"
+#include "graph_control.hpp"
+#include "bo_pool.hpp"
+#include "striped_buffer.hpp"
+#include "mover_stats.hpp"
+#include "produced_buffer.hpp"
+#include "job_table.hpp"
+#include "command_ring.hpp"
+#include "trace.hpp"
 
-// args indexes per kernel
-#define arg_setup_aie_size    0
-#define arg_setup_aie_input   1
-#define arg_sink_from_aie_output 1
-#define arg_sink_from_aie_size   2
+// One in-flight chunk: its own pair of buffers and its own pair of runs, so that
+// several chunks can be queued on the kernels at the same time.
+// The buffers come from the pool: the input is generated directly in buf_in and the result is
+// checked directly in buf_out, without staging copies. Each buffer has one slice for each memory port.
+// With SYSTEM_FREE_RUNNING the movers run once, on buffers shared by every slot: the chunk of a slot is a job at
+// its own place in them, posted to the command ring instead of starting the runs
+struct chunk_slot {
+    striped_buffer buf_in;
+    striped_buffer buf_out;
+    xrt::run run_setup;
+    xrt::run run_sink;
+    mover_stats_buffer stats_setup; // performance counters of the runs, with SYSTEM_MOVER_STATS
+    mover_stats_buffer stats_sink;
+    produced_buffer produced;          // elements written by each port of the sink, with SYSTEM_FRAMED_OUTPUT
+    job_table jobs;                    // the chunk as a table of one job, with SYSTEM_JOB_DESCRIPTORS
+    striped_buffer* shared_in = nullptr;  // the buffers the job of the chunk is in, with SYSTEM_FREE_RUNNING
+    striped_buffer* shared_out = nullptr;
+    size_t first_word = 0;                // where the job of the slot starts in every slice
+    uint32_t command = 0;                 // its number in the command ring
+    size_t index = 0;    // number of the chunk, its id in the trace
+    size_t offset = 0;   // first element of the chunk
+    size_t elements = 0; // number of elements of the chunk
+    bool busy = false;
+};
 
-std::ostream& bold_on(std::ostream& os);
-std::ostream& bold_off(std::ostream& os);
+// Slice p of the input and of the output of the chunk in the slot
+data_t* input_slice(const chunk_slot& slot, int p) {
+    return slot.shared_in ? slot.jobs.slice(*slot.shared_in, 0, p) : slot.buf_in.slice(p);
+}
+data_t* output_slice(const chunk_slot& slot, int p) {
+    return slot.shared_out ? slot.jobs.slice(*slot.shared_out, 0, p) : slot.buf_out.slice(p);
+}
 
-int checkResult(int32_t* input, int32_t* output, int size) {
-    for (int i = 0; i < size; i++) {
+int checkResult(const data_t* input, const data_t* output, size_t size, size_t offset = 0) {
+    for (size_t i = 0; i < size; i++) {
         if (input[i] != output[i]) {
-            std::cout << "Error at index " << i
-                      << ": " << input[i]
-                      << " != " << output[i] << std::endl;
+            std::cout << "Error at index " << offset + i
+                      << ": " << +input[i]
+                      << " != " << +output[i] << std::endl;
             return EXIT_FAILURE;
         }
     }
-    std::cout << "Test passed!" << std::endl;
     return EXIT_SUCCESS;
 }
 
+// Waits for the chunk in the slot, brings its result back and checks it in place, slice by slice. The counters
+// of the movers are added to setup_stats and sink_stats, the elements the sink wrote to produced_total. With
+// SYSTEM_FRAMED_OUTPUT only what each port produced is brought back and checked. With SYSTEM_FREE_RUNNING the
+// chunk is done when the ring completes its job
+int finish_chunk(chunk_slot& slot, command_ring& ring, mover_stats& setup_stats, mover_stats& sink_stats, size_t& produced_total) {
+    const int64_t id = slot.index;
+    int result = EXIT_SUCCESS;
+    if (SYSTEM_FREE_RUNNING) {
+        trace_span span("wait job", id, "xrt");
+        const uint32_t moved = ring.wait(slot.command);
+        if (moved != slot.elements) {
+            std::cout << "Error: the movers moved " << moved << " elements of chunk " << slot.index << ", expected "
+                      << slot.elements << std::endl;
+            result = EXIT_FAILURE;
+        }
+    } else {
+        {
+            trace_span span("wait setup_aie", id, "xrt");
+            slot.run_setup.wait();
+        }
+        {
+            trace_span span("wait sink_from_aie", id, "xrt");
+            slot.run_sink.wait();
+        }
+        slot.stats_setup.collect(setup_stats);
+        slot.stats_sink.collect(sink_stats);
+    }
+    slot.busy = false;
+    const size_t slice = striped_buffer::slice_size(slot.elements);
+    std::vector<size_t> produced = slot.produced.counts(slot.elements);
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+        if (produced[p] > slice) {
+            std::cout << "Error: port " << p << " produced " << produced[p] << " elements, the slice holds "
+                      << slice << std::endl;
+            produced[p] = slice;
+            result = EXIT_FAILURE;
+        }
+        produced_total += produced[p];
+    }
+    {
+        trace_span span("sync from device", id, "xrt");
+        if (slot.shared_out)
+            slot.jobs.sync(*slot.shared_out, XCL_BO_SYNC_BO_FROM_DEVICE);
+        else
+            slot.buf_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE, produced);
+    }
+    {
+        trace_span span("check result", id);
+        for (int p = 0; p < SYSTEM_MEM_PORTS && result == EXIT_SUCCESS; p++)
+            result = checkResult(input_slice(slot, p), output_slice(slot, p), produced[p], slot.offset + p * slice);
+    }
+    tracer::get().async_end("chunk", "host", id);
+    return result;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <XCLBIN_PATH> [--hw_emu] [DEVICE_ID]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <XCLBIN_PATH> [--hw_emu] [DEVICE_ID] [--size ELEMENTS] [--chunk ELEMENTS] [--slots N] [--hugepages] [--host-only] [--clock MHZ] [--trace FILE]" << std::endl;
         return EXIT_FAILURE;
     }
 
     std::string xclbin_file = argv[1];
 
+    // size: total number of data_t elements to process. chunk: number of elements moved by each run (0 means a single
+    // run for the whole input). slots: number of chunks in flight, with at least 2 the transfers of a chunk
+    // overlap the processing of the previous one. hugepages/host-only select the backing of the buffer pool.
+    // clock: frequency of the movers, to turn their cycle counters into time (SYSTEM_MOVER_STATS).
+    // trace: writes a Chrome trace of the run to FILE (see trace.hpp)
     int device_id = 0;
-    if (argc >= 4) {
-        device_id = std::stoi(argv[3]);
+    size_t size = 32;
+    size_t chunk = 0;
+    int num_slots = 2;
+    bool hugepages = false;
+    bool host_only = false;
+    double clock_mhz = 300;
+    std::string trace_file;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--hw_emu") continue;
+        else if (arg == "--size" && i + 1 < argc) size = std::stoull(argv[++i]);
+        else if (arg == "--chunk" && i + 1 < argc) chunk = std::stoull(argv[++i]);
+        else if (arg == "--slots" && i + 1 < argc) num_slots = std::stoi(argv[++i]);
+        else if (arg == "--hugepages") hugepages = true;
+        else if (arg == "--host-only") host_only = true;
+        else if (arg == "--clock" && i + 1 < argc) clock_mhz = std::stod(argv[++i]);
+        else if (arg == "--trace" && i + 1 < argc) trace_file = argv[++i];
+        else device_id = std::stoi(arg);
+    }
+    if (chunk == 0 || chunk > size) chunk = size;
+    if (size % SYSTEM_SIZE_ALIGN != 0 || chunk % SYSTEM_SIZE_ALIGN != 0 || num_slots < 1) {
+        std::cerr << "size and chunk must be multiples of " << SYSTEM_SIZE_ALIGN << " (see common/system_config.h), slots must be at least 1" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!trace_file.empty()) {
+        tracer::get().open(trace_file);
+        trace_thread_name("main");
     }
 
     char *env_emu = getenv("XCL_EMULATION_MODE");
@@ -52,47 +174,159 @@ int main(int argc, char* argv[]) {
     }
 
     std::cout << "1. Loading bitstream (" << xclbin_file << ") on device " << device_id << "... ";
+    trace_span load_span("load xclbin", -1, "xrt");
     xrt::device device = xrt::device(device_id);
-    xrt::uuid xclbin_uuid = device.load_xclbin(xclbin_file);
+    xrt::xclbin xclbin = xrt::xclbin(xclbin_file);
+    xrt::uuid xclbin_uuid = device.load_xclbin(xclbin);
     std::cout << "Done" << std::endl;
 
-    xrt::kernel krnl_setup_aie     = xrt::kernel(device, xclbin_uuid, "setup_aie");
-    xrt::kernel krnl_sink_from_aie = xrt::kernel(device, xclbin_uuid, "sink_from_aie");
+    // with SYSTEM_COMPUTE_UNITS > 1 only the first pair of movers is used, see scale_out.hpp for all of them
+    xrt::kernel krnl_setup_aie     = xrt::kernel(device, xclbin_uuid, compute_unit("setup_aie", 0));
+    xrt::kernel krnl_sink_from_aie = xrt::kernel(device, xclbin_uuid, compute_unit("sink_from_aie", 0));
+    // starts the graph when it is persistent, every run below then goes through the same graph iteration
+    graph_control graph(device, xclbin_uuid);
+    load_span.end();
 
-    xrtMemoryGroup bank_input  = krnl_setup_aie.group_id(arg_setup_aie_input);
-    xrtMemoryGroup bank_output = krnl_sink_from_aie.group_id(arg_sink_from_aie_output);
+    // one memory bank for each memory port of the movers
+    std::vector<xrtMemoryGroup> banks_input  = port_banks(krnl_setup_aie, arg_setup_aie_input);
+    std::vector<xrtMemoryGroup> banks_output = port_banks(krnl_sink_from_aie, arg_sink_from_aie_output);
 
-    const int32_t size = 32;
-    int32_t nums[size];
-    for (int i = 0; i < size; i++) nums[i] = i + 1;
+    const size_t num_chunks = (size + chunk - 1) / chunk;
+    if ((size_t) num_slots > num_chunks) num_slots = num_chunks;
 
-    xrt::bo buf_in  = xrt::bo(device, size * sizeof(int32_t), xrt::bo::flags::normal, bank_input);
-    xrt::bo buf_out = xrt::bo(device, size * sizeof(int32_t), xrt::bo::flags::normal, bank_output);
-
-    xrt::run run_setup  = xrt::run(krnl_setup_aie);
-    xrt::run run_sink   = xrt::run(krnl_sink_from_aie);
+    std::cout << "2. Allocating " << num_slots << " buffer pairs of " << chunk << " elements... ";
+    trace_span alloc_span("allocate buffers", -1, "xrt");
+    bo_pool pool(device, host_only ? bo_pool::backing::host_only : bo_pool::backing::userptr, hugepages, xclbin);
+    std::vector<chunk_slot> slots(num_slots);
+    // with SYSTEM_FREE_RUNNING slot i has its chunk at word i * slot_words of the slices of the shared buffers
+    const size_t slot_words = padded_bytes(striped_buffer::slice_size(chunk)) / 64;
+    striped_buffer shared_in, shared_out;
+    if (SYSTEM_FREE_RUNNING) {
+        const size_t capacity = num_slots * slot_words * 64 / sizeof(data_t) * SYSTEM_MEM_PORTS;
+        shared_in  = striped_buffer(pool, capacity, banks_input);
+        shared_out = striped_buffer(pool, capacity, banks_output);
+    }
+    for (chunk_slot& slot : slots) {
+        if (SYSTEM_FREE_RUNNING) {
+            slot.shared_in  = &shared_in;
+            slot.shared_out = &shared_out;
+            slot.first_word = (&slot - slots.data()) * slot_words;
+        } else {
+            slot.buf_in  = striped_buffer(pool, chunk, banks_input);
+            slot.buf_out = striped_buffer(pool, chunk, banks_output);
+        }
+        slot.run_setup = xrt::run(krnl_setup_aie);
+        slot.run_sink  = xrt::run(krnl_sink_from_aie);
+        slot.buf_in.set_args(slot.run_setup, arg_setup_aie_input);
+        slot.buf_out.set_args(slot.run_sink, arg_sink_from_aie_output);
+        slot.stats_setup = mover_stats_buffer(device, krnl_setup_aie, arg_setup_aie_stats);
+        slot.stats_sink  = mover_stats_buffer(device, krnl_sink_from_aie, arg_sink_from_aie_stats);
+        slot.stats_setup.set_arg(slot.run_setup);
+        slot.stats_sink.set_arg(slot.run_sink);
+        slot.produced = produced_buffer(device, krnl_sink_from_aie, arg_sink_from_aie_produced);
+        slot.produced.set_arg(slot.run_sink);
+        slot.jobs = job_table(device, krnl_setup_aie, krnl_sink_from_aie, 1);
+    }
+    // the free-running movers start here and serve every chunk, one slot of the ring for each slot
+    command_ring ring(device, krnl_setup_aie, krnl_sink_from_aie, num_slots);
+    if (SYSTEM_FREE_RUNNING) {
+        xrt::run run_setup(krnl_setup_aie), run_sink(krnl_sink_from_aie);
+        shared_in.set_args(run_setup, arg_setup_aie_input);
+        shared_out.set_args(run_sink, arg_sink_from_aie_output);
+        ring.start(run_setup, run_sink);
+    }
+    alloc_span.end();
+    std::cout << "Done" << std::endl;
 
-    run_setup.set_arg(arg_setup_aie_size,  size);
-    run_setup.set_arg(arg_setup_aie_input, buf_in);
+    // Chunk k goes in slot k % num_slots. Before reusing a slot the chunk it holds is completed, which overlaps
+    // the readback of chunk k - num_slots and the upload of chunk k with the processing of the chunks in between.
+    // The kernels process the queued runs back to back, so they are never idle waiting for the host.
+    std::cout << "3. Streaming " << size << " elements in " << num_chunks << " chunks... ";
+    int result = EXIT_SUCCESS;
+    mover_stats setup_stats, sink_stats;
+    size_t produced_total = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t k = 0; k < num_chunks; k++) {
+        chunk_slot& slot = slots[k % num_slots];
+        if (slot.busy) result |= finish_chunk(slot, ring, setup_stats, sink_stats, produced_total);
 
-    run_sink.set_arg(arg_sink_from_aie_output, buf_out);
-    run_sink.set_arg(arg_sink_from_aie_size,   size);
+        // the chunk span covers the chunk from its input to its check, across the other chunks in flight
+        slot.index    = k;
+        slot.offset   = k * chunk;
+        slot.elements = std::min(chunk, size - slot.offset);
+        tracer::get().async_begin("chunk", "host", k);
+        // a single job at the start of every slice (of the slot, with SYSTEM_FREE_RUNNING) is laid out like a plain run
+        slot.jobs.clear(slot.first_word);
+        slot.jobs.add(slot.elements);
+        {
+            trace_span span("fill input", k);
+            const size_t slice = striped_buffer::slice_size(slot.elements);
+            for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+                data_t* nums = input_slice(slot, p);
+                for (size_t i = 0; i < slice; i++) nums[i] = slot.offset + p * slice + i + 1;
+            }
+        }
+        {
+            trace_span span("sync to device", k, "xrt");
+            if (slot.shared_in)
+                slot.jobs.sync(*slot.shared_in, XCL_BO_SYNC_BO_TO_DEVICE);
+            else
+                slot.buf_in.sync(XCL_BO_SYNC_BO_TO_DEVICE, slot.elements);
+        }
 
-    buf_in.write(nums);
-    buf_in.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+        if (SYSTEM_FREE_RUNNING) {
+            // nothing to start: the movers pick the job up from their ring
+            trace_span span("post job", k, "xrt");
+            slot.command = ring.post(slot.jobs.descriptor(0));
+        } else {
+            if (SYSTEM_JOB_DESCRIPTORS) {
+                slot.jobs.set_args(slot.run_setup, slot.run_sink);
+            } else {
+                slot.run_setup.set_arg(arg_setup_aie_size, (int32_t) slot.elements);
+                slot.run_sink.set_arg(arg_sink_from_aie_size, (int32_t) slot.elements);
+            }
+            trace_span span("start runs", k, "xrt");
+            graph.start_job(slot.elements);
+            slot.run_sink.start();
+            slot.run_setup.start();
+        }
+        slot.busy = true;
+    }
+    for (size_t k = num_chunks > (size_t) num_slots ? num_chunks - num_slots : 0; k < num_chunks; k++) {
+        chunk_slot& slot = slots[k % num_slots];
+        if (slot.busy) result |= finish_chunk(slot, ring, setup_stats, sink_stats, produced_total);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    // the free-running movers return, the graph keeps running until its shutdown
+    ring.stop();
+    std::cout << "Done" << std::endl;
 
-    run_sink.start();
-    run_setup.start();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double gbytes  = (double) size * sizeof(data_t) / 1e9;
+    std::cout << "Sustained throughput: " << gbytes / seconds << " GB/s in, "
+              << 2 * gbytes / seconds << " GB/s in+out (" << seconds * 1e3 << " ms)" << std::endl;
+    // with SYSTEM_MOVER_STATS: per memory port, the share of cycles the movers moved data or stalled on the AIE
+    // (backpressure, or no output yet) or on memory, and the bandwidth they reached while running
+    setup_stats.print(std::cout, "setup_aie", clock_mhz);
+    sink_stats.print(std::cout, "sink_from_aie", clock_mhz);
+    if (SYSTEM_FRAMED_OUTPUT)
+        std::cout << "Framed output: produced " << produced_total << " of " << size << " elements" << std::endl;
 
-    run_setup.wait();
-    run_sink.wait();
+    if (graph.controlled()) {
+        std::cout << "4. Shutting down the graph... ";
+        trace_span span("graph shutdown", -1, "xrt");
+        graph.shutdown();
+        std::cout << "Done" << std::endl;
+    }
 
-    buf_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
-    int32_t output_buffer[size];
-    buf_out.read(output_buffer);
+    if (!trace_file.empty()) {
+        if (tracer::get().close())
+            std::cout << "Trace written to " << trace_file << std::endl;
+        else
+            std::cerr << "Unable to write the trace to " << trace_file << std::endl;
+    }
 
-    return checkResult(nums, output_buffer, size);
+    if (result == EXIT_SUCCESS)
+        std::cout << "Test passed!" << std::endl;
+    return result;
 }
-
-std::ostream& bold_on(std::ostream& os)  { return os << "\e[1m"; }
-std::ostream& bold_off(std::ostream& os) { return os << "\e[0m"; }
\ No newline at end of file
@@ -0,0 +1,66 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Helpers shared by the host executables (host_code.cpp, benchmark.cpp)
+#ifndef HOST_UTILS_HPP
+#define HOST_UTILS_HPP
+
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "../common/common.h"
+
+// args indexes per kernel: each mover takes one buffer for each of its SYSTEM_MEM_PORTS memory ports, the
+// buffer of port p is argument arg_setup_aie_input + p (arg_sink_from_aie_output + p). Every stream is an
+// argument too, so the buffers of sink_from_aie follow its CU_PLIOS input streams. The stats buffers only
+// exist with SYSTEM_MOVER_STATS (see mover_stats.hpp), the produced counts with SYSTEM_FRAMED_OUTPUT
+// (see produced_buffer.hpp) and the job tables with SYSTEM_JOB_DESCRIPTORS (see job_table.hpp)
+#define arg_setup_aie_size    0
+#define arg_setup_aie_input   1
+#define arg_setup_aie_stats   (1 + SYSTEM_MEM_PORTS)
+#define arg_setup_aie_jobs    (1 + SYSTEM_MEM_PORTS + SYSTEM_MOVER_STATS)
+#define arg_sink_from_aie_output CU_PLIOS
+#define arg_sink_from_aie_size   (CU_PLIOS + SYSTEM_MEM_PORTS)
+#define arg_sink_from_aie_stats  (CU_PLIOS + SYSTEM_MEM_PORTS + 1)
+#define arg_sink_from_aie_produced (CU_PLIOS + SYSTEM_MEM_PORTS + 1 + SYSTEM_MOVER_STATS)
+#define arg_sink_from_aie_jobs   (CU_PLIOS + SYSTEM_MEM_PORTS + 1 + SYSTEM_MOVER_STATS + SYSTEM_FRAMED_OUTPUT)
+
+// Name that opens compute unit cu of a mover (see SYSTEM_COMPUTE_UNITS), e.g. "setup_aie:{setup_aie_1}". A kernel
+// opened by its plain name would start every run on any of its units, and setup_aie and sink_from_aie must work
+// on the same lanes
+inline std::string compute_unit(const std::string& kernel, int cu) {
+    return kernel + ":{" + kernel + "_" + std::to_string(cu) + "}";
+}
+
+inline std::ostream& bold_on(std::ostream& os)  { return os << "\e[1m"; }
+inline std::ostream& bold_off(std::ostream& os) { return os << "\e[0m"; }
+
+// The PL movers read and write 512-bit words, so every buffer (every slice, see striped_buffer.hpp) is padded
+// to a multiple of 64 bytes
+inline size_t padded_bytes(size_t elements) {
+    return ((elements * sizeof(data_t) + 63) / 64) * 64;
+}
+
+#endif // HOST_UTILS_HPP
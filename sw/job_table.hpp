@@ -0,0 +1,140 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Host side of the job descriptors of setup_aie and sink_from_aie (SYSTEM_JOB_DESCRIPTORS in
+// common/system_config.h, JOB_* fields in common/common.h). A job_table lays a list of jobs out in a pair of
+// striped buffers, one after the other in every slice, each starting on a 512-bit word and at the same place in
+// the input and in the output, and keeps their descriptors in one table per mover, in the bank of that mover. One
+// run of the movers then moves every job, each with its own lane headers, so many small requests share the cost
+// of a launch. Without job descriptors the table is never passed to the kernels. With SYSTEM_FREE_RUNNING the
+// descriptors are posted one by one to the command ring instead (see command_ring.hpp), and the jobs of a table
+// may start further in the buffers, which other tables share.
+#ifndef JOB_TABLE_HPP
+#define JOB_TABLE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+#include "../common/common.h"
+#include "host_utils.hpp"
+#include "striped_buffer.hpp"
+
+class job_table {
+public:
+    job_table() {}
+    // room for max_jobs descriptors, in the bank of the jobs argument of each mover
+    job_table(const xrt::device& device, const xrt::kernel& setup_aie, const xrt::kernel& sink_from_aie, size_t max_jobs)
+        : max_jobs(max_jobs) {
+        if (!SYSTEM_JOB_DESCRIPTORS) return;
+        const size_t bytes = std::max<size_t>(max_jobs, 1) * JOB_FIELDS * sizeof(uint32_t);
+        table_setup = xrt::bo(device, bytes, xrt::bo::flags::normal, setup_aie.group_id(arg_setup_aie_jobs));
+        table_sink  = xrt::bo(device, bytes, xrt::bo::flags::normal, sink_from_aie.group_id(arg_sink_from_aie_jobs));
+    }
+
+    // Empties the table, whose jobs then start at first_word of every slice
+    void clear(size_t first_word = 0) {
+        descriptors.clear();
+        first = first_word;
+        words = first_word;
+    }
+
+    // Appends a job of the given number of elements, a multiple of SYSTEM_SIZE_ALIGN. Returns its index
+    size_t add(size_t elements) {
+        if (jobs() == max_jobs)
+            throw std::runtime_error("job_table: more than " + std::to_string(max_jobs) + " jobs");
+        uint32_t descriptor[JOB_FIELDS] = {};
+        descriptor[JOB_INPUT]  = words;
+        descriptor[JOB_SIZE]   = elements;
+        descriptor[JOB_OUTPUT] = words;
+        descriptors.insert(descriptors.end(), descriptor, descriptor + JOB_FIELDS);
+        words += padded_bytes(striped_buffer::slice_size(elements)) / 64;
+        return jobs() - 1;
+    }
+
+    size_t jobs() const { return descriptors.size() / JOB_FIELDS; }
+    size_t elements(size_t job) const { return descriptors[job * JOB_FIELDS + JOB_SIZE]; }
+    const uint32_t* descriptor(size_t job) const { return descriptors.data() + job * JOB_FIELDS; }
+    // elements of a striped_buffer that holds every job, and of the run to sync, padding included
+    size_t capacity() const { return words * 64 / sizeof(data_t) * SYSTEM_MEM_PORTS; }
+
+    // First element of the slice of memory port p of a job, in a buffer laid out by the table
+    data_t* slice(const striped_buffer& buffer, size_t job, int p) const {
+        return buffer.slice(p) + (size_t) descriptors[job * JOB_FIELDS + JOB_INPUT] * 64 / sizeof(data_t);
+    }
+
+    // Copies n elements to the job, split across its slices, and zeroes the rest of the job
+    void write(striped_buffer& buffer, size_t job, const data_t* src, size_t n) const {
+        const size_t slice_elements = striped_buffer::slice_size(elements(job));
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+            const size_t first = std::min(n, p * slice_elements), len = std::min(n, first + slice_elements) - first;
+            data_t* dst = slice(buffer, job, p);
+            std::memcpy(dst, src + first, len * sizeof(data_t));
+            std::fill(dst + len, dst + slice_elements, 0);
+        }
+    }
+    // Copies the first n elements of the job out of its slices
+    void read(const striped_buffer& buffer, size_t job, data_t* dst, size_t n) const {
+        const size_t slice_elements = striped_buffer::slice_size(elements(job));
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+            const size_t first = std::min(n, p * slice_elements), len = std::min(n, first + slice_elements) - first;
+            std::memcpy(dst + first, slice(buffer, job, p), len * sizeof(data_t));
+        }
+    }
+
+    // Syncs the words of every slice that the jobs take, and only those
+    void sync(striped_buffer& buffer, xclBOSyncDirection direction) const {
+        buffer.sync_words(direction, first, words - first);
+    }
+
+    // Copies the descriptors to the device and passes them to a run of each mover, with the number of jobs as
+    // their size
+    void set_args(xrt::run& setup, xrt::run& sink) {
+        const size_t bytes = descriptors.size() * sizeof(uint32_t);
+        for (xrt::bo* table : {&table_setup, &table_sink}) {
+            if (!bytes) break;
+            table->write(descriptors.data(), bytes, 0);
+            table->sync(XCL_BO_SYNC_BO_TO_DEVICE, bytes, 0);
+        }
+        setup.set_arg(arg_setup_aie_size, (int32_t) jobs());
+        setup.set_arg(arg_setup_aie_jobs, table_setup);
+        sink.set_arg(arg_sink_from_aie_size, (int32_t) jobs());
+        sink.set_arg(arg_sink_from_aie_jobs, table_sink);
+    }
+
+private:
+    std::vector<uint32_t> descriptors; // JOB_FIELDS per job
+    size_t first = 0;                  // first 512-bit word of the jobs in every slice
+    size_t words = 0;                  // end of the jobs in every slice, in 512-bit words
+    size_t max_jobs = 0;
+    xrt::bo table_setup;
+    xrt::bo table_sink;
+};
+
+#endif // JOB_TABLE_HPP
@@ -0,0 +1,2 @@
+// Native functional model of XRT, see ../xrt_model.hpp
+#include "../xrt_model.hpp"
@@ -0,0 +1,790 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "xrt_model.hpp"
+#include "../../common/common.h"
+#include "../host_utils.hpp"
+#include "../spsc_queue.hpp"
+
+// memory ports of the model, SYSTEM_MEM_PORTS for each compute unit of the movers
+#define MODEL_PORTS (SYSTEM_COMPUTE_UNITS * SYSTEM_MEM_PORTS)
+// elements of an input (output) PLIO beat
+#define MODEL_IN_ELEMENTS (SYSTEM_PLIO_IN_WIDTH / SYSTEM_DATA_BITS)
+#define MODEL_OUT_ELEMENTS (SYSTEM_PLIO_OUT_WIDTH / SYSTEM_DATA_BITS)
+// beats of a kernel vector on the input (output) stream of a lane
+#define MODEL_BEATS_PER_VECTOR (SYSTEM_VECTOR_BITS / SYSTEM_PLIO_IN_WIDTH)
+#define MODEL_OUT_BEATS_PER_VECTOR (SYSTEM_VECTOR_BITS / SYSTEM_PLIO_OUT_WIDTH)
+// depth of the stream of each lane, in beats
+#define MODEL_STREAM_DEPTH 4096
+
+static_assert(SYSTEM_VECTOR_BITS % SYSTEM_PLIO_OUT_WIDTH == 0, "the model splits every output vector in whole output beats");
+
+struct beat_in { data_t e[MODEL_IN_ELEMENTS]; };
+struct beat_out {
+    data_t e[MODEL_OUT_ELEMENTS];
+    bool last; // TLAST: the trailer that ends the job of a lane, with SYSTEM_FRAMED_OUTPUT
+};
+
+using model_clock = std::chrono::steady_clock;
+
+// ---------------------------------------------------------------- buffers, runs
+
+struct xrt::bo::impl {
+    size_t size;
+    std::vector<char> owned; // host memory, unless the buffer wraps a user pointer
+    char* host;
+    std::vector<char> device;
+    std::mutex device_mutex;
+};
+
+struct xrt::run::impl {
+    std::string kernel;
+    int cu = 0; // compute unit of the kernel
+    std::vector<bo> buffers;
+    std::vector<int64_t> scalars;
+    std::mutex mutex;
+    std::condition_variable done;
+    ert_cmd_state state = ERT_CMD_STATE_NEW;
+    int pending = 0; // memory ports still working on the run
+};
+
+// one job of a run: its elements (negative for the shutdown run) and where its slice starts in the buffer of
+// every port, in bytes
+struct job_part {
+    int64_t size;
+    size_t offset;
+};
+
+// The command ring of a free-running run (SYSTEM_FREE_RUNNING), shared by the memory ports of the mover: every
+// port polls the head for the next job, and the last port done with a job completes it. The host syncs the ring
+// while the ports poll it, so its device copy is only touched under the device mutex of the buffer
+struct ring_state {
+    xrt::bo ring;
+    int64_t slots;
+    int offset_field;                // JOB_INPUT or JOB_OUTPUT
+    size_t buffer_bytes = SIZE_MAX;  // of the smallest buffer of the ports, that every job must fit
+    std::mutex mutex;
+    std::vector<uint32_t> port_done; // jobs each port is done with
+    uint32_t completed = 0;
+
+    ring_state(const xrt::bo& ring, int64_t slots, int offset_field)
+        : ring(ring), slots(slots), offset_field(offset_field), port_done(SYSTEM_MEM_PORTS, 0) {}
+
+    uint32_t* entry(int64_t e) const { return reinterpret_cast<uint32_t*>(ring.device_memory()) + e * JOB_FIELDS; }
+
+    // False until the host posted job n, then copies its command
+    bool poll(uint32_t n, uint32_t* command) const {
+        std::lock_guard<std::mutex> lock(ring.device_mutex());
+        if (entry(RING_HEAD)[0] == n) return false;
+        std::memcpy(command, entry(RING_COMMANDS + n % slots), JOB_FIELDS * sizeof(uint32_t));
+        return true;
+    }
+
+    // Port p (of the compute unit) is done with job n. Completes, in order, the jobs every port is done with: writes the record of each,
+    // then the tail. The command of a job stays in its slot until it completes, the record takes its size from there
+    void complete(int p, uint32_t n) {
+        std::lock_guard<std::mutex> lock(mutex);
+        port_done[p] = n + 1;
+        const uint32_t done = *std::min_element(port_done.begin(), port_done.end());
+        std::lock_guard<std::mutex> device(ring.device_mutex());
+        for (; completed != done; completed++) {
+            const uint32_t size = entry(RING_COMMANDS + completed % slots)[JOB_SIZE];
+            uint32_t* record = entry(RING_COMMANDS + slots + completed % slots);
+            std::fill(record, record + JOB_FIELDS, 0);
+            record[RING_DONE_JOB] = completed;
+            record[RING_DONE_SIZE] = size == RING_STOP ? 0 : size;
+        }
+        entry(RING_TAIL)[0] = completed;
+    }
+};
+
+// one run of a mover, as seen by one of its memory ports
+struct mover_job {
+    std::shared_ptr<xrt::run::impl> run;
+    std::shared_ptr<const std::vector<job_part>> parts; // the run itself, or its table with SYSTEM_JOB_DESCRIPTORS
+    char* memory = nullptr;
+    char* stats = nullptr; // null without SYSTEM_MOVER_STATS
+    char* produced = nullptr; // null without SYSTEM_FRAMED_OUTPUT
+    std::shared_ptr<ring_state> ring; // the jobs come from the ring instead, with SYSTEM_FREE_RUNNING
+};
+
+// what a mover did on one memory port, over the jobs of a run
+struct port_counters {
+    int64_t rounds = 0;
+    int64_t beats = 0;
+    int64_t words = 0;
+};
+
+// ---------------------------------------------------------------- runtime
+
+// Blocking queue of the jobs of a stage thread, closed when the model stops
+template <typename T>
+class job_queue {
+public:
+    void push(const T& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+        ready.notify_one();
+    }
+    // false once closed
+    bool pop(T& job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [&] { return !jobs.empty() || closed; });
+        if (jobs.empty()) return false;
+        job = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        ready.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<T> jobs;
+    bool closed = false;
+};
+
+// Time of a stage thread: everything but the waits is busy time
+struct stage_stats {
+    std::string name;
+    uint64_t beats = 0;
+    model_clock::duration wait_input{0};
+    model_clock::duration wait_output{0};
+    model_clock::time_point start, end;
+};
+
+// Spins, then yields, then sleeps: short waits stay cheap and idle stages do not burn a core
+class backoff {
+public:
+    void pause() {
+        if (++spins < 64) return;
+        if (spins < 16384) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+private:
+    int spins = 0;
+};
+
+class model_runtime {
+public:
+    static model_runtime& get() {
+        static model_runtime runtime;
+        return runtime;
+    }
+
+    // The port threads are numbered across the compute units: port g is port g % SYSTEM_MEM_PORTS of compute unit
+    // g / SYSTEM_MEM_PORTS, and serves lanes g * PORT_LANES on, as the compute units split the lanes in order
+    model_runtime() : stages(2 * MODEL_PORTS + NUM_LANES) {
+        for (int l = 0; l < NUM_LANES; l++) {
+            lane_in.emplace_back(new spsc_queue<beat_in>(MODEL_STREAM_DEPTH));
+            lane_out.emplace_back(new spsc_queue<beat_out>(MODEL_STREAM_DEPTH));
+        }
+        for (int g = 0; g < MODEL_PORTS; g++) {
+            const std::string port = (SYSTEM_COMPUTE_UNITS > 1 ? " cu " + std::to_string(g / SYSTEM_MEM_PORTS) : "") +
+                                     " port " + std::to_string(g % SYSTEM_MEM_PORTS);
+            stages[g].name = "setup_aie" + port;
+            stages[MODEL_PORTS + NUM_LANES + g].name = "sink_from_aie" + port;
+            threads.emplace_back(&model_runtime::setup_thread, this, g);
+            threads.emplace_back(&model_runtime::sink_thread, this, g);
+        }
+        for (int l = 0; l < NUM_LANES; l++) {
+            stages[MODEL_PORTS + l].name = "kernel lane " + std::to_string(l);
+            threads.emplace_back(&model_runtime::lane_thread, this, l);
+        }
+    }
+
+    ~model_runtime() {
+        stopping = true;
+        for (int g = 0; g < MODEL_PORTS; g++) {
+            setup_jobs[g].close();
+            sink_jobs[g].close();
+        }
+        for (int l = 0; l < NUM_LANES; l++)
+            rtp_iterations[l].close();
+        for (auto& t : threads)
+            t.join();
+        report();
+    }
+
+    // Queues a run of a mover on every memory port of its compute unit. Checks its arguments like the hardware cannot: a buffer
+    // smaller than its slices would be read or written out of bounds
+    void start(const std::shared_ptr<xrt::run::impl>& run) {
+        const bool setup = run->kernel == "setup_aie";
+        const int size_arg = setup ? arg_setup_aie_size : arg_sink_from_aie_size;
+        const int buffer_arg = setup ? arg_setup_aie_input : arg_sink_from_aie_output;
+        const int stats_arg = setup ? arg_setup_aie_stats : arg_sink_from_aie_stats;
+        const int jobs_arg = setup ? arg_setup_aie_jobs : arg_sink_from_aie_jobs;
+
+        const int64_t size = scalar(*run, size_arg);
+        if (size < 0 && !setup)
+            throw std::runtime_error("model: sink_from_aie size " + std::to_string(size) + " is negative");
+        // with job descriptors size counts the jobs of the table, otherwise the run is one job at the start of
+        // every slice. A free-running run has no jobs of its own: size counts the slots of its command ring
+        auto parts = std::make_shared<std::vector<job_part>>();
+        std::shared_ptr<ring_state> ring;
+        if (SYSTEM_FREE_RUNNING && size > 0) {
+            const xrt::bo& b = buffer(*run, jobs_arg);
+            if (size % RING_LINE != 0)
+                throw std::runtime_error("model: " + run->kernel + " ring of " + std::to_string(size) + " slots, not a multiple of " +
+                                         std::to_string(RING_LINE));
+            if (b.size() < RING_ENTRIES(size) * JOB_FIELDS * sizeof(uint32_t))
+                throw std::runtime_error("model: " + run->kernel + " command ring holds less than " + std::to_string(size) + " slots");
+            ring = std::make_shared<ring_state>(b, size, setup ? JOB_INPUT : JOB_OUTPUT);
+        }
+        else if (SYSTEM_JOB_DESCRIPTORS && size > 0) {
+            const xrt::bo& b = buffer(*run, jobs_arg);
+            if (b.size() < size * JOB_FIELDS * sizeof(uint32_t))
+                throw std::runtime_error("model: " + run->kernel + " job table holds less than " + std::to_string(size) + " jobs");
+            const uint32_t* table = reinterpret_cast<const uint32_t*>(b.device_memory());
+            for (int64_t j = 0; j < size; j++) {
+                const uint32_t* descriptor = table + j * JOB_FIELDS;
+                parts->push_back({descriptor[JOB_SIZE], (size_t) descriptor[setup ? JOB_INPUT : JOB_OUTPUT] * 64});
+            }
+        }
+        else if (!SYSTEM_JOB_DESCRIPTORS || size < 0) {
+            parts->push_back({size, 0});
+        }
+        size_t bytes = 0; // that every buffer must hold
+        for (const job_part& part : *parts) {
+            if (part.size >= 0 && part.size % SYSTEM_SIZE_ALIGN != 0)
+                throw std::runtime_error("model: " + run->kernel + " size " + std::to_string(part.size) + " is not a multiple of " +
+                                         std::to_string(SYSTEM_SIZE_ALIGN));
+            if (part.size > 0)
+                bytes = std::max(bytes, part.offset + padded_bytes(part.size / SYSTEM_MEM_PORTS));
+        }
+        // an empty run (or the shutdown run of setup_aie) does not touch its buffers, they may be unset. The jobs
+        // of a ring are checked against its buffers when they come
+        std::vector<char*> memory(SYSTEM_MEM_PORTS, nullptr);
+        for (int p = 0; p < SYSTEM_MEM_PORTS && (bytes > 0 || ring); p++) {
+            const xrt::bo& b = buffer(*run, buffer_arg + p);
+            if (b.size() < bytes)
+                throw std::runtime_error("model: " + run->kernel + " buffer of port " + std::to_string(p) + " holds " +
+                                         std::to_string(b.size()) + " bytes, the slices need " + std::to_string(bytes));
+            memory[p] = b.device_memory();
+            if (ring) ring->buffer_bytes = std::min(ring->buffer_bytes, b.size());
+        }
+        char* stats = nullptr;
+        if (SYSTEM_MOVER_STATS) {
+            const xrt::bo& b = buffer(*run, stats_arg);
+            if (b.size() < SYSTEM_MEM_PORTS * STATS_FIELDS * sizeof(uint64_t))
+                throw std::runtime_error("model: " + run->kernel + " stats buffer is too small");
+            stats = b.device_memory();
+        }
+        char* produced = nullptr;
+        if (SYSTEM_FRAMED_OUTPUT && !setup) {
+            const xrt::bo& b = buffer(*run, arg_sink_from_aie_produced);
+            if (b.size() < SYSTEM_MEM_PORTS * sizeof(uint64_t))
+                throw std::runtime_error("model: sink_from_aie produced buffer is too small");
+            produced = b.device_memory();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(run->mutex);
+            if (run->state == ERT_CMD_STATE_QUEUED || run->state == ERT_CMD_STATE_RUNNING)
+                throw std::runtime_error("model: " + run->kernel + " run started again before it completed");
+            run->state = ERT_CMD_STATE_RUNNING;
+            run->pending = SYSTEM_MEM_PORTS;
+        }
+        // every port sees the runs in the same order
+        std::lock_guard<std::mutex> lock(start_mutex);
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+            mover_job job{run, parts, memory[p], stats ? stats + p * STATS_FIELDS * sizeof(uint64_t) : nullptr,
+                          produced ? produced + p * sizeof(uint64_t) : nullptr, ring};
+            (setup ? setup_jobs : sink_jobs)[run->cu * SYSTEM_MEM_PORTS + p].push(job);
+        }
+    }
+
+    void update_iterations(int lane, int64_t iterations) {
+        rtp_iterations[lane].push(iterations);
+    }
+
+    // Waits for every kernel to return, i.e. to get the JOB_SHUTDOWN header
+    void wait_lanes() {
+        std::unique_lock<std::mutex> lock(lanes_mutex);
+        lanes_cv.wait(lock, [&] { return lanes_done == NUM_LANES; });
+    }
+
+private:
+    static int64_t scalar(const xrt::run::impl& run, int index) {
+        if (index >= (int) run.scalars.size())
+            throw std::runtime_error("model: " + run.kernel + " argument " + std::to_string(index) + " not set");
+        return run.scalars[index];
+    }
+
+    static const xrt::bo& buffer(const xrt::run::impl& run, int index) {
+        if (index >= (int) run.buffers.size() || !run.buffers[index].size())
+            throw std::runtime_error("model: " + run.kernel + " buffer argument " + std::to_string(index) + " not set");
+        return run.buffers[index];
+    }
+
+    // Blocks on try() with a backoff, adding the time to waited. False if the model stops meanwhile
+    template <typename F>
+    bool wait_for(F try_once, model_clock::duration& waited) {
+        if (try_once()) return true;
+        const auto t0 = model_clock::now();
+        backoff b;
+        while (!try_once()) {
+            if (stopping) return false;
+            b.pause();
+        }
+        waited += model_clock::now() - t0;
+        return true;
+    }
+
+    template <typename T>
+    bool pop_job(job_queue<T>& queue, T& job, stage_stats& stage) {
+        const auto t0 = model_clock::now();
+        const bool ok = queue.pop(job);
+        stage.wait_input += model_clock::now() - t0;
+        return ok;
+    }
+
+    static void write_record(char* stats, uint64_t rounds, uint64_t beats, uint64_t words) {
+        // an ideal mover: one round per cycle, no stalls
+        uint64_t record[STATS_FIELDS] = {};
+        record[STATS_CYCLES] = rounds;
+        record[STATS_BEATS] = beats;
+        record[STATS_FIRST_BEAT] = rounds ? 1 : 0;
+        record[STATS_LAST_BEAT] = rounds;
+        record[STATS_WORDS] = words;
+        std::memcpy(stats, record, sizeof(record));
+    }
+
+    static void complete(const mover_job& job) {
+        std::lock_guard<std::mutex> lock(job.run->mutex);
+        if (--job.run->pending == 0) {
+            job.run->state = ERT_CMD_STATE_COMPLETED;
+            job.run->done.notify_all();
+        }
+    }
+
+    // Serves the command ring of a free-running run on memory port g: moves every job the host posts with
+    // move_part, like a run of that job, and completes it, until the stop command. Like start() it checks every job
+    // against the buffers, but from the port thread, so a bad job ends the model. False if the model stops meanwhile
+    template <typename F>
+    bool serve_ring(const mover_job& job, int g, stage_stats& stage, F move_part) {
+        ring_state& ring = *job.ring;
+        uint32_t command[JOB_FIELDS];
+        for (uint32_t n = 0;; n++) {
+            if (!wait_for([&] { return ring.poll(n, command); }, stage.wait_input)) return false;
+            if (command[JOB_SIZE] == RING_STOP) {
+                ring.complete(g % SYSTEM_MEM_PORTS, n);
+                return true;
+            }
+            const job_part part{command[JOB_SIZE], (size_t) command[ring.offset_field] * 64};
+            if (part.size % SYSTEM_SIZE_ALIGN != 0 || part.offset + padded_bytes(part.size / SYSTEM_MEM_PORTS) > ring.buffer_bytes) {
+                std::cerr << "model: " << job.run->kernel << " job " << n << " of " << part.size << " elements at word "
+                          << part.offset / 64 << " is not aligned or does not fit its buffers" << std::endl;
+                std::abort();
+            }
+            if (!move_part(part)) return false;
+            ring.complete(g % SYSTEM_MEM_PORTS, n);
+        }
+    }
+
+    // setup_aie of memory port g on one job: the lane headers, then the beats of its slice round-robin to the lanes
+    bool setup_part(int g, const job_part& part, const char* memory, stage_stats& stage, port_counters& count) {
+        bool ok = true;
+        const bool shutdown = part.size < 0;
+        const int64_t part_beats = shutdown ? 0 : part.size / SYSTEM_MEM_PORTS / MODEL_IN_ELEMENTS;
+        for (int h = 0; ok && SYSTEM_STREAM_HEADER && h < MODEL_BEATS_PER_VECTOR; h++) {
+            for (int l = 0; ok && l < PORT_LANES; l++) {
+                const int lane = g * PORT_LANES + l;
+                beat_in header = {};
+                const int32_t value = shutdown ? JOB_SHUTDOWN : lane_iterations(part.size, lane);
+                if (h == 0) std::memcpy(header.e, &value, sizeof(value));
+                ok = wait_for([&] { return lane_in[lane]->try_push(header); }, stage.wait_output);
+            }
+        }
+        const beat_in* input = reinterpret_cast<const beat_in*>(memory + part.offset);
+        for (int64_t b = 0; ok && b < part_beats; b++) {
+            const int lane = g * PORT_LANES + b % PORT_LANES;
+            ok = wait_for([&] { return lane_in[lane]->try_push(input[b]); }, stage.wait_output);
+        }
+        if (!ok) return false;
+        count.rounds += (part_beats + PORT_LANES - 1) / PORT_LANES;
+        count.beats += part_beats;
+        count.words += padded_bytes(part_beats * MODEL_IN_ELEMENTS) / 64;
+        return true;
+    }
+
+    // setup_aie of memory port g: every job of the run (or of its ring) through setup_part()
+    void setup_thread(int g) {
+        stage_stats& stage = stages[g];
+        stage.start = model_clock::now();
+        mover_job job;
+        while (pop_job(setup_jobs[g], job, stage)) {
+            bool ok = true;
+            port_counters count;
+            if (job.ring)
+                ok = serve_ring(job, g, stage, [&](const job_part& part) { return setup_part(g, part, job.memory, stage, count); });
+            for (size_t j = 0; ok && j < job.parts->size(); j++)
+                ok = setup_part(g, (*job.parts)[j], job.memory, stage, count);
+            if (!ok) break;
+            stage.beats += count.beats;
+            if (job.stats)
+                write_record(job.stats, count.rounds, count.beats, count.words);
+            complete(job);
+        }
+        stage.end = model_clock::now();
+    }
+
+    // The kernel of lane l: gets the iterations of each job from its header (or from its RTP), then runs
+    // compute_model() on each input vector. Without either it processes vectors until the model stops. With
+    // SYSTEM_FRAMED_OUTPUT it sends only the vectors compute_model() keeps, and a trailer beat after each job
+    void lane_thread(int l) {
+        stage_stats& stage = stages[MODEL_PORTS + l];
+        stage.start = model_clock::now();
+        data_t input[MODEL_VECTOR_ELEMENTS], output[MODEL_VECTOR_ELEMENTS];
+        beat_in in;
+        bool ok = true;
+        while (ok) {
+            int64_t iterations = -1;
+            if (SYSTEM_STREAM_HEADER) {
+                for (int h = 0; ok && h < MODEL_BEATS_PER_VECTOR; h++) {
+                    ok = wait_for([&] { return lane_in[l]->try_pop(in); }, stage.wait_input);
+                    if (h == 0) {
+                        int32_t value;
+                        std::memcpy(&value, in.e, sizeof(value));
+                        iterations = value;
+                    }
+                }
+                if (!ok) break;
+                if (iterations == JOB_SHUTDOWN) {
+                    std::lock_guard<std::mutex> lock(lanes_mutex);
+                    lanes_done++;
+                    lanes_cv.notify_all();
+                    // a persistent kernel returns, the graph is done with this lane
+                    if (SYSTEM_PERSISTENT_GRAPH) break;
+                    continue;
+                }
+            }
+            else if (SYSTEM_RTP_ITERATIONS) {
+                const auto t0 = model_clock::now();
+                ok = rtp_iterations[l].pop(iterations);
+                stage.wait_input += model_clock::now() - t0;
+                if (!ok) break;
+            }
+            for (int64_t i = 0; ok && (iterations < 0 || i < iterations); i++) {
+                for (int b = 0; ok && b < MODEL_BEATS_PER_VECTOR; b++) {
+                    ok = wait_for([&] { return lane_in[l]->try_pop(in); }, stage.wait_input);
+                    std::memcpy(input + b * MODEL_IN_ELEMENTS, in.e, sizeof(in.e));
+                }
+                if (!ok) break;
+                stage.beats += MODEL_BEATS_PER_VECTOR;
+                const bool keep = compute_model(input, output, l) || !SYSTEM_FRAMED_OUTPUT;
+                for (int b = 0; ok && keep && b < MODEL_OUT_BEATS_PER_VECTOR; b++) {
+                    beat_out out;
+                    std::memcpy(out.e, output + b * MODEL_OUT_ELEMENTS, sizeof(out.e));
+                    out.last = false;
+                    ok = wait_for([&] { return lane_out[l]->try_push(out); }, stage.wait_output);
+                }
+            }
+            if (ok && SYSTEM_FRAMED_OUTPUT) {
+                beat_out trailer = {};
+                trailer.last = true;
+                ok = wait_for([&] { return lane_out[l]->try_push(trailer); }, stage.wait_output);
+            }
+        }
+        stage.end = model_clock::now();
+    }
+
+    // sink_from_aie of memory port g on one job: collects the lanes of the port round-robin into its slice. With
+    // SYSTEM_FRAMED_OUTPUT the round-robin skips the lanes that sent their trailer, the slice is the capacity (what
+    // does not fit is counted, not written) and the port writes the elements it got to produced
+    bool sink_part(int g, const job_part& part, char* memory, char* produced, stage_stats& stage, port_counters& count) {
+        bool ok = true;
+        beat_out beat;
+        const int64_t capacity = part.size / SYSTEM_MEM_PORTS / MODEL_OUT_ELEMENTS;
+        char* output = memory + part.offset;
+        int64_t part_beats = 0;
+        std::vector<bool> open(PORT_LANES, true);
+        int open_lanes = SYSTEM_FRAMED_OUTPUT ? PORT_LANES : 0;
+        for (int l = 0; ok && (SYSTEM_FRAMED_OUTPUT ? open_lanes > 0 : part_beats < capacity); l = (l + 1) % PORT_LANES) {
+            if (!open[l]) continue;
+            ok = wait_for([&] { return lane_out[g * PORT_LANES + l]->try_pop(beat); }, stage.wait_input);
+            if (ok && SYSTEM_FRAMED_OUTPUT && beat.last) {
+                open[l] = false;
+                open_lanes--;
+            } else if (ok) {
+                if (part_beats < capacity)
+                    std::memcpy(output + part_beats * sizeof(beat.e), beat.e, sizeof(beat.e));
+                part_beats++;
+            }
+        }
+        if (!ok) return false;
+        if (produced) {
+            const uint64_t elements = part_beats * MODEL_OUT_ELEMENTS;
+            std::memcpy(produced, &elements, sizeof(elements));
+        }
+        part_beats = std::min(part_beats, capacity);
+        count.rounds += (part_beats + PORT_LANES - 1) / PORT_LANES;
+        count.beats += part_beats;
+        count.words += padded_bytes(part_beats * MODEL_OUT_ELEMENTS) / 64;
+        return true;
+    }
+
+    // sink_from_aie of memory port g: every job of the run (or of its ring) through sink_part()
+    void sink_thread(int g) {
+        stage_stats& stage = stages[MODEL_PORTS + NUM_LANES + g];
+        stage.start = model_clock::now();
+        mover_job job;
+        while (pop_job(sink_jobs[g], job, stage)) {
+            bool ok = true;
+            port_counters count;
+            if (job.ring)
+                ok = serve_ring(job, g, stage, [&](const job_part& part) { return sink_part(g, part, job.memory, job.produced, stage, count); });
+            for (size_t j = 0; ok && j < job.parts->size(); j++)
+                ok = sink_part(g, (*job.parts)[j], job.memory, job.produced, stage, count);
+            if (!ok) break;
+            stage.beats += count.beats;
+            if (job.stats)
+                write_record(job.stats, count.rounds, count.beats, count.words);
+            complete(job);
+        }
+        stage.end = model_clock::now();
+    }
+
+    // Where the time of every stage went: the busiest stage bounds the throughput of the model
+    void report() const {
+        uint64_t total = 0;
+        for (const auto& s : stages) total += s.beats;
+        if (!total) return;
+        std::cerr << "model: " << std::left << std::setw(26) << "stage" << std::right << std::setw(14) << "beats"
+                  << std::setw(8) << "busy" << std::setw(12) << "wait input" << std::setw(12) << "wait output" << std::endl;
+        for (const auto& s : stages) {
+            const double life = std::chrono::duration<double>(s.end - s.start).count();
+            const double in = std::chrono::duration<double>(s.wait_input).count();
+            const double out = std::chrono::duration<double>(s.wait_output).count();
+            auto percent = [&](double t) { return life > 0 ? 100.0 * t / life : 0.0; };
+            std::cerr << "model: " << std::left << std::setw(26) << s.name << std::right << std::setw(14) << s.beats
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(7) << percent(std::max(0.0, life - in - out)) << "%"
+                      << std::setw(11) << percent(in) << "%" << std::setw(11) << percent(out) << "%" << std::endl;
+        }
+    }
+
+    std::atomic<bool> stopping{false};
+    std::vector<stage_stats> stages; // setup_aie ports, lanes, sink_from_aie ports
+    std::vector<std::unique_ptr<spsc_queue<beat_in>>> lane_in;
+    std::vector<std::unique_ptr<spsc_queue<beat_out>>> lane_out;
+    std::mutex start_mutex;
+    job_queue<mover_job> setup_jobs[MODEL_PORTS];
+    job_queue<mover_job> sink_jobs[MODEL_PORTS];
+    job_queue<int64_t> rtp_iterations[NUM_LANES];
+    std::mutex lanes_mutex;
+    std::condition_variable lanes_cv;
+    int lanes_done = 0;
+    std::vector<std::thread> threads;
+};
+
+// ---------------------------------------------------------------- API
+
+namespace xrt {
+
+device::device(unsigned int /*index*/) {
+    model_runtime::get();
+}
+
+uuid device::load_xclbin(const std::string& file) {
+    std::cerr << "model: native functional model, " << file << " is not loaded" << std::endl;
+    return uuid();
+}
+
+bo::bo(const device& /*device*/, size_t size, flags /*flags*/, memory_group /*group*/) : p(std::make_shared<impl>()) {
+    p->size = size;
+    p->owned.resize(size);
+    p->host = p->owned.data();
+    p->device.resize(size);
+}
+
+bo::bo(const device& /*device*/, void* userptr, size_t size, memory_group /*group*/) : p(std::make_shared<impl>()) {
+    p->size = size;
+    p->host = static_cast<char*>(userptr);
+    p->device.resize(size);
+}
+
+bo::bo(const device& device, void* userptr, size_t size, flags /*flags*/, memory_group group) : bo(device, userptr, size, group) {}
+
+size_t bo::size() const {
+    return p ? p->size : 0;
+}
+
+uint64_t bo::address() const {
+    return reinterpret_cast<uint64_t>(p->device.data());
+}
+
+char* bo::host() const {
+    return p->host;
+}
+
+char* bo::device_memory() const {
+    return p->device.data();
+}
+
+std::mutex& bo::device_mutex() const {
+    return p->device_mutex;
+}
+
+void bo::write(const void* src, size_t size, size_t seek) {
+    if (seek + size > p->size) throw std::out_of_range("model: bo::write out of bounds");
+    std::memcpy(p->host + seek, src, size);
+}
+
+void bo::read(void* dst, size_t size, size_t skip) {
+    if (skip + size > p->size) throw std::out_of_range("model: bo::read out of bounds");
+    std::memcpy(dst, p->host + skip, size);
+}
+
+void bo::sync(xclBOSyncDirection direction, size_t size, size_t offset) {
+    if (offset + size > p->size) throw std::out_of_range("model: bo::sync out of bounds");
+    std::lock_guard<std::mutex> lock(p->device_mutex);
+    if (direction == XCL_BO_SYNC_BO_TO_DEVICE)
+        std::memcpy(p->device.data() + offset, p->host + offset, size);
+    else
+        std::memcpy(p->host + offset, p->device.data() + offset, size);
+}
+
+// the compute unit is the index in "{name_N}", a name without compute units runs on the first one
+kernel::kernel(const device& /*device*/, const uuid& /*xclbin_uuid*/, const std::string& name) : name(name.substr(0, name.find(':'))) {
+    if (this->name != "setup_aie" && this->name != "sink_from_aie")
+        throw std::runtime_error("model: no kernel " + this->name + " in the model");
+    const std::string unit = "{" + this->name + "_";
+    const size_t at = name.find(unit);
+    if (at != std::string::npos)
+        cu = std::atoi(name.c_str() + at + unit.size());
+    if (cu < 0 || cu >= SYSTEM_COMPUTE_UNITS)
+        throw std::runtime_error("model: no compute unit " + name + ", the movers have " + std::to_string(SYSTEM_COMPUTE_UNITS));
+}
+
+run::run(const kernel& kernel) : p(std::make_shared<impl>()) {
+    p->kernel = kernel.get_name();
+    p->cu = kernel.compute_unit();
+}
+
+// Arguments of the movers in the order of their signatures (fpga/setup_aie.hpp and fpga/sink_from_aie.hpp), where
+// every stream counts as an argument: 'b' a buffer, 's' a scalar, 'x' a stream. The host binds the arguments by
+// index (host_utils.hpp), so a buffer or a scalar on the wrong index is caught here, as XRT would
+static const std::string& argument_kinds(const std::string& kernel) {
+    auto layout = [](std::initializer_list<std::pair<char, int>> groups) {
+        std::string kinds;
+        for (const auto& g : groups) kinds.append(g.second, g.first);
+        return kinds;
+    };
+    const int jobs = SYSTEM_JOB_DESCRIPTORS || SYSTEM_FREE_RUNNING;
+    static const std::string setup = layout({{'s', 1}, {'b', SYSTEM_MEM_PORTS}, {'b', SYSTEM_MOVER_STATS}, {'b', jobs},
+                                             {'x', CU_PLIOS}});
+    static const std::string sink = layout({{'x', CU_PLIOS}, {'b', SYSTEM_MEM_PORTS}, {'s', 1}, {'b', SYSTEM_MOVER_STATS},
+                                            {'b', SYSTEM_FRAMED_OUTPUT}, {'b', jobs}});
+    return kernel == "setup_aie" ? setup : sink;
+}
+
+static void check_argument(const std::string& kernel, int index, char kind) {
+    const std::string& kinds = argument_kinds(kernel);
+    if (index < 0 || index >= (int) kinds.size() || kinds[index] != kind)
+        throw std::runtime_error("model: argument " + std::to_string(index) + " of " + kernel + " is not a " +
+                                 (kind == 'b' ? "buffer" : "scalar"));
+}
+
+void run::set_arg(int index, const bo& buffer) {
+    check_argument(p->kernel, index, 'b');
+    if (index >= (int) p->buffers.size()) p->buffers.resize(index + 1);
+    p->buffers[index] = buffer;
+}
+
+void run::set_scalar(int index, int64_t value) {
+    check_argument(p->kernel, index, 's');
+    if (index >= (int) p->scalars.size()) p->scalars.resize(index + 1);
+    p->scalars[index] = value;
+}
+
+void run::start() {
+    model_runtime::get().start(p);
+}
+
+ert_cmd_state run::wait(const std::chrono::milliseconds& timeout) const {
+    std::unique_lock<std::mutex> lock(p->mutex);
+    auto done = [&] { return p->state != ERT_CMD_STATE_RUNNING; };
+    if (timeout.count() == 0)
+        p->done.wait(lock, done);
+    else
+        p->done.wait_for(lock, timeout, done);
+    return p->state;
+}
+
+ert_cmd_state run::state() const {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    return p->state;
+}
+
+graph::graph(const device& /*device*/, const uuid& /*xclbin_uuid*/, const std::string& name) : name(name) {}
+
+void graph::run(int /*iterations*/) {
+    if (running) throw std::runtime_error("model: graph " + name + " is already running");
+    running = true;
+}
+
+void graph::wait(std::chrono::milliseconds /*timeout*/) {
+    model_runtime::get().wait_lanes();
+    running = false;
+}
+
+void graph::end(uint64_t /*cycles*/) {
+    running = false;
+}
+
+void graph::update_int(const std::string& port, int64_t value) {
+    const std::string prefix = name + ".iterations[";
+    if (port.compare(0, prefix.size(), prefix) != 0) return;
+    const int lane = std::stoi(port.substr(prefix.size()));
+    if (lane < 0 || lane >= NUM_LANES) throw std::runtime_error("model: no RTP port " + port);
+    model_runtime::get().update_iterations(lane, value);
+}
+
+namespace system {
+
+size_t enumerate_devices() {
+    return 1;
+}
+
+} // namespace system
+
+} // namespace xrt
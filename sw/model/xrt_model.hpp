@@ -0,0 +1,209 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Native functional model of the whole system, behind the subset of the XRT native API used by the host code.
+// Built with plain g++ (see build_model in sw/Makefile), the host executables run unchanged on it:
+// - setup_aie: one thread per memory port of every compute unit, that deals the beats of its slice (with the lane
+//   headers) to the PORT_LANES lanes of the port, exactly as fpga/setup_aie.cpp does (job by job, with
+//   SYSTEM_JOB_DESCRIPTORS)
+// - the AIE graph: one thread per lane, that runs compute_model() (model/compute_model.cpp) on every vector
+// - sink_from_aie: one thread per memory port, that collects the lanes back into its slice of the output (with
+//   SYSTEM_FRAMED_OUTPUT, until the trailer of every lane, writing the produced counts)
+// - with SYSTEM_FREE_RUNNING, a run of either mover serves its command ring instead: its port threads poll the
+//   head in the device copy of the ring and complete every job there, until the stop command
+// The stages are connected by bounded lock-free SPSC queues of PLIO beats (spsc_queue.hpp). Buffers have a host
+// and a device copy, so a missing sync shows up as a wrong result, and runs complete asynchronously like on the
+// device. At exit the model prints, for every stage, how long it was busy and how long it waited for its input
+// or for room on its output, i.e. which stage bounds the throughput.
+// It is a functional model: the AIE kernel is compute_model(), not the code in aie/src, and there is no timing.
+#ifndef XRT_MODEL_HPP
+#define XRT_MODEL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../../common/constants.h"
+
+// Elements of one kernel vector, the unit of work of compute_model()
+#define MODEL_VECTOR_ELEMENTS (SYSTEM_VECTOR_BITS / SYSTEM_DATA_BITS)
+
+// Functional model of one kernel iteration of the given lane: MODEL_VECTOR_ELEMENTS elements in, as many out.
+// With SYSTEM_FRAMED_OUTPUT returning false drops the output vector, like compute_function() in aie/src; otherwise
+// the result is ignored
+bool compute_model(const data_t* input, data_t* output, int lane);
+
+enum xclBOSyncDirection {
+    XCL_BO_SYNC_BO_TO_DEVICE = 0,
+    XCL_BO_SYNC_BO_FROM_DEVICE = 1,
+};
+
+enum ert_cmd_state {
+    ERT_CMD_STATE_NEW = 1,
+    ERT_CMD_STATE_QUEUED = 2,
+    ERT_CMD_STATE_RUNNING = 3,
+    ERT_CMD_STATE_COMPLETED = 4,
+    ERT_CMD_STATE_ERROR = 5,
+};
+
+typedef uint32_t xrtMemoryGroup;
+
+namespace xrt {
+
+using memory_group = xrtMemoryGroup;
+
+class uuid {};
+
+class xclbin {
+public:
+    class mem {
+    public:
+        mem(const std::string& tag, int32_t index) : tag(tag), index(index) {}
+        std::string get_tag() const { return tag; }
+        int32_t get_index() const { return index; }
+        bool get_used() const { return true; }
+
+    private:
+        std::string tag;
+        int32_t index;
+    };
+
+    xclbin() {}
+    explicit xclbin(const std::string& file) : file(file) {}
+    // the memory of the model shows up as a DDR and a host bank, both of them reach every argument
+    std::vector<mem> get_mems() const { return {mem("DDR[0]", 0), mem("HOST[0]", 1)}; }
+    const std::string& get_path() const { return file; }
+    explicit operator bool() const { return !file.empty(); }
+
+private:
+    std::string file;
+};
+
+class device {
+public:
+    device() {}
+    // starts the model threads on first use
+    explicit device(unsigned int index);
+    uuid load_xclbin(const std::string& file);
+    uuid load_xclbin(const xclbin& xclbin) { return load_xclbin(xclbin.get_path()); }
+    uuid get_xclbin_uuid() const { return uuid(); }
+};
+
+class bo {
+public:
+    enum class flags : uint32_t { normal = 0, cacheable = 1 << 24, device_only = 2 << 24, host_only = 4 << 24, p2p = 8 << 24, svm = 16 << 24 };
+
+    bo() {}
+    bo(const device& device, size_t size, flags flags, memory_group group);
+    bo(const device& device, void* userptr, size_t size, memory_group group);
+    bo(const device& device, void* userptr, size_t size, flags flags, memory_group group);
+
+    size_t size() const;
+    uint64_t address() const;
+    template <typename T>
+    T map() { return reinterpret_cast<T>(host()); }
+    void write(const void* src, size_t size, size_t seek);
+    void write(const void* src) { write(src, size(), 0); }
+    void read(void* dst, size_t size, size_t skip);
+    void read(void* dst) { read(dst, size(), 0); }
+    void sync(xclBOSyncDirection direction, size_t size, size_t offset);
+    void sync(xclBOSyncDirection direction) { sync(direction, size(), 0); }
+
+    // the device copy, that the model kernels read and write
+    char* device_memory() const;
+    // held while the device copy is synced, for the kernels that poll it (the free-running movers)
+    std::mutex& device_mutex() const;
+
+private:
+    struct impl;
+    char* host() const;
+    std::shared_ptr<impl> p;
+};
+
+class kernel {
+public:
+    kernel() {}
+    // name may carry the compute units, e.g. "setup_aie:{setup_aie_0}"
+    kernel(const device& device, const uuid& xclbin_uuid, const std::string& name);
+    // the model has a single memory, every argument is in group 0
+    int group_id(int /*arg*/) const { return 0; }
+    const std::string& get_name() const { return name; }
+    int compute_unit() const { return cu; }
+
+private:
+    std::string name;
+    int cu = 0;
+};
+
+class run {
+public:
+    struct impl;
+
+    run() {}
+    explicit run(const kernel& kernel);
+
+    void set_arg(int index, const bo& buffer);
+    template <typename T>
+    void set_arg(int index, T value) { set_scalar(index, (int64_t) value); }
+
+    void start();
+    ert_cmd_state wait(const std::chrono::milliseconds& timeout = std::chrono::milliseconds(0)) const;
+    ert_cmd_state state() const;
+
+private:
+    void set_scalar(int index, int64_t value);
+    std::shared_ptr<impl> p;
+};
+
+class graph {
+public:
+    graph(const device& device, const uuid& xclbin_uuid, const std::string& name);
+    // the model kernels serve every job on their own, run() only checks that the graph is not running yet
+    void run(int iterations);
+    // waits for every lane to have received the JOB_SHUTDOWN header (persistent graph)
+    void wait(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+    void end(uint64_t cycles = 0);
+    // the iterations RTP of a lane goes to its kernel, the values of the other parameters are ignored
+    template <typename T>
+    void update(const std::string& port, T value) { update_int(port, (int64_t) value); }
+
+private:
+    void update_int(const std::string& port, int64_t value);
+    std::string name;
+    bool running = false;
+};
+
+namespace system {
+
+// the model is a single device
+size_t enumerate_devices();
+
+} // namespace system
+
+} // namespace xrt
+
+#endif // XRT_MODEL_HPP
@@ -0,0 +1,100 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Host side of the performance counters of setup_aie and sink_from_aie (SYSTEM_MOVER_STATS in
+// common/system_config.h, STATS_* fields in common/common.h). A mover_stats_buffer is the stats argument of one
+// mover run: with the counters enabled every run needs one, otherwise the kernel has no such argument and the
+// buffer does nothing. After the run completed, collect() adds its counters to a mover_stats, which prints for
+// every memory port how busy the port was, where it stalled and the bandwidth it achieved.
+#ifndef MOVER_STATS_HPP
+#define MOVER_STATS_HPP
+
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+#include "../common/common.h"
+
+// Counters of a mover, summed over its runs
+struct mover_stats {
+    uint64_t total[SYSTEM_MEM_PORTS][STATS_FIELDS] = {};
+    uint64_t last[SYSTEM_MEM_PORTS][STATS_FIELDS] = {}; // counters of the last run collected
+    int runs = 0;
+
+    // clock_mhz is the clock of the movers, to turn cycles into time
+    void print(std::ostream& os, const std::string& name, double clock_mhz) const {
+        if (!SYSTEM_MOVER_STATS || runs == 0) return;
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++) {
+            const uint64_t* t = total[p];
+            const double cycles = t[STATS_CYCLES] ? (double) t[STATS_CYCLES] : 1.0;
+            const double seconds = cycles / (clock_mhz * 1e6);
+            os << name << " port " << p << ": " << runs << " runs, " << t[STATS_CYCLES] << " cycles, " << t[STATS_BEATS] << " beats ("
+               << std::fixed << std::setprecision(1)
+               << 100.0 * t[STATS_BEATS] / (cycles * PORT_LANES) << "% of " << PORT_LANES << " beats per cycle), stalled "
+               << 100.0 * t[STATS_STALL_STREAM] / cycles << "% on the AIE streams and "
+               << 100.0 * t[STATS_STALL_MEMORY] / cycles << "% on memory, "
+               << std::setprecision(2) << t[STATS_WORDS] * 64.0 / seconds / 1e9 << " GB/s at " << std::defaultfloat << clock_mhz << " MHz"
+               << std::endl;
+            os << "    last run: first beat at cycle " << last[p][STATS_FIRST_BEAT] << ", last beat at cycle " << last[p][STATS_LAST_BEAT] << std::endl;
+        }
+    }
+};
+
+class mover_stats_buffer {
+public:
+    mover_stats_buffer() {}
+    // buffer of argument arg of the kernel, in the bank of that argument
+    mover_stats_buffer(const xrt::device& device, const xrt::kernel& kernel, int arg) : arg(arg) {
+        if (SYSTEM_MOVER_STATS)
+            buffer = xrt::bo(device, SYSTEM_MEM_PORTS * STATS_FIELDS * sizeof(uint64_t), xrt::bo::flags::normal, kernel.group_id(arg));
+    }
+
+    void set_arg(xrt::run& run) const {
+        if (SYSTEM_MOVER_STATS)
+            run.set_arg(arg, buffer);
+    }
+
+    // to be called once the run completed
+    void collect(mover_stats& stats) {
+        if (!SYSTEM_MOVER_STATS) return;
+        uint64_t record[SYSTEM_MEM_PORTS][STATS_FIELDS];
+        buffer.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+        buffer.read(record);
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+            for (int f = 0; f < STATS_FIELDS; f++) {
+                stats.total[p][f] += record[p][f];
+                stats.last[p][f] = record[p][f];
+            }
+        stats.runs++;
+    }
+
+private:
+    xrt::bo buffer;
+    int arg = 0;
+};
+
+#endif // MOVER_STATS_HPP
@@ -0,0 +1,79 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Lock-free multi-producer single-consumer queue (Vyukov's node-based queue).
+// push() is wait-free and can be called from any thread, pop() must be called by one consumer thread only.
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <utility>
+
+template <typename T>
+class mpsc_queue {
+public:
+    mpsc_queue() : head(new node()), tail(head.load(std::memory_order_relaxed)) {}
+
+    ~mpsc_queue() {
+        T dropped;
+        while (pop(dropped)) {}
+        delete tail;
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    void push(T value) {
+        node* n = new node(std::move(value));
+        node* prev = head.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    // Returns false if the queue is empty (or a push is still linking its node)
+    bool pop(T& value) {
+        node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) return false;
+        value = std::move(next->value);
+        delete tail;
+        tail = next; // next becomes the new stub
+        return true;
+    }
+
+    bool empty() const {
+        return tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct node {
+        node() : next(nullptr) {}
+        explicit node(T&& value) : next(nullptr), value(std::move(value)) {}
+        std::atomic<node*> next;
+        T value;
+    };
+
+    std::atomic<node*> head; // last pushed node, shared by the producers
+    node* tail;              // stub node, owned by the consumer
+};
+
+#endif // MPSC_QUEUE_HPP
@@ -0,0 +1,71 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Host side of the framed output of sink_from_aie (SYSTEM_FRAMED_OUTPUT in common/system_config.h). A framed
+// sink writes, on every memory port, only what the lanes of that port produced before their TLAST, and reports
+// the count in the produced argument. A produced_buffer is that argument for one run: with framed output every run
+// of the sink needs one, otherwise the kernel has no such argument and every port produces its whole slice.
+#ifndef PRODUCED_BUFFER_HPP
+#define PRODUCED_BUFFER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+#include "striped_buffer.hpp"
+
+class produced_buffer {
+public:
+    produced_buffer() {}
+    // buffer of argument arg of the kernel, in the bank of that argument
+    produced_buffer(const xrt::device& device, const xrt::kernel& kernel, int arg) : arg(arg) {
+        if (SYSTEM_FRAMED_OUTPUT)
+            buffer = xrt::bo(device, SYSTEM_MEM_PORTS * sizeof(uint64_t), xrt::bo::flags::normal, kernel.group_id(arg));
+    }
+
+    void set_arg(xrt::run& run) const {
+        if (SYSTEM_FRAMED_OUTPUT)
+            run.set_arg(arg, buffer);
+    }
+
+    // Elements produced by every port in a run of the given size, to be called once the run completed. A framed
+    // port may report more than its slice: what did not fit was dropped by the sink
+    std::vector<size_t> counts(size_t elements) {
+        std::vector<size_t> result(SYSTEM_MEM_PORTS, striped_buffer::slice_size(elements));
+        if (!SYSTEM_FRAMED_OUTPUT) return result;
+        uint64_t produced[SYSTEM_MEM_PORTS];
+        buffer.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+        buffer.read(produced);
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+            result[p] = produced[p];
+        return result;
+    }
+
+private:
+    xrt::bo buffer;
+    int arg = 0;
+};
+
+#endif // PRODUCED_BUFFER_HPP
@@ -0,0 +1,265 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "scale_out.hpp"
+#include "host_utils.hpp"
+#include "experimental/xrt_system.h"
+#include <algorithm>
+#include <exception>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace voted {
+
+// Each chunk starts on a multiple of SYSTEM_SIZE_ALIGN elements, the movers take no other size
+static size_t beat_aligned(size_t elements) {
+    return (elements + SYSTEM_SIZE_ALIGN - 1) / SYSTEM_SIZE_ALIGN * SYSTEM_SIZE_ALIGN;
+}
+
+scale_out::worker::worker(card* dev, int cu, size_t slots, size_t chunk_elements)
+    : dev(dev),
+      cu(cu),
+      krnl_setup_aie(dev->device, dev->xclbin_uuid, compute_unit("setup_aie", cu)),
+      krnl_sink_from_aie(dev->device, dev->xclbin_uuid, compute_unit("sink_from_aie", cu)),
+      ring(dev->device, krnl_setup_aie, krnl_sink_from_aie, slots)
+{
+    const std::vector<xrtMemoryGroup> banks_input = port_banks(krnl_setup_aie, arg_setup_aie_input);
+    const std::vector<xrtMemoryGroup> banks_output = port_banks(krnl_sink_from_aie, arg_sink_from_aie_output);
+    this->slots.reserve(slots);
+    for (size_t i = 0; i < slots; i++) {
+        this->slots.emplace_back();
+        slot& s = this->slots.back();
+        s.run_setup = xrt::run(krnl_setup_aie);
+        s.run_sink = xrt::run(krnl_sink_from_aie);
+        // with SYSTEM_MOVER_STATS every run needs its stats buffer, the counters are not read back here
+        s.stats_setup = mover_stats_buffer(dev->device, krnl_setup_aie, arg_setup_aie_stats);
+        s.stats_sink = mover_stats_buffer(dev->device, krnl_sink_from_aie, arg_sink_from_aie_stats);
+        s.stats_setup.set_arg(s.run_setup);
+        s.stats_sink.set_arg(s.run_sink);
+        s.jobs = job_table(dev->device, krnl_setup_aie, krnl_sink_from_aie, 1);
+        if (SYSTEM_FREE_RUNNING) continue;
+        s.buf_in  = striped_buffer(*dev->pool, chunk_elements, banks_input);
+        s.buf_out = striped_buffer(*dev->pool, chunk_elements, banks_output);
+        s.buf_in.set_args(s.run_setup, arg_setup_aie_input);
+        s.buf_out.set_args(s.run_sink, arg_sink_from_aie_output);
+    }
+    if (SYSTEM_FREE_RUNNING) {
+        region_words = padded_bytes(striped_buffer::slice_size(chunk_elements)) / 64;
+        const size_t capacity = region_words * slots * 64 / sizeof(data_t) * SYSTEM_MEM_PORTS;
+        shared_in  = striped_buffer(*dev->pool, capacity, banks_input);
+        shared_out = striped_buffer(*dev->pool, capacity, banks_output);
+        xrt::run run_setup(krnl_setup_aie), run_sink(krnl_sink_from_aie);
+        shared_in.set_args(run_setup, arg_setup_aie_input);
+        shared_out.set_args(run_sink, arg_sink_from_aie_output);
+        ring.start(run_setup, run_sink);
+    }
+}
+
+scale_out::scale_out(const std::string& xclbin_file, scale_out_config config) : config(config) {
+    if (SYSTEM_FRAMED_OUTPUT)
+        throw std::runtime_error("scale_out: a framed sink_from_aie has no fixed place for the output of a chunk");
+    if (this->config.inflight_chunks < 1) this->config.inflight_chunks = 1;
+    this->config.chunk_elements = beat_aligned(std::max<size_t>(this->config.chunk_elements, 1));
+    if (this->config.devices.empty())
+        for (size_t d = 0; d < xrt::system::enumerate_devices(); d++)
+            this->config.devices.push_back((int) d);
+    if (this->config.devices.empty())
+        throw std::runtime_error("scale_out: no device found");
+
+    for (int index : this->config.devices) {
+        cards.emplace_back(new card());
+        card& c = *cards.back();
+        c.index = index;
+        c.device = xrt::device(index);
+        c.xclbin_uuid = c.device.load_xclbin(xclbin_file);
+        c.graph = std::make_unique<graph_control>(c.device, c.xclbin_uuid);
+        c.pool = std::make_unique<bo_pool>(c.device);
+        for (int cu = 0; cu < SYSTEM_COMPUTE_UNITS; cu++)
+            workers.emplace_back(new worker(&c, cu, this->config.inflight_chunks, this->config.chunk_elements));
+    }
+}
+
+void scale_out::run(const std::vector<scale_out_job>& jobs) {
+    std::vector<chunk> chunks;
+    for (const scale_out_job& job : jobs)
+        for (size_t first = 0; first < job.elements; first += config.chunk_elements)
+            chunks.push_back({job.input + first, job.output + first, std::min(config.chunk_elements, job.elements - first)});
+    if (chunks.empty()) return;
+
+    // contiguous blocks, so that each unit starts on its own part of the input
+    for (size_t i = 0; i < chunks.size(); i++)
+        workers[i * workers.size() / chunks.size()]->queue.push_back(chunks[i]);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::exception_ptr> errors(workers.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers.size(); i++) {
+        threads.emplace_back([this, i, &errors] {
+            try {
+                serve(*workers[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+                // the others must not wait for the chunks of a failed unit, nor steal them
+                for (auto& w : workers) {
+                    std::lock_guard<std::mutex> lock(w->queue_mutex);
+                    w->queue.clear();
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    wall += std::chrono::steady_clock::now() - start;
+    for (const std::exception_ptr& e : errors)
+        if (e) std::rethrow_exception(e);
+}
+
+// Its own chunks in order, then the last chunk of the unit with the most left
+bool scale_out::next_chunk(worker& w, chunk& c) {
+    {
+        std::lock_guard<std::mutex> lock(w.queue_mutex);
+        if (!w.queue.empty()) {
+            c = w.queue.front();
+            w.queue.pop_front();
+            return true;
+        }
+    }
+    while (true) {
+        worker* victim = nullptr;
+        size_t most = 0;
+        for (auto& other : workers) {
+            std::lock_guard<std::mutex> lock(other->queue_mutex);
+            if (other->queue.size() > most) {
+                most = other->queue.size();
+                victim = other.get();
+            }
+        }
+        if (!victim) return false;
+        std::lock_guard<std::mutex> lock(victim->queue_mutex);
+        // it may have been emptied meanwhile, then look again
+        if (victim->queue.empty()) continue;
+        c = victim->queue.back();
+        victim->queue.pop_back();
+        w.stolen++;
+        return true;
+    }
+}
+
+// Keeps up to inflight_chunks chunks on the movers of the unit: they complete in order, so the slot of the oldest
+// is always the next one to reuse
+void scale_out::serve(worker& w) {
+    const auto start = std::chrono::steady_clock::now();
+    std::deque<slot*> inflight;
+    size_t launched = 0;
+    chunk c;
+    while (true) {
+        const bool more = inflight.size() < w.slots.size() && next_chunk(w, c);
+        if (more) {
+            slot& s = w.slots[launched++ % w.slots.size()];
+            s.work = c;
+            launch(w, s);
+            inflight.push_back(&s);
+            continue;
+        }
+        if (inflight.empty()) break;
+        complete(w, *inflight.front());
+        inflight.pop_front();
+    }
+    w.busy += std::chrono::steady_clock::now() - start;
+}
+
+void scale_out::launch(worker& w, slot& s) {
+    const size_t elements = beat_aligned(s.work.elements);
+    if (SYSTEM_JOB_DESCRIPTORS) {
+        s.jobs.clear(SYSTEM_FREE_RUNNING ? (&s - w.slots.data()) * w.region_words : 0);
+        s.jobs.add(elements);
+        striped_buffer& buf_in = SYSTEM_FREE_RUNNING ? w.shared_in : s.buf_in;
+        s.jobs.write(buf_in, 0, s.work.input, s.work.elements);
+        s.jobs.sync(buf_in, XCL_BO_SYNC_BO_TO_DEVICE);
+    } else {
+        s.buf_in.write(elements, 0, s.work.input, s.work.elements);
+        s.buf_in.clear(elements, s.work.elements, elements - s.work.elements);
+        s.buf_in.sync(XCL_BO_SYNC_BO_TO_DEVICE, elements);
+    }
+    if (SYSTEM_FREE_RUNNING) {
+        s.last_command = w.ring.post(s.jobs.descriptor(0));
+        return;
+    }
+    if (SYSTEM_JOB_DESCRIPTORS) {
+        s.jobs.set_args(s.run_setup, s.run_sink);
+    } else {
+        s.run_setup.set_arg(arg_setup_aie_size, (int32_t) elements);
+        s.run_sink.set_arg(arg_sink_from_aie_size, (int32_t) elements);
+    }
+    w.dev->graph->start_job(elements, w.cu);
+    s.run_sink.start();
+    s.run_setup.start();
+}
+
+void scale_out::complete(worker& w, slot& s) {
+    const size_t elements = beat_aligned(s.work.elements);
+    if (SYSTEM_FREE_RUNNING) {
+        w.ring.wait(s.last_command);
+        s.jobs.sync(w.shared_out, XCL_BO_SYNC_BO_FROM_DEVICE);
+        s.jobs.read(w.shared_out, 0, s.work.output, s.work.elements);
+    } else {
+        s.run_setup.wait();
+        s.run_sink.wait();
+        if (SYSTEM_JOB_DESCRIPTORS) {
+            s.buf_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE, s.jobs.capacity());
+            s.jobs.read(s.buf_out, 0, s.work.output, s.work.elements);
+        } else {
+            s.buf_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE, elements);
+            s.buf_out.read(elements, 0, s.work.output, s.work.elements);
+        }
+    }
+    w.chunks++;
+    w.elements += s.work.elements;
+}
+
+void scale_out::report(std::ostream& os) const {
+    const double seconds = std::chrono::duration<double>(wall).count();
+    if (seconds <= 0) return;
+    auto gbps = [](uint64_t elements, double t) { return t > 0 ? elements * sizeof(data_t) / t / 1e9 : 0.0; };
+    uint64_t total = 0;
+    for (const auto& c : cards) {
+        uint64_t device_elements = 0;
+        for (const auto& w : workers) {
+            if (w->dev != c.get()) continue;
+            const double busy = std::chrono::duration<double>(w->busy).count();
+            os << "device " << c->index << " cu " << w->cu << ": " << w->chunks << " chunks (" << w->stolen << " stolen), "
+               << w->elements << " elements, busy " << std::fixed << std::setprecision(1) << 100.0 * busy / seconds << "%, "
+               << std::setprecision(2) << gbps(w->elements, busy) << " GB/s" << std::defaultfloat << std::endl;
+            device_elements += w->elements;
+        }
+        os << "device " << c->index << ": " << device_elements << " elements, " << std::fixed << std::setprecision(2)
+           << gbps(device_elements, seconds) << " GB/s" << std::defaultfloat << std::endl;
+        total += device_elements;
+    }
+    os << "total: " << workers.size() << " compute units on " << cards.size() << " devices, " << std::fixed << std::setprecision(2)
+       << gbps(total, seconds) << " GB/s" << std::defaultfloat << std::endl;
+}
+
+} // namespace voted
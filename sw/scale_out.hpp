@@ -0,0 +1,157 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Scale-out of the pipeline over every compute unit of every local device. The xclbin may replicate the movers
+// (compute_units in aie/src/template_generator/kernel.cfg): every setup_aie_N/sink_from_aie_N pair then feeds its
+// own lanes of the graph from its own banks. A scale_out loads the xclbin on each device and runs one worker thread
+// per compute unit. run() cuts the jobs into chunks and deals them out in contiguous blocks, one per worker; a
+// worker keeps a few chunks in flight on its movers, and once its block is done it steals chunks from the back of
+// the others, so a slower unit or card does not hold the run back. Every chunk is read back to its own place of the
+// output, which therefore comes out in order. report() prints how busy each unit was and the bandwidth it got.
+// The dispatch mode of the xclbin (job descriptors, free-running movers, RTPs, persistent graph) is handled per
+// unit like in accelerator.hpp; a framed sink has no fixed place for the output of a chunk and is not supported.
+#ifndef SCALE_OUT_HPP
+#define SCALE_OUT_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+#include "experimental/xrt_uuid.h"
+#include "../common/constants.h"
+#include "bo_pool.hpp"
+#include "striped_buffer.hpp"
+#include "graph_control.hpp"
+#include "mover_stats.hpp"
+#include "job_table.hpp"
+#include "command_ring.hpp"
+
+namespace voted {
+
+struct scale_out_config {
+    std::vector<int> devices;        // indices of the devices to use, empty for every device found
+    size_t chunk_elements = 1 << 22; // elements of the chunks the jobs are cut into (rounded up to SYSTEM_SIZE_ALIGN)
+    int inflight_chunks = 2;         // chunks queued on the movers of a compute unit at the same time
+};
+
+// One job of run(): elements of input go through the pipeline into output, which may alias input
+struct scale_out_job {
+    const data_t* input;
+    data_t* output;
+    size_t elements;
+};
+
+class scale_out {
+public:
+    scale_out(const std::string& xclbin_file, scale_out_config config = scale_out_config());
+
+    scale_out(const scale_out&) = delete;
+    scale_out& operator=(const scale_out&) = delete;
+
+    // Runs every job on every compute unit and returns when all the output is in place. One run at a time
+    void run(const std::vector<scale_out_job>& jobs);
+    void run(const data_t* input, data_t* output, size_t elements) { run({{input, output, elements}}); }
+
+    // Chunks, steals, busy time and bandwidth of every compute unit since the construction, with the device totals
+    void report(std::ostream& os) const;
+
+    int devices() const { return (int) cards.size(); }
+    int compute_units() const { return (int) workers.size(); }
+
+private:
+    struct chunk {
+        const data_t* input;
+        data_t* output;
+        size_t elements;
+    };
+
+    // a device, with what its compute units share
+    struct card {
+        int index;
+        xrt::device device;
+        xrt::uuid xclbin_uuid;
+        std::unique_ptr<graph_control> graph;
+        std::unique_ptr<bo_pool> pool;
+    };
+
+    // a chunk on the movers of a worker
+    struct slot {
+        striped_buffer buf_in;
+        striped_buffer buf_out;
+        xrt::run run_setup;
+        xrt::run run_sink;
+        mover_stats_buffer stats_setup;
+        mover_stats_buffer stats_sink;
+        job_table jobs;
+        chunk work;
+        uint32_t last_command = 0; // with SYSTEM_FREE_RUNNING
+    };
+
+    // one compute unit of a device, served by its own thread during run()
+    struct worker {
+        card* dev;
+        int cu;
+        xrt::kernel krnl_setup_aie;
+        xrt::kernel krnl_sink_from_aie;
+        std::vector<slot> slots;
+        // with SYSTEM_FREE_RUNNING the movers serve the ring from the constructor on, on buffers where the chunk of
+        // slot i takes the words [i * region_words, (i + 1) * region_words) of every slice
+        striped_buffer shared_in;
+        striped_buffer shared_out;
+        size_t region_words = 0;
+        command_ring ring;
+
+        std::mutex queue_mutex;
+        std::deque<chunk> queue; // its own chunks from the front, stolen ones from the back
+
+        uint64_t chunks = 0;
+        uint64_t stolen = 0;
+        uint64_t elements = 0;
+        std::chrono::steady_clock::duration busy{0};
+
+        worker(card* dev, int cu, size_t slots, size_t chunk_elements);
+    };
+
+    void serve(worker& w);
+    bool next_chunk(worker& w, chunk& c);
+    void launch(worker& w, slot& s);
+    void complete(worker& w, slot& s);
+
+    scale_out_config config;
+    std::vector<std::unique_ptr<card>> cards;
+    // destroyed before the devices: the free-running movers stop, then every graph_control drains its graph
+    std::vector<std::unique_ptr<worker>> workers;
+    std::chrono::steady_clock::duration wall{0};  // of the runs
+};
+
+} // namespace voted
+
+#endif // SCALE_OUT_HPP
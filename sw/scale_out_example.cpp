@@ -0,0 +1,87 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Example of the scale-out dispatcher: one large job, sharded over every compute unit of the selected devices
+// (all of them by default), repeated a few times. Checks the output and prints the utilization of every unit.
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "scale_out.hpp"
+#include "host_utils.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <XCLBIN_PATH> [--devices I,J,...] [--size ELEMENTS] [--chunk ELEMENTS] [--runs N]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    voted::scale_out_config config;
+    size_t size = 1 << 26;
+    int runs = 3;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--devices" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            for (std::string d; std::getline(list, d, ',');) config.devices.push_back(std::stoi(d));
+        }
+        else if (arg == "--size" && i + 1 < argc) size = std::stoull(argv[++i]);
+        else if (arg == "--chunk" && i + 1 < argc) config.chunk_elements = std::stoull(argv[++i]);
+        else if (arg == "--runs" && i + 1 < argc) runs = std::stoi(argv[++i]);
+    }
+
+    std::cout << "1. Loading bitstream (" << argv[1] << ")... ";
+    voted::scale_out engine(argv[1], config);
+    std::cout << "Done, " << engine.compute_units() << " compute units on " << engine.devices() << " devices" << std::endl;
+
+    std::vector<data_t> input(size), output(size);
+    for (size_t i = 0; i < size; i++) input[i] = i;
+
+    std::cout << "2. Running " << runs << " jobs of " << size << " elements... ";
+    size_t errors = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < runs; r++) {
+        std::fill(output.begin(), output.end(), 0);
+        engine.run(input.data(), output.data(), size);
+        for (size_t i = 0; i < size; i++)
+            if (output[i] != input[i]) errors++;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Done" << std::endl;
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "Throughput (checks included): " << runs * size * sizeof(data_t) / seconds / 1e9 << " GB/s" << std::endl;
+    engine.report(std::cout);
+
+    if (errors) {
+        std::cout << "Test failed: " << errors << " wrong elements" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Test passed!" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Host buffer striped over the SYSTEM_MEM_PORTS memory ports of a mover (see common/system_config.h).
+// For a run of n elements, slice p holds the elements [p * n / SYSTEM_MEM_PORTS, (p + 1) * n / SYSTEM_MEM_PORTS)
+// at the beginning of its own bo_lease, allocated in the memory bank of port p, so every port of setup_aie and
+// sink_from_aie bursts on its own memory controller. With one port it is a single lease.
+#ifndef STRIPED_BUFFER_HPP
+#define STRIPED_BUFFER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "experimental/xrt_kernel.h"
+#include "bo_pool.hpp"
+#include "host_utils.hpp"
+
+// Memory bank of each port of a mover, whose buffer arguments start at first_arg
+inline std::vector<xrtMemoryGroup> port_banks(const xrt::kernel& kernel, int first_arg) {
+    std::vector<xrtMemoryGroup> banks;
+    for (int p = 0; p < SYSTEM_MEM_PORTS; p++) banks.push_back(kernel.group_id(first_arg + p));
+    return banks;
+}
+
+class striped_buffer {
+public:
+    striped_buffer() {}
+    // capacity: number of elements of the largest run the buffer will hold
+    striped_buffer(bo_pool& pool, size_t capacity, const std::vector<xrtMemoryGroup>& banks) {
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+            parts[p] = pool.acquire(padded_bytes(slice_size(capacity)), banks[p]);
+    }
+
+    // number of elements of each slice in a run of `elements` (a multiple of SYSTEM_SIZE_ALIGN)
+    static size_t slice_size(size_t elements) { return elements / SYSTEM_MEM_PORTS; }
+
+    data_t* slice(int p) const { return parts[p].data<data_t>(); }
+
+    // Copy n elements to or from position `offset` of a run of `elements`, splitting them across the slices
+    void write(size_t elements, size_t offset, const data_t* src, size_t n) {
+        for_each_chunk(elements, offset, n, [&](data_t* ptr, size_t done, size_t len) {
+            std::memcpy(ptr, src + done, len * sizeof(data_t));
+        });
+    }
+    void read(size_t elements, size_t offset, data_t* dst, size_t n) const {
+        for_each_chunk(elements, offset, n, [&](data_t* ptr, size_t done, size_t len) {
+            std::memcpy(dst + done, ptr, len * sizeof(data_t));
+        });
+    }
+    void clear(size_t elements, size_t offset, size_t n) {
+        for_each_chunk(elements, offset, n, [&](data_t* ptr, size_t, size_t len) {
+            std::fill(ptr, ptr + len, 0);
+        });
+    }
+
+    // Syncs the slices of a run of `elements`, each padded to whole 512-bit words
+    void sync(xclBOSyncDirection direction, size_t elements) {
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+            parts[p].bo().sync(direction, padded_bytes(slice_size(elements)), 0);
+    }
+
+    // Syncs the first counts[p] elements of every slice p, padded the same way (e.g. what each port of a framed
+    // sink_from_aie wrote, see produced_buffer.hpp)
+    void sync(xclBOSyncDirection direction, const std::vector<size_t>& counts) {
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+            if (counts[p]) parts[p].bo().sync(direction, std::min(padded_bytes(counts[p]), parts[p].bo().size()), 0);
+    }
+
+    // Syncs the 512-bit words [first_word, first_word + words) of every slice (e.g. the jobs of a job_table)
+    void sync_words(xclBOSyncDirection direction, size_t first_word, size_t words) {
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+            if (words) parts[p].bo().sync(direction, words * 64, first_word * 64);
+    }
+
+    // Passes the slices as the buffer arguments first_arg, first_arg + 1, ... of a mover
+    void set_args(xrt::run& run, int first_arg) {
+        for (int p = 0; p < SYSTEM_MEM_PORTS; p++)
+            run.set_arg(first_arg + p, parts[p].bo());
+    }
+
+private:
+    template <typename F>
+    void for_each_chunk(size_t elements, size_t offset, size_t n, F f) const {
+        const size_t slice_elements = slice_size(elements);
+        for (size_t done = 0; done < n; ) {
+            const size_t p = (offset + done) / slice_elements, o = (offset + done) % slice_elements;
+            const size_t len = std::min(n - done, slice_elements - o);
+            f(slice(p) + o, done, len);
+            done += len;
+        }
+    }
+
+    bo_lease parts[SYSTEM_MEM_PORTS];
+};
+
+#endif // STRIPED_BUFFER_HPP
@@ -0,0 +1,163 @@
+/*
+MIT License
+
+Copyright (c) 2025 Giuseppe Sorrentino, Paolo Salvatore Galfano, Davide Conficconi, Eleonora D'Arnese
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Opt-in timeline of the host runtime, written as Chrome trace JSON (open it in chrome://tracing or
+// ui.perfetto.dev). Tracing starts with tracer::get().open(file); until then every call below is a relaxed atomic
+// load and nothing is recorded. Spans are recorded on the thread that runs them, with the name of the thread
+// (trace_thread_name()), and can carry the id of the chunk, batch or request they work on. Work that goes through
+// several threads (a chunk in flight, a request waiting in a batch) is an async span, begun and ended by id.
+// The timestamps are host steady clock microseconds, so the trace works the same under hw_emu.
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class tracer {
+public:
+    static tracer& get() {
+        static tracer instance;
+        return instance;
+    }
+
+    // starts recording, the trace is written to file by close() or at exit
+    void open(const std::string& file) {
+        std::lock_guard<std::mutex> guard(mutex);
+        path = file;
+        on.store(true, std::memory_order_relaxed);
+    }
+    bool enabled() const { return on.load(std::memory_order_relaxed); }
+
+    // microseconds since the tracer was created
+    double now() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    // a span of the calling thread, from start to start + duration (microseconds); id < 0 means no id
+    void complete(const char* name, const char* category, double start, double duration, int64_t id = -1) {
+        if (!enabled()) return;
+        add("\"ph\":\"X\",\"ts\":" + std::to_string(start) + ",\"dur\":" + std::to_string(duration), name, category, id, false);
+    }
+    // begin and end of an async span, matched by name and id
+    void async_begin(const char* name, const char* category, int64_t id) {
+        if (!enabled()) return;
+        add("\"ph\":\"b\",\"ts\":" + std::to_string(now()), name, category, id, true);
+    }
+    void async_end(const char* name, const char* category, int64_t id) {
+        if (!enabled()) return;
+        add("\"ph\":\"e\",\"ts\":" + std::to_string(now()), name, category, id, true);
+    }
+    // names the calling thread in the trace
+    void thread_name(const std::string& name) {
+        if (!enabled()) return;
+        std::lock_guard<std::mutex> guard(mutex);
+        events.push_back("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + std::to_string(thread_id()) +
+                         ",\"args\":{\"name\":\"" + escape(name) + "\"}}");
+    }
+
+    // writes the trace and stops recording. Returns false if the file could not be written
+    bool close() {
+        if (!on.exchange(false)) return true;
+        std::lock_guard<std::mutex> guard(mutex);
+        std::ofstream out(path);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        for (size_t i = 0; i < events.size(); i++)
+            out << events[i] << (i + 1 < events.size() ? ",\n" : "\n");
+        out << "]}\n";
+        events.clear();
+        return out.good();
+    }
+
+    ~tracer() { close(); }
+
+private:
+    tracer() : origin(std::chrono::steady_clock::now()) {}
+
+    // small sequential thread ids, in the order threads record their first event
+    static int thread_id() {
+        static std::atomic<int> next{1};
+        thread_local int id = next++;
+        return id;
+    }
+
+    static std::string escape(const std::string& s) {
+        std::string r;
+        for (char c : s) {
+            if (c == '"' || c == '\\') r += '\\';
+            r += c;
+        }
+        return r;
+    }
+
+    void add(const std::string& timing, const char* name, const char* category, int64_t id, bool async) {
+        std::string e = "{" + timing + ",\"name\":\"" + escape(name) + "\",\"cat\":\"" + category +
+                        "\",\"pid\":1,\"tid\":" + std::to_string(thread_id());
+        if (async) e += ",\"id\":" + std::to_string(id);
+        if (id >= 0) e += ",\"args\":{\"id\":" + std::to_string(id) + "}";
+        e += "}";
+        std::lock_guard<std::mutex> guard(mutex);
+        events.push_back(std::move(e));
+    }
+
+    std::chrono::steady_clock::time_point origin;
+    std::atomic<bool> on{false};
+    std::mutex mutex;
+    std::string path;
+    std::vector<std::string> events;
+};
+
+// Records the scope it lives in as a span of the calling thread, e.g.
+//   { trace_span span("sync in", chunk); buf.sync(...); }
+// or up to end(), when the span does not match a scope
+class trace_span {
+public:
+    explicit trace_span(const char* name, int64_t id = -1, const char* category = "host")
+        : name(name), category(category), id(id), start(tracer::get().enabled() ? tracer::get().now() : 0) {}
+    ~trace_span() { end(); }
+
+    void end() {
+        tracer& t = tracer::get();
+        if (!ended && t.enabled()) t.complete(name, category, start, t.now() - start, id);
+        ended = true;
+    }
+
+    trace_span(const trace_span&) = delete;
+    trace_span& operator=(const trace_span&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    int64_t id;
+    double start;
+    bool ended = false;
+};
+
+inline void trace_thread_name(const std::string& name) { tracer::get().thread_name(name); }
+
+#endif // TRACE_HPP